@@ -0,0 +1,483 @@
+/**
+ * Native Pipeline Benchmark & Replay
+ * Runs the firmware's processing headers on the host (env:native_bench)
+ *
+ *   pio run -e native_bench -t exec
+ *   .pio/build/native_bench/program [--iters N] [capture.txt ...]
+ *
+ * Replay: every "[AS7343] ..." frame of the given serial captures (default
+ * spectral_capture.txt and final_health.txt) goes through the same chain
+ * as loop(): normalisation -> calibration -> indices -> health levels.
+ * Each stage is timed per frame. Replays run calibrated, with the dark
+ * reference set to per-channel minimum of the capture and white to its
+ * mean, so every branch of apply_spectral_calibration() is exercised.
+ * The output digest changes if an engine computes different results.
+ *
+ * Codec: BENCH_CODEC_FRAMES random reports through spectral_encode() /
+ * spectral_decode(). Channels must come back exact, indices within half a
+ * quantisation step; a failure makes the program exit non-zero.
+ *
+ * Microbenchmarks: index and health engines, CRC-16 (table and bitwise),
+ * XOR cipher, fused packet kernel, dedup lookups and deferred logging,
+ * reported in ns/op.
+ * Latencies are host numbers - use them to compare engines against each
+ * other, not as ESP32 timings.
+ */
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+#include <RHReliableDatagram.h>
+#include <vector>
+#include "lora_config.h"
+#include "lora_functions.h"
+#include "as7343_sensor.h"
+#include "as7343_agc.h"
+#include "as7343_flicker.h"
+#include "spectral_analysis.h"
+#include "spectral_reconstruct.h"
+#include "spectral_codec.h"
+#include "data_structures.h"
+#include "deferred_log.h"
+
+LoraRadio rf95(LORA_SS, LORA_DIO0);
+RHReliableDatagram manager(rf95, GATEWAY_ADDRESS);
+
+// ==========================================
+// BENCH CONFIGURATION
+// ==========================================
+
+#define BENCH_DEFAULT_ITERS  200000
+#define BENCH_REPLAY_PASSES  20         // Replays per capture (more latency samples)
+#define BENCH_CODEC_FRAMES   1000
+
+static volatile uint32_t bench_sink;    // Keeps results observable to the optimiser
+
+static inline uint64_t bench_now() {
+  return shim_nanos();
+}
+
+// Swallows formatted output, so drains are timed without stdout
+class NullPrint : public Print {
+public:
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t n) override { bench_sink += n; return n; }
+};
+
+// ==========================================
+// LATENCY STATISTICS
+// ==========================================
+
+struct Latency {
+  std::vector<uint32_t> ns;
+
+  void add(uint64_t v) { ns.push_back((uint32_t)v); }
+
+  void report(const char* name) {
+    if (ns.empty()) return;
+    std::vector<uint32_t> s(ns);
+    std::sort(s.begin(), s.end());
+    double sum = 0;
+    for (uint32_t v : s) sum += v;
+    printf("  %-14s mean %7.1f  p50 %6u  p99 %6u  max %7u ns\n", name, sum / s.size(),
+           s[s.size() / 2], s[(s.size() * 99) / 100], s.back());
+  }
+
+  double mean() const {
+    double sum = 0;
+    for (uint32_t v : ns) sum += v;
+    return ns.empty() ? 0 : sum / ns.size();
+  }
+};
+
+// ==========================================
+// CAPTURE PARSER
+// ==========================================
+
+typedef std::vector<uint16_t> Frame;   // AS7343_NUM_CHANNELS counts
+
+static const int bench_wavelengths[AS7343_NUM_CHANNELS - 1] = {
+  405, 425, 450, 475, 515, 550, 555, 600, 640, 690, 745, 855
+};
+
+/**
+ * Map a capture label to an as7343_ch[] index
+ * Current captures use the channel names exactly; older firmware printed
+ * other band centres, which go to the nearest channel still unused.
+ */
+static int bench_channel_for(const char* label, bool* used) {
+  if (strcmp(label, "CLR") == 0) return AS7343_CLEAR;
+  int nm = atoi(label);
+  if (nm <= 0) return -1;
+  int best = -1;
+  for (int i = 0; i < AS7343_NUM_CHANNELS - 1; i++) {
+    if (used[i]) continue;
+    if (best < 0 || abs(bench_wavelengths[i] - nm) < abs(bench_wavelengths[best] - nm)) best = i;
+  }
+  return best;
+}
+
+/**
+ * Parse one "[AS7343] ..." line ("label:count" tokens, "SAT" = full scale)
+ * @return false if it is not a channel line
+ */
+static bool bench_parse_line(const char* line, Frame& f, uint16_t full_scale) {
+  if (strncmp(line, "[AS7343] ", 9) != 0) return false;
+  f.assign(AS7343_NUM_CHANNELS, 0);
+  bool used[AS7343_NUM_CHANNELS] = {false};
+  int found = 0;
+
+  char buf[512];
+  strncpy(buf, line + 9, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  for (char* tok = strtok(buf, " \r\n"); tok; tok = strtok(NULL, " \r\n")) {
+    char* colon = strchr(tok, ':');
+    if (!colon || tok[0] == '#' || tok[0] == '@') continue;
+    *colon = '\0';
+    int ch = bench_channel_for(tok, used);
+    if (ch < 0) continue;
+    const char* val = colon + 1;
+    f[ch] = (strncmp(val, "SAT", 3) == 0) ? full_scale : (uint16_t)atoi(val);
+    used[ch] = true;
+    found++;
+  }
+  return found >= 8;
+}
+
+static std::vector<Frame> bench_load_capture(const char* path) {
+  std::vector<Frame> frames;
+  FILE* fh = fopen(path, "r");
+  if (!fh) {
+    printf("[REPLAY] %s: cannot open\n", path);
+    return frames;
+  }
+  uint16_t full_scale = as7343_full_scale(as7343_exposure.atime, as7343_exposure.astep);
+  char line[512];
+  Frame f;
+  while (fgets(line, sizeof(line), fh)) {
+    if (bench_parse_line(line, f, full_scale)) frames.push_back(f);
+  }
+  fclose(fh);
+  return frames;
+}
+
+// ==========================================
+// REPLAY
+// ==========================================
+
+/**
+ * Calibration references from the capture itself (min = dark, mean = white)
+ */
+static void bench_calibrate_from(const std::vector<Frame>& frames) {
+  float scale = 1.0f / (as7343_integration_ms(as7343_exposure.atime, as7343_exposure.astep) *
+                        as7343_gain_factor(as7343_exposure.gain));
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    float lo = 1e30f, sum = 0.0f;
+    for (const Frame& f : frames) {
+      float v = f[i] * scale;
+      lo = min(lo, v);
+      sum += v;
+    }
+    spectral_calibration.dark_ref[i] = lo;
+    spectral_calibration.white_ref[i] = sum / frames.size();
+  }
+  spectral_calibration.has_dark = true;
+  spectral_calibration.calibrated = true;
+  spectral_update_gains();
+}
+
+static void bench_replay(const char* path) {
+  std::vector<Frame> frames = bench_load_capture(path);
+  if (frames.empty()) {
+    printf("[REPLAY] %s: no [AS7343] frames\n", path);
+    return;
+  }
+  bench_calibrate_from(frames);
+
+  Latency norm, cal, idx, spec, health, total;
+  uint32_t levels[4][6] = {{0}};
+  uint32_t invalid = 0;
+  double digest = 0.0;
+
+  uint64_t wall0 = bench_now();
+  for (int pass = 0; pass < BENCH_REPLAY_PASSES; pass++) {
+    for (const Frame& f : frames) {
+      memcpy(as7343_ch, f.data(), sizeof(uint16_t) * AS7343_NUM_CHANNELS);
+      as7343_frame.astatus = as7343_exposure.gain;
+      as7343_frame.seq++;
+
+      uint64_t t0 = bench_now();
+      bool valid = as7343_agc_update();
+      uint64_t t1 = bench_now();
+      if (!valid) {
+        invalid++;
+        continue;
+      }
+      apply_spectral_calibration();
+      uint64_t t2 = bench_now();
+      calculate_all_indices();
+      uint64_t t3 = bench_now();
+      spectral_reconstruct_frame();
+      uint64_t t4 = bench_now();
+      calculate_health_levels();
+      uint64_t t5 = bench_now();
+
+      norm.add(t1 - t0);
+      cal.add(t2 - t1);
+      idx.add(t3 - t2);
+      spec.add(t4 - t3);
+      health.add(t5 - t4);
+      total.add(t5 - t0);
+
+      if (pass == 0) {
+        levels[0][min<uint8_t>(health_levels.vigor, 5)]++;
+        levels[1][min<uint8_t>(health_levels.chlorophyll, 5)]++;
+        levels[2][min<uint8_t>(health_levels.stress, 5)]++;
+        levels[3][min<uint8_t>(health_levels.water, 5)]++;
+        for (int i = 0; i < SPECTRAL_NUM_INDICES; i++) digest += spectral_indices[i];
+      }
+    }
+  }
+  double wall_s = (bench_now() - wall0) / 1e9;
+
+  printf("\n[REPLAY] %s: %zu frames x %d passes (%u invalid)\n", path, frames.size(),
+         BENCH_REPLAY_PASSES, invalid);
+  norm.report("normalise");
+  cal.report("calibrate");
+  idx.report("indices");
+  spec.report("spectrum");
+  health.report("health");
+  total.report("per frame");
+  printf("  throughput     %.0f frames/s (pipeline only %.0f frames/s)\n",
+         total.ns.size() / wall_s, total.mean() > 0 ? 1e9 / total.mean() : 0.0);
+
+  static const char* names[4] = {"vigor", "chlor", "stress", "water"};
+  for (int k = 0; k < 4; k++) {
+    printf("  %-6s levels", names[k]);
+    for (int l = 0; l <= 5; l++) printf(" %u:%u", l, levels[k][l]);
+    printf("\n");
+  }
+  printf("  digest         %.6e\n", digest);
+}
+
+// ==========================================
+// CODEC ROUND TRIP
+// ==========================================
+
+static uint32_t bench_rng = 0x2545F491;
+
+static uint32_t bench_rand() {
+  bench_rng ^= bench_rng << 13;            // xorshift32 - same frames on every run
+  bench_rng ^= bench_rng >> 17;
+  bench_rng ^= bench_rng << 5;
+  return bench_rng;
+}
+
+static float bench_uniform(float lo, float hi) {
+  return lo + (hi - lo) * (bench_rand() & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+/**
+ * Random reports through encode/decode. One frame in eight uses
+ * independent full-range channels (worst-case deltas), the rest a
+ * plausible spectrum shape around a random level.
+ * @return number of frames that did not round-trip
+ */
+static uint32_t bench_codec_roundtrip(uint32_t frames) {
+  uint32_t failed = 0;
+  size_t total = 0, largest = 0;
+
+  for (uint32_t n = 0; n < frames; n++) {
+    SpectralReport in, out;
+    memset(&in, 0, sizeof(in));
+    in.node_id = bench_rand() & 0xFF;
+    in.seq = bench_rand() & 0xFFFF;
+    in.gain = bench_rand() % 13;
+    in.atime = bench_rand() & 0xFF;
+    static const uint8_t mains[3] = {0, 50, 60};
+    in.mains_hz = mains[bench_rand() % 3];
+
+    float level = bench_uniform(0.0f, 30000.0f);
+    for (int i = 0; i < AS7343_NUM_CHANNELS; i++) {
+      float v = (n % 8 == 0) ? bench_uniform(0.0f, 65535.0f) : level * bench_uniform(0.5f, 1.5f);
+      in.ch[i] = (uint16_t)min(v, 65535.0f);
+    }
+    for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+      uint8_t slot = spectral_index_table[i].slot;
+      switch (spectral_index_table[i].formula) {
+        case FORMULA_NORM_DIFF: in.indices[slot] = bench_uniform(-1.0f, 1.0f); break;
+        case FORMULA_INV_DIFF:  in.indices[slot] = bench_uniform(-0.01f, 0.01f); break;
+        default:                in.indices[slot] = bench_uniform(0.0f, 10.0f); break;
+      }
+    }
+    in.indices[IDX_FLICKER_60HZ] = in.mains_hz;
+    for (int i = 0; i < 4; i++) in.health[i] = bench_rand() % 6;
+
+    uint8_t buf[MAX_PACKET_LEN];
+    size_t len = spectral_encode(&in, buf, sizeof(buf));
+    bool ok = len > 0 && spectral_decode(buf, len, &out);
+    ok = ok && out.node_id == in.node_id && out.seq == in.seq && out.gain == in.gain &&
+         out.atime == in.atime && out.mains_hz == in.mains_hz &&
+         memcmp(out.ch, in.ch, sizeof(in.ch)) == 0 && memcmp(out.health, in.health, sizeof(in.health)) == 0;
+    for (int i = 0; ok && i < SPECTRAL_NUM_INDICES; i++) {
+      float tol = (i == IDX_FLICKER_60HZ) ? 0.0f : 0.5f / spectral_codec_scale(i) * 1.001f;
+      ok = fabsf(out.indices[i] - in.indices[i]) <= tol;
+    }
+    // Every truncation must be rejected, not misread
+    for (size_t cut = 0; ok && cut < len; cut++) ok = !spectral_decode(buf, cut, &out);
+
+    if (!ok) failed++;
+    total += len;
+    if (len > largest) largest = len;
+  }
+
+  printf("\n[CODEC] %u random reports: %u failed, %.1f B average, %zu B largest\n",
+         frames, failed, frames ? (double)total / frames : 0.0, largest);
+  return failed;
+}
+
+// ==========================================
+// MICROBENCHMARKS
+// ==========================================
+
+/**
+ * Time fn over iters calls
+ * @return ns per call
+ */
+template <typename Fn>
+static double bench_op(uint32_t iters, Fn fn) {
+  for (uint32_t i = 0; i < iters / 16; i++) fn(i);   // Warm caches and branch predictors
+  uint64_t t0 = bench_now();
+  for (uint32_t i = 0; i < iters; i++) fn(i);
+  return (double)(bench_now() - t0) / iters;
+}
+
+static void bench_report(const char* name, double ns, size_t bytes = 0) {
+  if (bytes) {
+    printf("  %-30s %8.1f ns/op  %7.1f MB/s\n", name, ns, bytes / ns * 1e3);
+  } else {
+    printf("  %-30s %8.1f ns/op\n", name, ns);
+  }
+}
+
+static void bench_micro(uint32_t iters) {
+  printf("\n[MICRO] %u iterations each\n", iters);
+
+  // Index and health engines on a plausible canopy frame
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) spectral_ch[i] = 50.0f + 37.0f * i;
+  bench_report("calculate_all_indices", bench_op(iters, [](uint32_t i) {
+    spectral_ch[CH_GREEN_550] = 200.0f + (i & 63);
+    calculate_all_indices();
+    bench_sink = (uint32_t)(spectral_indices[IDX_CHLOROPHYLL] * 1000.0f);
+  }));
+  bench_report("spectral_reconstruct_frame", bench_op(iters, [](uint32_t i) {
+    spectral_ch[CH_RED_680] = 40.0f + (i & 63);
+    spectral_reconstruct_frame();
+    bench_sink = (uint32_t)(spectral_features.rep_nm * 10.0f);
+  }));
+  bench_report("calculate_health_levels", bench_op(iters, [](uint32_t i) {
+    spectral_indices[IDX_NDVI] = (float)(i & 255) / 256.0f;
+    calculate_health_levels();
+    bench_sink = health_levels.vigor;
+  }));
+
+  // Packet paths
+  static uint8_t pkt[MAX_PACKET_LEN];
+  for (size_t i = 0; i < sizeof(pkt); i++) pkt[i] = (uint8_t)(i * 37 + 11);
+  static const uint8_t sizes[] = {64, 250};
+  for (uint8_t n : sizes) {
+    char name[40];
+    snprintf(name, sizeof(name), "calculateCRC16 (%u B)", n);
+    bench_report(name, bench_op(iters, [n](uint32_t i) {
+      pkt[0] = (uint8_t)i;
+      bench_sink = calculateCRC16(pkt, n);
+    }), n);
+    snprintf(name, sizeof(name), "calculateCRC16_bitwise (%u B)", n);
+    bench_report(name, bench_op(iters / 8, [n](uint32_t i) {
+      pkt[0] = (uint8_t)i;
+      bench_sink = calculateCRC16_bitwise(pkt, n);
+    }), n);
+    snprintf(name, sizeof(name), "xor_crypt_buf (%u B)", n);
+    bench_report(name, bench_op(iters, [n](uint32_t) {
+      xor_crypt_buf(pkt, n);
+      bench_sink = pkt[n - 1];
+    }), n);
+    snprintf(name, sizeof(name), "xor_decrypt_str (%u B)", n);
+    bench_report(name, bench_op(iters / 8, [n](uint32_t) {
+      String s = xor_decrypt_str(pkt, n);
+      bench_sink = s.length();
+    }), n);
+    snprintf(name, sizeof(name), "lora_crc16_decrypt (%u B)", n);
+    bench_report(name, bench_op(iters, [n](uint32_t) {
+      bench_sink = lora_crc16_decrypt(pkt, n);   // Toggles pkt between plain and cipher
+    }), n);
+  }
+
+  // Dedup: steady state with a full ring (every insert evicts the oldest)
+  msg_dedup_clear();
+  for (uint32_t i = 0; i < DEDUP_BUFFER_SIZE; i++) msg_dedup_check_and_add(get_hash(i & 0xFF, i >> 8));
+  uint32_t next = DEDUP_BUFFER_SIZE;
+  bench_report("dedup check_and_add (new)", bench_op(iters, [&next](uint32_t) {
+    uint32_t k = next++;
+    bench_sink = msg_dedup_check_and_add(get_hash(k & 0xFF, k >> 8));
+  }));
+  bench_report("dedup check_and_add (dup)", bench_op(iters, [&next](uint32_t i) {
+    uint32_t k = next - 1 - (i % (DEDUP_BUFFER_SIZE / 2));
+    bench_sink = msg_dedup_check_and_add(get_hash(k & 0xFF, k >> 8));
+  }));
+  bench_report("dedup contains (miss)", bench_op(iters, [&next](uint32_t i) {
+    uint32_t k = next + 1 + i;
+    bench_sink = msg_dedup_contains(get_hash(k & 0xFF, k >> 8));
+  }));
+
+  // Deferred logging: the caller's cost (queue) vs the formatter's (drain), and
+  // formatting the same line in place as the old Serial.print paths did
+  NullPrint null_out;
+  uint64_t push_ns = 0, drain_ns = 0;
+  uint32_t batches = iters / (DLOG_RING_SIZE / 2);
+  for (uint32_t b = 0; b < batches; b++) {
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < DLOG_RING_SIZE / 2; i++) {
+      DLOG_VERBOSE("[LoRa RX] From: %u | Len: %u | RSSI: %d", i & 0xFF, 42u, -87);
+    }
+    uint64_t t1 = bench_now();
+    dlog_drain(null_out);
+    drain_ns += bench_now() - t1;
+    push_ns += t1 - t0;
+  }
+  uint32_t msgs = batches * (DLOG_RING_SIZE / 2);
+  bench_report("DLOG_VERBOSE (queue)", msgs ? (double)push_ns / msgs : 0.0);
+  bench_report("dlog_drain (per line)", msgs ? (double)drain_ns / msgs : 0.0);
+  bench_report("snprintf line in place", bench_op(iters, [](uint32_t i) {
+    char line[DLOG_LINE_MAX];
+    bench_sink = snprintf(line, sizeof(line), "[%lu.%03lu] [VERBOSE]: [LoRa RX] From: %u | Len: %u | RSSI: %d\r\n",
+                          (unsigned long)(i / 1000), (unsigned long)(i % 1000), i & 0xFF, 42u, -87);
+  }));
+}
+
+// ==========================================
+// ENTRY POINT
+// ==========================================
+
+int main(int argc, char** argv) {
+  uint32_t iters = BENCH_DEFAULT_ITERS;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+      iters = (uint32_t)atol(argv[++i]);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    files.push_back("spectral_capture.txt");
+    files.push_back("final_health.txt");
+  }
+
+  printf("=== Native pipeline benchmark (AGC %s) ===\n", AGC_ENABLED ? "on" : "off");
+  spectral_recon_init();                 // Once: the model matrix does not depend on calibration
+  for (const char* f : files) bench_replay(f);
+  uint32_t codec_failed = bench_codec_roundtrip(BENCH_CODEC_FRAMES);
+  bench_micro(iters);
+  lora_packet_benchmark();               // Device bench: "cycles" are ns here
+  return codec_failed ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * Host Arduino Shim
+ * Just enough of the Arduino-ESP32 core for the processing headers to
+ * build and run natively (env:native_bench)
+ *
+ * - millis()/micros() run off the host steady clock
+ * - ESP.getCycleCount() returns nanoseconds, so cycle-based benchmarks
+ *   in the headers report ns on the host
+ * - Serial prints to stdout; hardware calls are no-ops
+ */
+
+#ifndef BENCH_SHIM_ARDUINO_H
+#define BENCH_SHIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+#define RISING        0x01
+#define FALLING       0x02
+#define CHANGE        0x03
+#define DEC           10
+#define HEX           16
+
+#define digitalPinToInterrupt(p) (p)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+// ==========================================
+// TIME
+// ==========================================
+
+uint64_t shim_nanos();
+
+inline uint32_t millis() { return (uint32_t)(shim_nanos() / 1000000ULL); }
+inline uint32_t micros() { return (uint32_t)(shim_nanos() / 1000ULL); }
+inline void delay(uint32_t) {}
+inline void delayMicroseconds(uint32_t) {}
+inline void yield() {}
+
+// ==========================================
+// GPIO (no-ops)
+// ==========================================
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return LOW; }
+inline void attachInterrupt(int, void (*)(void), int) {}
+inline void detachInterrupt(int) {}
+
+// ==========================================
+// STRING
+// ==========================================
+
+class String {
+public:
+  String(const char* s = "") : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned int v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(float v, int digits = 2) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    s_ = buf;
+  }
+
+  size_t length() const { return s_.size(); }
+  const char* c_str() const { return s_.c_str(); }
+  char operator[](size_t i) const { return s_[i]; }
+  char& operator[](size_t i) { return s_[i]; }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  String operator+(const String& o) const { return String(s_ + o.s_); }
+
+  void trim() {                          // Same set as the core: isspace()
+    size_t a = 0, b = s_.size();
+    while (a < b && isspace((unsigned char)s_[a])) a++;
+    while (b > a && isspace((unsigned char)s_[b - 1])) b--;
+    s_ = s_.substr(a, b - a);
+  }
+  int indexOf(char c) const { size_t p = s_.find(c); return p == std::string::npos ? -1 : (int)p; }
+  String substring(size_t from, size_t to = std::string::npos) const {
+    return String(s_.substr(from, to == std::string::npos ? to : to - from));
+  }
+  long toInt() const { return atol(s_.c_str()); }
+  float toFloat() const { return (float)atof(s_.c_str()); }
+
+private:
+  std::string s_;
+};
+
+inline String operator+(const char* a, const String& b) { return String(a) + b; }
+
+// ==========================================
+// PRINT / SERIAL
+// ==========================================
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  virtual int availableForWrite() { return 4096; }
+  virtual void flush() {}
+
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long v, int base = DEC) { return printf_(base == HEX ? "%lX" : "%ld", v); }
+  size_t print(unsigned long v, int base = DEC) { return printf_(base == HEX ? "%lX" : "%lu", v); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(short v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned short v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(double v, int digits = 2) { return printf_("%.*f", digits, v); }
+
+  size_t println() { return print("\r\n"); }
+  template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  template <typename T> size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+  size_t printf_(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+  size_t write(const uint8_t* buf, size_t n) override { return fwrite(buf, 1, n, stdout); }
+  void flush() override { fflush(stdout); }
+  size_t setTxBufferSize(size_t n) { return n; }
+  size_t setRxBufferSize(size_t n) { return n; }
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ==========================================
+// ESP
+// ==========================================
+
+class EspClass {
+public:
+  uint32_t getCycleCount() { return (uint32_t)shim_nanos(); }
+  uint32_t getFreeHeap() { return 0; }
+  uint32_t getHeapSize() { return 0; }
+  uint32_t getMaxAllocHeap() { return 0; }
+  uint32_t getCpuFreqMHz() { return 0; }
+};
+
+extern EspClass ESP;
+
+inline bool psramFound() { return true; }
+inline void* ps_malloc(size_t n) { return malloc(n); }
+
+#endif // BENCH_SHIM_ARDUINO_H
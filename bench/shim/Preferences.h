@@ -0,0 +1,29 @@
+/**
+ * Host Preferences shim - an empty, write-discarding NVS
+ * (calibration loads find nothing, so replays run uncalibrated unless
+ * the bench sets spectral_calibration itself)
+ */
+
+#ifndef BENCH_SHIM_PREFERENCES_H
+#define BENCH_SHIM_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+  bool begin(const char*, bool read_only = false) { (void)read_only; return true; }
+  void end() {}
+  bool clear() { return true; }
+  bool remove(const char*) { return true; }
+  size_t getBytesLength(const char*) { return 0; }
+  size_t getBytes(const char*, void*, size_t) { return 0; }
+  size_t putBytes(const char*, const void*, size_t n) { return n; }
+  uint32_t getUInt(const char*, uint32_t def = 0) { return def; }
+  size_t putUInt(const char*, uint32_t) { return 4; }
+  uint8_t getUChar(const char*, uint8_t def = 0) { return def; }
+  size_t putUChar(const char*, uint8_t) { return 1; }
+  String getString(const char*, const String& def = String()) { return def; }
+  size_t putString(const char*, const char* s) { return strlen(s); }
+};
+
+#endif // BENCH_SHIM_PREFERENCES_H
@@ -0,0 +1,27 @@
+/**
+ * Host RHReliableDatagram shim
+ */
+
+#ifndef BENCH_SHIM_RH_RELIABLE_DATAGRAM_H
+#define BENCH_SHIM_RH_RELIABLE_DATAGRAM_H
+
+#include "RH_RF95.h"
+
+class RHReliableDatagram {
+public:
+  RHReliableDatagram(RH_RF95&, uint8_t) {}
+  bool init() { return true; }
+  bool available() { return false; }
+  bool sendto(uint8_t*, uint8_t, uint8_t) { return true; }
+  bool sendtoWait(uint8_t*, uint8_t, uint8_t) { return true; }
+  bool recvfromAck(uint8_t*, uint8_t*, uint8_t* from = NULL, uint8_t* to = NULL,
+                   uint8_t* id = NULL, uint8_t* flags = NULL) {
+    (void)from; (void)to; (void)id; (void)flags;
+    return false;
+  }
+  void setThisAddress(uint8_t) {}
+  void setRetries(uint8_t) {}
+  void setTimeout(uint16_t) {}
+};
+
+#endif // BENCH_SHIM_RH_RELIABLE_DATAGRAM_H
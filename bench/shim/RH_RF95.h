@@ -0,0 +1,55 @@
+/**
+ * Host RadioHead shim - a radio that never receives and sends instantly
+ */
+
+#ifndef BENCH_SHIM_RH_RF95_H
+#define BENCH_SHIM_RH_RF95_H
+
+#include "Arduino.h"
+
+#define RH_RF95_MAX_MESSAGE_LEN 251
+#define RH_RF95_HEADER_LEN      4
+
+class RHGenericDriver {
+public:
+  enum RHMode { RHModeInitialising, RHModeSleep, RHModeIdle, RHModeTx, RHModeRx, RHModeCad };
+
+protected:
+  volatile RHMode   _mode = RHModeIdle;
+  volatile uint8_t  _rxHeaderTo = 0, _rxHeaderFrom = 0, _rxHeaderId = 0, _rxHeaderFlags = 0;
+  volatile bool     _rxBufValid = false;
+  volatile int16_t  _lastRssi = 0;
+  volatile uint16_t _rxGood = 0;
+};
+
+class RH_RF95 : public RHGenericDriver {
+public:
+  RH_RF95(uint8_t ss = 0, uint8_t irq = 0) { (void)ss; (void)irq; }
+  bool init() { return true; }
+  bool available() { return false; }
+  bool recv(uint8_t*, uint8_t*) { return false; }
+  bool send(const uint8_t*, uint8_t) { return true; }
+  bool waitPacketSent(uint16_t timeout = 0) { (void)timeout; return true; }
+  bool sleep() { return true; }
+  void setModeIdle() {}
+  void setModeRx() {}
+  void setFrequency(float) {}
+  void setSpreadingFactor(uint8_t) {}
+  void setSignalBandwidth(long) {}
+  void setCodingRate4(uint8_t) {}
+  void setTxPower(int8_t, bool useRFO = false) { (void)useRFO; }
+  int16_t lastRssi() { return _lastRssi; }
+  int lastSNR() { return 0; }
+  uint8_t headerTo() { return _rxHeaderTo; }
+  uint8_t headerFrom() { return _rxHeaderFrom; }
+  uint8_t headerId() { return _rxHeaderId; }
+  uint8_t headerFlags() { return _rxHeaderFlags; }
+  void setHeaderTo(uint8_t) {}
+  void setHeaderFrom(uint8_t) {}
+  void setHeaderId(uint8_t) {}
+
+protected:
+  void handleInterrupt() {}
+};
+
+#endif // BENCH_SHIM_RH_RF95_H
@@ -0,0 +1,27 @@
+/**
+ * Host SPI shim
+ */
+
+#ifndef BENCH_SHIM_SPI_H
+#define BENCH_SHIM_SPI_H
+
+#include "Arduino.h"
+
+#define MSBFIRST  1
+#define SPI_MODE0 0
+
+struct SPISettings {
+  SPISettings(uint32_t clock = 0, uint8_t order = MSBFIRST, uint8_t mode = SPI_MODE0) { (void)clock; (void)order; (void)mode; }
+};
+
+class SPIClass {
+public:
+  void begin(int sck = -1, int miso = -1, int mosi = -1, int ss = -1) { (void)sck; (void)miso; (void)mosi; (void)ss; }
+  void beginTransaction(SPISettings) {}
+  void endTransaction() {}
+  uint8_t transfer(uint8_t) { return 0; }
+};
+
+extern SPIClass SPI;
+
+#endif // BENCH_SHIM_SPI_H
@@ -0,0 +1,26 @@
+/**
+ * Host Wire shim - no device ever answers (reads return 0)
+ */
+
+#ifndef BENCH_SHIM_WIRE_H
+#define BENCH_SHIM_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) { (void)sda; (void)scl; (void)freq; return true; }
+  bool setClock(uint32_t) { return true; }
+  void setTimeOut(uint16_t) {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool stop = true) { (void)stop; return 2; }   // NACK on address
+  uint8_t requestFrom(uint8_t, uint8_t, uint8_t stop = 1) { (void)stop; return 0; }
+  size_t write(uint8_t) override { return 1; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return 0; }
+};
+
+extern TwoWire Wire;
+
+#endif // BENCH_SHIM_WIRE_H
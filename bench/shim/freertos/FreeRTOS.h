@@ -0,0 +1,33 @@
+/**
+ * Host FreeRTOS shim - single-threaded: locks always succeed, critical
+ * sections and delays are no-ops
+ */
+
+#ifndef BENCH_SHIM_FREERTOS_H
+#define BENCH_SHIM_FREERTOS_H
+
+#include <stdint.h>
+
+typedef void*    SemaphoreHandle_t;
+typedef void*    TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define pdPASS                      1
+#define portMAX_DELAY               0xFFFFFFFFu
+#define portTICK_PERIOD_MS          1
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(ms))
+
+struct portMUX_TYPE { int unused; };
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux)     ((void)(mux))
+#define portEXIT_CRITICAL(mux)      ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)  ((void)(mux))
+
+inline void vTaskDelay(TickType_t) {}
+
+#endif // BENCH_SHIM_FREERTOS_H
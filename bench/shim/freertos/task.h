@@ -0,0 +1,17 @@
+#ifndef BENCH_SHIM_TASK_H
+#define BENCH_SHIM_TASK_H
+
+#include <stddef.h>
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+// No scheduler on the host: task creation fails, callers fall back to inline work
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*,
+                                          UBaseType_t, TaskHandle_t*, BaseType_t) { return 0; }
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return NULL; }
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+#define portYIELD_FROM_ISR()
+
+#endif // BENCH_SHIM_TASK_H
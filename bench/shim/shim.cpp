@@ -0,0 +1,41 @@
+/**
+ * Host shim globals
+ */
+
+#include <chrono>
+#include <stdarg.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "SPI.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+EspClass ESP;
+
+static const std::chrono::steady_clock::time_point shim_start = std::chrono::steady_clock::now();
+
+uint64_t shim_nanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - shim_start).count();
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, min((size_t)n, sizeof(buf) - 1));
+}
+
+size_t Print::printf_(const char* fmt, ...) {
+  char buf[64];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, min((size_t)n, sizeof(buf) - 1));
+}
@@ -1,80 +1,390 @@
 /**
  * AD7343 12-bit ADC Sensor Functions
  * Reads analog sensor data via SPI interface
+ *
+ * The ADC has its own SPI host (AD7343_SPI_HOST, HSPI) driven by the
+ * ESP-IDF master driver with DMA and hardware CS. RadioHead runs the
+ * RF95 through the Arduino SPI class on VSPI, which programs the
+ * peripheral directly, so the two cannot share one host safely; on
+ * separate hosts neither ever waits for the other.
+ *
+ * Continuous acquisition (ad7343_acq_start):
+ *   hardware timer (sample rate) -> acquisition task -> one 32-bit
+ *   transaction per sample, DMA'd straight into the filling block ->
+ *   full block queued to the consumer task -> ripple stats + hook
+ * Two blocks alternate (double buffering). If the consumer still holds
+ * the other block, the filling one is overwritten and counted as dropped.
  */
 
 #ifndef AD7343_SENSOR_H
 #define AD7343_SENSOR_H
 
 #include <Arduino.h>
-#include <SPI.h>
+#include <driver/spi_master.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_attr.h>
+#include <math.h>
 #include "lora_config.h"
+#include "spsc_queue.h"
+
+#if AD7343_CLK == LORA_SCK || AD7343_DOUT == LORA_MISO
+#error "AD7343 needs its own SPI pins - the LoRa bus belongs to the Arduino SPI driver"
+#endif
+
+// ==========================================
+// AD7343 CONFIGURATION
+// ==========================================
+
+#define AD7343_SPI_FREQ        8000000   // Hz
+#define AD7343_SPI_MODE        0
+#define AD7343_VREF            3.3f
+#define AD7343_BLOCK_SAMPLES   512       // Samples per block (both channels)
+#define AD7343_NUM_BLOCKS      2         // Double buffer (power of two)
+#define AD7343_DEFAULT_RATE_HZ 4000
+#define AD7343_MAX_RATE_HZ     20000     // One transaction per sample
+#define AD7343_ACQ_TASK_STACK  2048
+#define AD7343_ACQ_TASK_PRIO   (configMAX_PRIORITIES - 2)
+#define AD7343_ACQ_TASK_CORE   0
+#define AD7343_CONSUMER_STACK  3072
+#define AD7343_CONSUMER_PRIO   2
+#define AD7343_CONSUMER_CORE   0
 
 // ==========================================
 // AD7343 SENSOR VARIABLES
 // ==========================================
 
-// Store last sensor readings
+// Store last sensor readings (block means while acquiring)
 float ad7343_ch0_voltage = 0.0;  // Channel 0 voltage
 float ad7343_ch1_voltage = 0.0;  // Channel 1 voltage
 uint16_t ad7343_ch0_raw = 0;
 uint16_t ad7343_ch1_raw = 0;
 
+/**
+ * One shot of both channels as clocked out: two 16-bit frames, MSB first,
+ * 12-bit result in the top bits of each
+ */
+struct AD7343Block {
+  uint32_t samples[AD7343_BLOCK_SAMPLES];   // DMA target - raw big-endian frames
+  uint32_t seq;
+  uint32_t start_us;             // Timer tick of the first sample
+  uint32_t end_us;
+  uint16_t missed;               // Timer ticks skipped while filling
+};
+
+/**
+ * Per-channel summary of one block - ripple is max - min
+ */
+struct AD7343ChannelStats {
+  float mean;
+  float min;
+  float max;
+  float ripple_pp;
+  float ac_rms;                  // RMS about the mean
+};
+
+struct AD7343BlockStats {
+  AD7343ChannelStats ch[2];
+  uint32_t seq;
+  float    rate_hz;              // Measured over the block
+};
+
+struct AD7343AcqStats {
+  uint32_t samples;
+  uint32_t blocks;
+  uint32_t dropped_blocks;       // Consumer still held the other buffer
+  uint32_t missed_ticks;         // Timer fired before the previous sample finished
+  uint32_t spi_errors;
+  uint32_t max_sample_us;        // Longest single transaction
+};
+
+typedef void (*ad7343_block_fn)(const AD7343Block* block, const AD7343BlockStats* stats);
+
+DMA_ATTR AD7343Block ad7343_blocks[AD7343_NUM_BLOCKS];
+SpscQueue<uint8_t, AD7343_NUM_BLOCKS> ad7343_free;    // Consumer -> acquisition task
+SpscQueue<uint8_t, AD7343_NUM_BLOCKS> ad7343_ready;   // Acquisition task -> consumer
+AD7343AcqStats ad7343_acq_stats;
+AD7343BlockStats ad7343_last_stats;
+spi_device_handle_t ad7343_spi = NULL;
+TaskHandle_t ad7343_acq_task_handle = NULL;
+TaskHandle_t ad7343_consumer_handle = NULL;
+hw_timer_t* ad7343_timer = NULL;
+ad7343_block_fn ad7343_block_handler = NULL;
+uint32_t ad7343_rate_hz = 0;
+volatile bool ad7343_running = false;
+
 // ==========================================
 // AD7343 INITIALIZATION
 // ==========================================
 
 /**
  * Initialize AD7343 sensor
- * Configure SPI and chip select pin
+ * Configure the SPI host (DMA) and the device (hardware CS)
+ * @return true if successful
  */
-void init_ad7343() {
-  pinMode(AD7343_CS, OUTPUT);
-  digitalWrite(AD7343_CS, HIGH);  // Chip select inactive
-  
+bool init_ad7343() {
+  if (ad7343_spi) return true;
+
+  spi_bus_config_t bus;
+  memset(&bus, 0, sizeof(bus));
+  bus.mosi_io_num = AD7343_DIN;
+  bus.miso_io_num = AD7343_DOUT;
+  bus.sclk_io_num = AD7343_CLK;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = 4;
+  if (spi_bus_initialize(AD7343_SPI_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+    Serial.println("[AD7343] SPI bus init FAILED");
+    return false;
+  }
+
+  spi_device_interface_config_t dev;
+  memset(&dev, 0, sizeof(dev));
+  dev.clock_speed_hz = AD7343_SPI_FREQ;
+  dev.mode = AD7343_SPI_MODE;
+  dev.spics_io_num = AD7343_CS;          // CS framed by the peripheral
+  dev.cs_ena_pretrans = 1;
+  dev.queue_size = 1;
+  if (spi_bus_add_device(AD7343_SPI_HOST, &dev, &ad7343_spi) != ESP_OK) {
+    Serial.println("[AD7343] SPI device add FAILED");
+    spi_bus_free(AD7343_SPI_HOST);
+    return false;
+  }
+
   Serial.println("[AD7343] Initialized on GPIO" + String(AD7343_CS));
   Serial.println("  CLK: GPIO" + String(AD7343_CLK));
   Serial.println("  DIN: GPIO" + String(AD7343_DIN));
   Serial.println("  DOUT: GPIO" + String(AD7343_DOUT));
+  return true;
 }
 
 // ==========================================
 // AD7343 DATA READING
 // ==========================================
 
+inline uint16_t ad7343_frame_ch0(uint32_t frame) {
+  const uint8_t* b = (const uint8_t*)&frame;
+  return ((uint16_t)b[0] << 4) | (b[1] >> 4);
+}
+
+inline uint16_t ad7343_frame_ch1(uint32_t frame) {
+  const uint8_t* b = (const uint8_t*)&frame;
+  return ((uint16_t)b[2] << 4) | (b[3] >> 4);
+}
+
+inline float ad7343_raw_to_volts(uint16_t raw) {
+  return raw * (AD7343_VREF / 4095.0f);
+}
+
+/**
+ * Clock one 32-bit frame (channel 0 then channel 1) into dst
+ * @return true if successful
+ */
+bool ad7343_transfer(uint32_t* dst) {
+  spi_transaction_t t;
+  memset(&t, 0, sizeof(t));
+  t.flags = SPI_TRANS_USE_TXDATA;        // tx_data[] is zero: request ch0, ch1
+  t.length = 32;
+  t.rxlength = 32;
+  t.rx_buffer = dst;
+  return spi_device_polling_transmit(ad7343_spi, &t) == ESP_OK;
+}
+
 /**
  * Read both channels from AD7343
- * Performs SPI communication to read analog values
+ * Single shot; while continuous acquisition runs this returns the last
+ * block means instead
  */
 void read_ad7343() {
-  // Pull chip select low to start communication
-  digitalWrite(AD7343_CS, LOW);
-  delayMicroseconds(10);
-  
-  // Read 16-bit value (2 bytes) - MSB first
-  // First byte contains upper 8 bits + 4 control bits
-  // Second byte contains lower 4 bits + 4 zeros
-  
-  uint8_t byte1 = SPI.transfer(0x00);  // Request channel 0
-  uint8_t byte2 = SPI.transfer(0x00);
-  
-  // Combine bytes to get 12-bit value
-  ad7343_ch0_raw = ((uint16_t)byte1 << 4) | ((uint16_t)byte2 >> 4);
-  
-  // Read channel 1
-  byte1 = SPI.transfer(0x00);  // Request channel 1
-  byte2 = SPI.transfer(0x00);
-  
-  ad7343_ch1_raw = ((uint16_t)byte1 << 4) | ((uint16_t)byte2 >> 4);
-  
-  // Pull chip select high to end communication
-  digitalWrite(AD7343_CS, HIGH);
-  delayMicroseconds(10);
-  
-  // Convert to voltage (assuming 3.3V reference, 12-bit resolution)
+  if (ad7343_running || (!ad7343_spi && !init_ad7343())) return;
+
+  static DMA_ATTR uint32_t frame;
+  if (!ad7343_transfer(&frame)) {
+    ad7343_acq_stats.spi_errors++;
+    return;
+  }
+  ad7343_ch0_raw = ad7343_frame_ch0(frame);
+  ad7343_ch1_raw = ad7343_frame_ch1(frame);
+
   // ADC value 0-4095 maps to 0-3.3V
-  ad7343_ch0_voltage = (ad7343_ch0_raw / 4095.0) * 3.3;
-  ad7343_ch1_voltage = (ad7343_ch1_raw / 4095.0) * 3.3;
+  ad7343_ch0_voltage = ad7343_raw_to_volts(ad7343_ch0_raw);
+  ad7343_ch1_voltage = ad7343_raw_to_volts(ad7343_ch1_raw);
+}
+
+// ==========================================
+// CONTINUOUS ACQUISITION
+// ==========================================
+
+void IRAM_ATTR ad7343_timer_isr() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(ad7343_acq_task_handle, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+/**
+ * One sample per timer tick into the filling block; the bus stays
+ * acquired so each transaction is a polled register kick, no queueing
+ */
+void ad7343_acq_task(void* arg) {
+  (void)arg;
+  uint8_t idx = 0;
+  uint32_t n = 0;
+  uint32_t seq = 0;
+  ad7343_free.pop(&idx);
+  spi_device_acquire_bus(ad7343_spi, portMAX_DELAY);
+
+  for (;;) {
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    if (!ad7343_running) {
+      n = 0;                                      // Restart the block on the next start
+      continue;
+    }
+    if (ticks == 0) continue;
+
+    AD7343Block* b = &ad7343_blocks[idx];
+    uint32_t t0 = micros();
+    if (n == 0) {
+      b->start_us = t0;
+      b->missed = 0;
+    }
+    if (ticks > 1) {
+      b->missed += ticks - 1;
+      ad7343_acq_stats.missed_ticks += ticks - 1;
+    }
+    if (!ad7343_transfer(&b->samples[n])) {
+      ad7343_acq_stats.spi_errors++;
+      continue;
+    }
+    uint32_t dt = micros() - t0;
+    if (dt > ad7343_acq_stats.max_sample_us) ad7343_acq_stats.max_sample_us = dt;
+    ad7343_acq_stats.samples++;
+
+    if (++n < AD7343_BLOCK_SAMPLES) continue;
+    b->end_us = t0;
+    b->seq = seq++;
+    n = 0;
+
+    uint8_t next;
+    if (!ad7343_free.pop(&next)) {
+      ad7343_acq_stats.dropped_blocks++;          // Refill the same block
+      continue;
+    }
+    ad7343_ready.push(idx);                       // Cannot fail - only NUM_BLOCKS exist
+    xTaskNotifyGive(ad7343_consumer_handle);
+    idx = next;
+  }
+}
+
+/**
+ * Ripple statistics for both channels of one block
+ */
+void ad7343_block_stats(const AD7343Block* b, AD7343BlockStats* s) {
+  for (uint8_t c = 0; c < 2; c++) {
+    uint32_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint16_t lo = 0xFFFF, hi = 0;
+    for (uint32_t i = 0; i < AD7343_BLOCK_SAMPLES; i++) {
+      uint16_t v = c ? ad7343_frame_ch1(b->samples[i]) : ad7343_frame_ch0(b->samples[i]);
+      sum += v;
+      sum_sq += (uint32_t)v * v;
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+    }
+    float mean = (float)sum / AD7343_BLOCK_SAMPLES;
+    float var = (float)sum_sq / AD7343_BLOCK_SAMPLES - mean * mean;
+    AD7343ChannelStats* cs = &s->ch[c];
+    cs->mean = mean * (AD7343_VREF / 4095.0f);
+    cs->min = ad7343_raw_to_volts(lo);
+    cs->max = ad7343_raw_to_volts(hi);
+    cs->ripple_pp = cs->max - cs->min;
+    cs->ac_rms = (var > 0 ? sqrtf(var) : 0) * (AD7343_VREF / 4095.0f);
+  }
+  s->seq = b->seq;
+  uint32_t span = b->end_us - b->start_us;
+  s->rate_hz = span ? (AD7343_BLOCK_SAMPLES - 1) * 1e6f / span : 0;
+}
+
+void ad7343_consumer_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    uint8_t idx;
+    while (ad7343_ready.pop(&idx)) {
+      AD7343Block* b = &ad7343_blocks[idx];
+      AD7343BlockStats s;
+      ad7343_block_stats(b, &s);
+      if (ad7343_block_handler) ad7343_block_handler(b, &s);
+
+      uint32_t last = b->samples[AD7343_BLOCK_SAMPLES - 1];
+      ad7343_free.push(idx);
+
+      ad7343_last_stats = s;
+      ad7343_ch0_raw = ad7343_frame_ch0(last);
+      ad7343_ch1_raw = ad7343_frame_ch1(last);
+      ad7343_ch0_voltage = s.ch[0].mean;
+      ad7343_ch1_voltage = s.ch[1].mean;
+      ad7343_acq_stats.blocks++;
+    }
+  }
+}
+
+/**
+ * Called from the consumer task with every full block (keep it short -
+ * the acquisition side has one spare buffer)
+ */
+void ad7343_set_block_handler(ad7343_block_fn fn) {
+  ad7343_block_handler = fn;
+}
+
+/**
+ * Start timer-paced continuous sampling
+ * @return true if successful
+ */
+bool ad7343_acq_start(uint32_t rate_hz = AD7343_DEFAULT_RATE_HZ) {
+  if (ad7343_running) return true;
+  if (!init_ad7343()) return false;
+  if (rate_hz == 0) rate_hz = 1;
+  if (rate_hz > AD7343_MAX_RATE_HZ) rate_hz = AD7343_MAX_RATE_HZ;
+
+  if (!ad7343_acq_task_handle) {
+    for (uint8_t i = 0; i < AD7343_NUM_BLOCKS; i++) ad7343_free.push(i);
+    if (xTaskCreatePinnedToCore(ad7343_consumer_task, "ad7343_use", AD7343_CONSUMER_STACK, NULL,
+                                AD7343_CONSUMER_PRIO, &ad7343_consumer_handle, AD7343_CONSUMER_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(ad7343_acq_task, "ad7343_acq", AD7343_ACQ_TASK_STACK, NULL,
+                                AD7343_ACQ_TASK_PRIO, &ad7343_acq_task_handle, AD7343_ACQ_TASK_CORE) != pdPASS) {
+      Serial.println("[AD7343] Task creation FAILED");
+      return false;
+    }
+  }
+
+  ad7343_rate_hz = rate_hz;
+  ad7343_running = true;
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+  ad7343_timer = timerBegin(1000000);              // 1 MHz tick
+  timerAttachInterrupt(ad7343_timer, ad7343_timer_isr);
+  timerAlarm(ad7343_timer, 1000000 / rate_hz, true, 0);
+#else
+  ad7343_timer = timerBegin(0, 80, true);          // 80 MHz APB / 80 = 1 MHz tick
+  timerAttachInterrupt(ad7343_timer, ad7343_timer_isr, true);
+  timerAlarmWrite(ad7343_timer, 1000000 / rate_hz, true);
+  timerAlarmEnable(ad7343_timer);
+#endif
+
+  Serial.print("[AD7343] Continuous sampling at ");
+  Serial.print(rate_hz);
+  Serial.print(" Hz, ");
+  Serial.print(AD7343_BLOCK_SAMPLES);
+  Serial.println("-sample blocks");
+  return true;
+}
+
+void ad7343_acq_stop() {
+  if (!ad7343_running) return;
+  ad7343_running = false;
+  timerEnd(ad7343_timer);
+  ad7343_timer = NULL;
 }
 
 /**
@@ -108,4 +418,22 @@ void print_ad7343_data() {
   Serial.println(")");
 }
 
+/**
+ * Print acquisition counters and the last block's ripple figures
+ */
+void print_ad7343_acq_stats() {
+  const AD7343BlockStats* s = &ad7343_last_stats;
+  Serial.printf("\n[AD7343] %s, target %lu Hz, measured %.1f Hz\n",
+                ad7343_running ? "Sampling" : "Stopped", (unsigned long)ad7343_rate_hz, s->rate_hz);
+  Serial.printf("  Samples: %lu | Blocks: %lu | Dropped: %lu | Missed ticks: %lu | SPI errors: %lu | Max xfer: %lu us\n",
+                (unsigned long)ad7343_acq_stats.samples, (unsigned long)ad7343_acq_stats.blocks,
+                (unsigned long)ad7343_acq_stats.dropped_blocks, (unsigned long)ad7343_acq_stats.missed_ticks,
+                (unsigned long)ad7343_acq_stats.spi_errors, (unsigned long)ad7343_acq_stats.max_sample_us);
+  for (uint8_t c = 0; c < 2; c++) {
+    const AD7343ChannelStats* cs = &s->ch[c];
+    Serial.printf("  CH%u: mean %.3fV  min %.3fV  max %.3fV  ripple %.1f mVpp  AC %.2f mVrms\n", c,
+                  cs->mean, cs->min, cs->max, cs->ripple_pp * 1000.0f, cs->ac_rms * 1000.0f);
+  }
+}
+
 #endif // AD7343_SENSOR_H
@@ -0,0 +1,191 @@
+/**
+ * AS7343 Auto-Gain / Auto-Integration Controller
+ * Steps AGAIN and ATIME between frames so every channel stays inside
+ * the ADC range, and normalises counts to counts/ms/gain
+ */
+
+#ifndef AS7343_AGC_H
+#define AS7343_AGC_H
+
+#include <Arduino.h>
+#include "as7343_sensor.h"
+
+// ==========================================
+// AGC CONFIGURATION
+// ==========================================
+
+#ifndef AGC_ENABLED
+#define AGC_ENABLED 1             // 0 = fixed exposure (normalisation only)
+#endif
+
+// Peak thresholds as a fraction of ADC full scale. One step doubles or
+// halves exposure, so the gap between them (> 2x) is the hysteresis band
+#define AGC_HIGH_THRESHOLD 0.80f   // Step down above 80% of full scale
+#define AGC_LOW_THRESHOLD  0.15f   // Step up below 15% of full scale
+
+#define AGC_SETTLE_FRAMES 1        // Frames discarded after a register change
+
+#define AGC_GAIN_MIN       0       // 0.5x
+#define AGC_GAIN_MAX       10      // 512x
+#define AGC_GAIN_PREFERRED 5       // 16x - raise gain to here before lengthening integration
+
+// Integration ladder (ATIME values at AS7343_DEFAULT_ASTEP) - each rung
+// doubles the integration time
+const uint8_t agc_atime_ladder[] = {0, 1, 3, 7, 15, 31, 63, 127};
+#define AGC_TIME_STEPS (sizeof(agc_atime_ladder) / sizeof(agc_atime_ladder[0]))
+#define AGC_DEFAULT_TIME_IDX 4     // agc_atime_ladder[4] == AS7343_DEFAULT_ATIME
+
+// ==========================================
+// AGC STATE
+// ==========================================
+
+struct AS7343AgcState {
+  uint8_t  time_idx;      // Position in agc_atime_ladder
+  uint8_t  settle;        // Frames left to discard after a change
+  bool     saturated;     // Last frame hit the ADC or analog limit
+  float    peak_level;    // Last frame peak / full scale (0.0 - 1.0)
+  uint32_t adjustments;   // Exposure changes since boot
+  uint32_t discarded;     // Frames dropped (settling or saturated)
+};
+
+AS7343AgcState as7343_agc = {AGC_DEFAULT_TIME_IDX, 0, false, 0.0f, 0, 0};
+
+// Channels normalised to counts per ms of integration per unit gain, so
+// values stay comparable across every AGC setting
+float as7343_norm[AS7343_NUM_CHANNELS] = {0};
+
+// ==========================================
+// AGC STEPPING
+// ==========================================
+
+/**
+ * ATIME for a ladder rung at the programmed ASTEP
+ * The ladder is designed for AS7343_DEFAULT_ASTEP. A longer step (flicker
+ * alignment) gets proportionally fewer steps, so each rung keeps its
+ * integration time to the nearest whole step.
+ */
+uint8_t agc_rung_atime(uint8_t time_idx, uint16_t astep) {
+  uint32_t ticks = ((uint32_t)agc_atime_ladder[time_idx] + 1) * (AS7343_DEFAULT_ASTEP + 1);  // 2.78us units
+  uint32_t steps = (ticks + (astep + 1) / 2) / ((uint32_t)astep + 1);
+  if (steps < 1) steps = 1;
+  if (steps > 256) steps = 256;
+  return (uint8_t)(steps - 1);
+}
+
+/**
+ * Move the integration rung towards more (dir > 0) or less exposure,
+ * skipping rungs that round to the current ATIME at this ASTEP
+ * @return true if a rung with a different ATIME was found
+ */
+bool agc_step_time(uint8_t* time_idx, int dir) {
+  uint8_t atime = agc_rung_atime(*time_idx, as7343_exposure.astep);
+  for (int idx = *time_idx + dir; idx >= 0 && idx < (int)AGC_TIME_STEPS; idx += dir) {
+    if (agc_rung_atime(idx, as7343_exposure.astep) != atime) {
+      *time_idx = idx;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Move one rung along the exposure ladder
+ * Ladder order (increasing exposure): gain up to AGC_GAIN_PREFERRED at
+ * short integration, then longer integration, then the remaining gain.
+ * Bright scenes therefore get the shortest integration (highest frame rate).
+ * @param up true for more exposure, false for less
+ * @return true if the exposure changed
+ */
+bool as7343_agc_step(bool up) {
+  uint8_t gain = as7343_exposure.gain;
+  uint8_t time_idx = as7343_agc.time_idx;
+
+  if (up) {
+    if (gain < AGC_GAIN_PREFERRED) gain++;
+    else if (!agc_step_time(&time_idx, +1) && gain < AGC_GAIN_MAX) gain++;
+  } else {
+    if (gain > AGC_GAIN_PREFERRED) gain--;
+    else if (!agc_step_time(&time_idx, -1) && gain > AGC_GAIN_MIN) gain--;
+  }
+
+  if (gain == as7343_exposure.gain && time_idx == as7343_agc.time_idx) {
+    return false;  // Already at the end of the ladder
+  }
+
+  as7343_agc.time_idx = time_idx;
+  as7343_set_exposure(gain, agc_rung_atime(time_idx, as7343_exposure.astep), as7343_exposure.astep);
+  as7343_agc.adjustments++;
+  return true;
+}
+
+/**
+ * Run the AGC on the frame just read by read_as7343()
+ * Normalises the frame into as7343_norm[] and schedules the next exposure.
+ * @return true if the frame is valid for downstream processing
+ *         (false while settling after a change, or if saturated)
+ */
+bool as7343_agc_update() {
+  if (as7343_agc.settle > 0) {
+    // Frame straddled an exposure change - counts are not trustworthy
+    as7343_agc.settle--;
+    as7343_agc.discarded++;
+    return false;
+  }
+
+  uint16_t full_scale = as7343_full_scale(as7343_exposure.atime, as7343_exposure.astep);
+  uint16_t peak = 0;
+  for (int i = 0; i < AS7343_NUM_CHANNELS; i++) {
+    if (as7343_ch[i] > peak) peak = as7343_ch[i];
+  }
+
+  as7343_agc.peak_level = (float)peak / full_scale;
+  as7343_agc.saturated = (as7343_frame.astatus & AS7343_ASTATUS_ASAT) || (peak >= full_scale);
+
+  // ASTATUS reports the gain the latched data was actually taken with
+  uint8_t frame_gain = as7343_frame.astatus & 0x0F;
+  float scale = 1.0f / (as7343_integration_ms(as7343_exposure.atime, as7343_exposure.astep) *
+                        as7343_gain_factor(frame_gain));
+  for (int i = 0; i < AS7343_NUM_CHANNELS; i++) {
+    as7343_norm[i] = as7343_ch[i] * scale;
+  }
+
+#if AGC_ENABLED
+  bool changed = false;
+  if (as7343_agc.saturated) {
+    // True level is unknown above full scale - back off two rungs
+    changed = as7343_agc_step(false);
+    changed = as7343_agc_step(false) || changed;
+  } else if (as7343_agc.peak_level > AGC_HIGH_THRESHOLD) {
+    changed = as7343_agc_step(false);
+  } else if (as7343_agc.peak_level < AGC_LOW_THRESHOLD) {
+    changed = as7343_agc_step(true);
+  }
+  if (changed) as7343_agc.settle = AGC_SETTLE_FRAMES;
+#endif
+
+  if (as7343_agc.saturated) {
+    as7343_agc.discarded++;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Print AGC state
+ * (defaults to the live state; the pipeline passes its frame copy)
+ */
+void print_as7343_agc(const AS7343AgcState& agc = as7343_agc,
+                      const AS7343Exposure& exposure = as7343_exposure) {
+  Serial.print("[AGC] Gain:");
+  Serial.print(as7343_gain_factor(exposure.gain), 1);
+  Serial.print("x Tint:");
+  Serial.print(as7343_integration_ms(exposure.atime, exposure.astep), 1);
+  Serial.print("ms Peak:");
+  Serial.print(agc.peak_level * 100.0f, 0);
+  Serial.print("% Adj:");
+  Serial.print(agc.adjustments);
+  Serial.print(" Drop:");
+  Serial.println(agc.discarded);
+}
+
+#endif // AS7343_AGC_H
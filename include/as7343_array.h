@@ -0,0 +1,440 @@
+/**
+ * AS7343 Sensor Array
+ * Per-instance AS7343 driver behind a TCA9548A I2C mux, with a pipelined
+ * round-robin scheduler
+ *
+ * Every AS7343 answers at 0x39, so each sits on its own mux channel. A
+ * round starts integration on every sensor back to back (one register
+ * write each), then polls each sensor only once its exposure is due and
+ * reads it out while the others are still integrating. A round therefore
+ * takes about one integration period plus N burst reads (~1 ms each at
+ * 400 kHz), instead of N integration periods for sequential reads.
+ *
+ * Frames leave through as7343_array_frames (an SpscQueue), each tagged
+ * with the sensor's position, so the scheduler can move into its own
+ * task without changing consumers.
+ *
+ * In array mode every AS7343 must be behind the mux: one left on the root
+ * bus would answer together with the selected channel.
+ */
+
+#ifndef AS7343_ARRAY_H
+#define AS7343_ARRAY_H
+
+#include <Arduino.h>
+#include "lora_config.h"
+#include "i2c_bus.h"
+#include "as7343_sensor.h"
+#include "spsc_queue.h"
+#include "deferred_log.h"
+
+// ==========================================
+// ARRAY CONFIGURATION
+// ==========================================
+
+#define AS7343_ARRAY_MAX        8      // TCA9548A has 8 channels
+#define AS7343_ARRAY_QUEUE      16     // Frames waiting for the consumer (power of two)
+#define AS7343_ARRAY_POLL_MS    2      // Re-poll AVALID this often once a sensor is due
+#define AS7343_ARRAY_SMUX_MS    2      // Auto-SMUX reconfiguration between the 3 passes
+#define AS7343_ARRAY_TIMEOUT_MS 100    // Beyond the expected exposure before giving up
+#define AS7343_ARRAY_PERIOD_MS  0      // Minimum time between round starts (0 = back to back)
+
+// Mux channels populated by default; each sensor's position is its index here
+const uint8_t as7343_array_default_channels[] = {0, 1, 2, 3};
+
+// ==========================================
+// TCA9548A I2C MUX
+// ==========================================
+
+#define TCA9548A_NONE 0xFF
+
+uint8_t tca9548a_selected = TCA9548A_NONE;   // Cached selection (one register write saved per op)
+
+/**
+ * Route the downstream channel to the bus (caller holds the bus)
+ * @return true if the mux ACKed
+ */
+bool tca9548a_select(uint8_t channel) {
+  if (channel == tca9548a_selected) return true;
+  uint8_t mask = 1 << channel;
+  if (!i2c_bus_write(TCA9548A_I2C_ADDRESS, I2C_PRIO_SENSOR, &mask, 1)) {
+    tca9548a_selected = TCA9548A_NONE;
+    return false;
+  }
+  tca9548a_selected = channel;
+  return true;
+}
+
+// ==========================================
+// PER-INSTANCE DRIVER
+// ==========================================
+
+enum AS7343DevState : uint8_t {
+  AS7343_DEV_OFFLINE = 0,    // Not found or failed init
+  AS7343_DEV_IDLE,           // Powered, not measuring
+  AS7343_DEV_INTEGRATING,    // SP_EN set, waiting for due_ms
+  AS7343_DEV_DONE            // Frame read (or timed out) this round
+};
+
+struct AS7343Device {
+  uint8_t  mux_channel;
+  uint8_t  position;             // Caller's tag (canopy slot)
+  uint8_t  state;                // AS7343DevState
+  AS7343Exposure exposure;
+  AS7343Frame frame;
+  uint16_t ch[AS7343_NUM_CHANNELS];
+  uint32_t start_ms;             // Integration started
+  uint32_t due_ms;               // Next AVALID poll
+  uint32_t deadline_ms;          // Give up after this
+  uint32_t polls;                // AVALID reads that were not ready yet
+  uint32_t errors;               // I2C failures
+  uint32_t timeouts;
+};
+
+/**
+ * One frame from one sensor, as queued for the consumer
+ */
+struct AS7343ArrayFrame {
+  uint8_t  sensor;               // Index in as7343_array.dev[]
+  uint8_t  position;
+  uint8_t  astatus;
+  uint8_t  gain;
+  uint8_t  atime;
+  uint16_t astep;
+  uint32_t round;
+  uint32_t seq;                  // Per-sensor frame count
+  uint32_t timestamp_ms;
+  uint16_t ch[AS7343_NUM_CHANNELS];
+};
+
+bool as7343_dev_write_reg(AS7343Device* dev, uint8_t reg, uint8_t value) {
+  uint8_t buf[2] = {reg, value};
+  if (!i2c_bus_acquire(I2C_PRIO_SENSOR)) return false;
+  bool ok = tca9548a_select(dev->mux_channel) &&
+            i2c_bus_write(AS7343_I2C_ADDRESS, I2C_PRIO_SENSOR, buf, 2);
+  i2c_bus_release();
+  if (!ok) dev->errors++;
+  return ok;
+}
+
+bool as7343_dev_read_block(AS7343Device* dev, uint8_t reg, uint8_t* buf, uint8_t len) {
+  if (!i2c_bus_acquire(I2C_PRIO_SENSOR)) return false;
+  bool ok = tca9548a_select(dev->mux_channel) &&
+            i2c_bus_write_read(AS7343_I2C_ADDRESS, I2C_PRIO_SENSOR, reg, buf, len);
+  i2c_bus_release();
+  if (!ok) dev->errors++;
+  return ok;
+}
+
+/**
+ * Program gain and integration time (only changed registers)
+ * Call while the device is idle - it applies from the next round.
+ */
+void as7343_dev_set_exposure(AS7343Device* dev, uint8_t gain, uint8_t atime, uint16_t astep) {
+  if (gain != dev->exposure.gain) as7343_dev_write_reg(dev, AS7343_GAIN, gain & 0x1F);
+  if (atime != dev->exposure.atime) as7343_dev_write_reg(dev, AS7343_ATIME, atime);
+  if (astep != dev->exposure.astep) {
+    as7343_dev_write_reg(dev, AS7343_ASTEP_L, astep & 0xFF);
+    as7343_dev_write_reg(dev, AS7343_ASTEP_H, astep >> 8);
+  }
+  dev->exposure.gain = gain;
+  dev->exposure.atime = atime;
+  dev->exposure.astep = astep;
+}
+
+/**
+ * Time one 18-channel auto-SMUX measurement takes (ms, rounded up)
+ */
+uint32_t as7343_dev_measure_ms(const AS7343Device* dev) {
+  float pass = as7343_integration_ms(dev->exposure.atime, dev->exposure.astep);
+  return (uint32_t)(3 * pass + 0.999f) + 3 * AS7343_ARRAY_SMUX_MS;
+}
+
+/**
+ * Probe and configure one sensor (same setup as init_as7343(), left idle)
+ * @return true if the sensor answered
+ */
+bool as7343_dev_init(AS7343Device* dev) {
+  dev->state = AS7343_DEV_OFFLINE;
+  if (!i2c_bus_acquire(I2C_PRIO_SENSOR)) return false;
+  bool found = tca9548a_select(dev->mux_channel) && i2c_bus_probe(AS7343_I2C_ADDRESS) == 0;
+  i2c_bus_release();
+  if (!found) return false;
+
+  as7343_dev_write_reg(dev, AS7343_ENABLE, AS7343_ENABLE_PON);
+  delay(1);
+  as7343_dev_write_reg(dev, AS7343_GAIN, AS7343_DEFAULT_GAIN);
+  as7343_dev_write_reg(dev, AS7343_ATIME, AS7343_DEFAULT_ATIME);
+  as7343_dev_write_reg(dev, AS7343_ASTEP_L, AS7343_DEFAULT_ASTEP & 0xFF);
+  as7343_dev_write_reg(dev, AS7343_ASTEP_H, AS7343_DEFAULT_ASTEP >> 8);
+  as7343_dev_write_reg(dev, AS7343_CFG0, 0x00);                  // REG_BANK = 0
+  as7343_dev_write_reg(dev, AS7343_CFG20, AS7343_CFG20_SMUX_18CH);
+  as7343_dev_write_reg(dev, AS7343_STATUS, 0xFF);
+  dev->exposure.gain = AS7343_DEFAULT_GAIN;
+  dev->exposure.atime = AS7343_DEFAULT_ATIME;
+  dev->exposure.astep = AS7343_DEFAULT_ASTEP;
+  if (dev->errors) return false;
+
+  dev->state = AS7343_DEV_IDLE;
+  return true;
+}
+
+/**
+ * Start one measurement (SP_EN) - returns immediately
+ */
+bool as7343_dev_start(AS7343Device* dev, uint32_t now) {
+  if (!as7343_dev_write_reg(dev, AS7343_ENABLE, AS7343_ENABLE_PON | AS7343_ENABLE_SP_EN)) return false;
+  uint32_t measure = as7343_dev_measure_ms(dev);
+  dev->start_ms = now;
+  dev->due_ms = now + measure;
+  dev->deadline_ms = now + measure + AS7343_ARRAY_TIMEOUT_MS;
+  dev->state = AS7343_DEV_INTEGRATING;
+  return true;
+}
+
+/**
+ * Read the frame if AVALID is set, then stop measuring until the next round
+ * @return true if a fresh frame is in dev->ch
+ */
+bool as7343_dev_read(AS7343Device* dev, uint32_t now) {
+  uint8_t status2 = 0;
+  if (!as7343_dev_read_block(dev, AS7343_STATUS2, &status2, 1)) return false;
+  if (!(status2 & AS7343_STATUS2_AVALID)) {
+    dev->polls++;
+    return false;
+  }
+
+  uint8_t raw[AS7343_BURST_LEN];
+  if (!as7343_dev_read_block(dev, AS7343_ASTATUS, raw, AS7343_BURST_LEN)) return false;
+  as7343_dev_write_reg(dev, AS7343_ENABLE, AS7343_ENABLE_PON);   // Stop: rounds stay aligned
+  as7343_dev_write_reg(dev, AS7343_STATUS, 0xFF);
+  as7343_decode_frame(raw, dev->ch);
+
+  dev->frame.interval_ms = (dev->frame.seq > 0) ? (now - dev->frame.timestamp_ms) : 0;
+  dev->frame.timestamp_ms = now;
+  dev->frame.astatus = raw[0];
+  dev->frame.seq++;
+  return true;
+}
+
+// ==========================================
+// ARRAY SCHEDULER
+// ==========================================
+
+struct AS7343ArrayStats {
+  uint32_t rounds;
+  uint32_t frames;
+  uint32_t dropped;              // Consumer queue full
+  uint32_t last_round_ms;
+  uint32_t max_round_ms;
+  uint32_t sequential_ms;        // Sum of measurement times - what one-by-one reads would take
+  uint32_t max_readout_us;       // Slowest AVALID + burst read
+};
+
+struct AS7343Array {
+  AS7343Device dev[AS7343_ARRAY_MAX];
+  uint8_t  count;
+  uint8_t  pending;              // Devices still integrating this round
+  bool     running;
+  uint32_t round;
+  uint32_t round_start_ms;
+  AS7343ArrayStats stats;
+};
+
+AS7343Array as7343_array;
+SpscQueue<AS7343ArrayFrame, AS7343_ARRAY_QUEUE> as7343_array_frames;
+
+/**
+ * Register a sensor (before as7343_array_init())
+ * @param mux_channel TCA9548A channel 0-7
+ * @param position    tag carried by every frame of this sensor
+ * @return sensor index, or -1 if the array is full
+ */
+int as7343_array_add(uint8_t mux_channel, uint8_t position) {
+  if (as7343_array.count >= AS7343_ARRAY_MAX || mux_channel > 7) return -1;
+  AS7343Device* dev = &as7343_array.dev[as7343_array.count];
+  memset(dev, 0, sizeof(*dev));
+  dev->mux_channel = mux_channel;
+  dev->position = position;
+  return as7343_array.count++;
+}
+
+/**
+ * Probe the mux and configure every registered sensor (the default
+ * channel table if none were added)
+ * @return number of sensors online
+ */
+uint8_t as7343_array_init() {
+  if (as7343_array.count == 0) {
+    for (uint8_t i = 0; i < sizeof(as7343_array_default_channels); i++) {
+      as7343_array_add(as7343_array_default_channels[i], i);
+    }
+  }
+
+  if (i2c_bus_probe(TCA9548A_I2C_ADDRESS) != 0) {
+    Serial.println("[ARRAY] TCA9548A not responding");
+    return 0;
+  }
+
+  uint8_t online = 0;
+  for (uint8_t i = 0; i < as7343_array.count; i++) {
+    AS7343Device* dev = &as7343_array.dev[i];
+    bool ok = as7343_dev_init(dev);
+    Serial.print("[ARRAY] Sensor ");
+    Serial.print(i);
+    Serial.print(" (mux ");
+    Serial.print(dev->mux_channel);
+    Serial.print(", position ");
+    Serial.print(dev->position);
+    Serial.println(ok ? ") ready" : ") NOT FOUND");
+    if (ok) online++;
+  }
+  as7343_array.running = online > 0;
+  return online;
+}
+
+/**
+ * Start a measurement on every idle sensor
+ */
+void as7343_array_start_round(uint32_t now) {
+  as7343_array.round++;
+  as7343_array.round_start_ms = now;
+  as7343_array.pending = 0;
+  uint32_t sequential = 0;
+
+  for (uint8_t i = 0; i < as7343_array.count; i++) {
+    AS7343Device* dev = &as7343_array.dev[i];
+    if (dev->state == AS7343_DEV_OFFLINE) continue;
+    if (as7343_dev_start(dev, now)) {
+      as7343_array.pending++;
+      sequential += as7343_dev_measure_ms(dev);
+    } else {
+      dev->state = AS7343_DEV_DONE;
+    }
+  }
+  as7343_array.stats.sequential_ms = sequential;
+}
+
+void as7343_array_publish(uint8_t index) {
+  AS7343Device* dev = &as7343_array.dev[index];
+  AS7343ArrayFrame f;
+  f.sensor = index;
+  f.position = dev->position;
+  f.astatus = dev->frame.astatus;
+  f.gain = dev->exposure.gain;
+  f.atime = dev->exposure.atime;
+  f.astep = dev->exposure.astep;
+  f.round = as7343_array.round;
+  f.seq = dev->frame.seq;
+  f.timestamp_ms = dev->frame.timestamp_ms;
+  memcpy(f.ch, dev->ch, sizeof(f.ch));
+  if (as7343_array_frames.push(f)) {
+    as7343_array.stats.frames++;
+  } else {
+    as7343_array.stats.dropped++;
+  }
+}
+
+/**
+ * Advance the scheduler - non-blocking, call as often as possible
+ * Reads every sensor whose measurement is due, and starts the next round
+ * once all have reported.
+ * @return number of frames queued by this call
+ */
+uint8_t as7343_array_poll() {
+  if (!as7343_array.running) return 0;
+  uint32_t now = millis();
+
+  if (as7343_array.pending == 0) {
+#if AS7343_ARRAY_PERIOD_MS > 0
+    if (as7343_array.round > 0 && now - as7343_array.round_start_ms < AS7343_ARRAY_PERIOD_MS) return 0;
+#endif
+    as7343_array_start_round(now);
+    return 0;
+  }
+
+  uint8_t queued = 0;
+  for (uint8_t i = 0; i < as7343_array.count; i++) {
+    AS7343Device* dev = &as7343_array.dev[i];
+    if (dev->state != AS7343_DEV_INTEGRATING || (int32_t)(now - dev->due_ms) < 0) continue;
+
+    uint32_t t0 = micros();
+    if (as7343_dev_read(dev, now)) {
+      uint32_t us = micros() - t0;
+      if (us > as7343_array.stats.max_readout_us) as7343_array.stats.max_readout_us = us;
+      as7343_array_publish(i);
+      dev->state = AS7343_DEV_DONE;
+      queued++;
+    } else if ((int32_t)(now - dev->deadline_ms) >= 0) {
+      as7343_dev_write_reg(dev, AS7343_ENABLE, AS7343_ENABLE_PON);
+      dev->timeouts++;
+      dev->state = AS7343_DEV_DONE;
+      DLOG_WARN("[ARRAY] Sensor %u timed out (round %lu)", i, (unsigned long)as7343_array.round);
+    } else {
+      dev->due_ms = now + AS7343_ARRAY_POLL_MS;
+      continue;
+    }
+
+    if (--as7343_array.pending == 0) {
+      uint32_t round_ms = millis() - as7343_array.round_start_ms;
+      as7343_array.stats.last_round_ms = round_ms;
+      if (round_ms > as7343_array.stats.max_round_ms) as7343_array.stats.max_round_ms = round_ms;
+      as7343_array.stats.rounds++;
+      for (uint8_t j = 0; j < as7343_array.count; j++) {
+        if (as7343_array.dev[j].state == AS7343_DEV_DONE) as7343_array.dev[j].state = AS7343_DEV_IDLE;
+      }
+    }
+  }
+  return queued;
+}
+
+/**
+ * Print one queued frame
+ */
+void print_as7343_array_frame(const AS7343ArrayFrame* f) {
+  Serial.print("[ARRAY] pos ");
+  Serial.print(f->position);
+  Serial.print(" round ");
+  Serial.print(f->round);
+  Serial.print(" @");
+  Serial.print(f->timestamp_ms);
+  Serial.print("ms ");
+  for (int i = 0; i < AS7343_NUM_CHANNELS; i++) {
+    Serial.print(as7343_names[i]);
+    Serial.print(":");
+    Serial.print(f->ch[i]);
+    if (i < AS7343_NUM_CHANNELS - 1) Serial.print(" ");
+  }
+  if (f->astatus & AS7343_ASTATUS_ASAT) Serial.print(" [⚠ saturated]");
+  Serial.println();
+}
+
+void print_as7343_array_stats() {
+  AS7343ArrayStats* s = &as7343_array.stats;
+  Serial.println("\n[Sensor Array]");
+  Serial.print("  Rounds: ");
+  Serial.print(s->rounds);
+  Serial.print("  Frames: ");
+  Serial.print(s->frames);
+  Serial.print("  Dropped: ");
+  Serial.println(s->dropped);
+  Serial.print("  Round: ");
+  Serial.print(s->last_round_ms);
+  Serial.print(" ms (max ");
+  Serial.print(s->max_round_ms);
+  Serial.print(") vs ");
+  Serial.print(s->sequential_ms);
+  Serial.print(" ms sequential, slowest readout ");
+  Serial.print(s->max_readout_us);
+  Serial.println(" us");
+  for (uint8_t i = 0; i < as7343_array.count; i++) {
+    AS7343Device* dev = &as7343_array.dev[i];
+    Serial.printf("  [%u] mux %u pos %u %-7s frames %lu polls %lu errors %lu timeouts %lu\n",
+                  i, dev->mux_channel, dev->position,
+                  dev->state == AS7343_DEV_OFFLINE ? "offline" : "online",
+                  (unsigned long)dev->frame.seq, (unsigned long)dev->polls,
+                  (unsigned long)dev->errors, (unsigned long)dev->timeouts);
+  }
+}
+
+#endif // AS7343_ARRAY_H
@@ -0,0 +1,164 @@
+/**
+ * AS7343 Flicker Detection
+ * Runs the sensor's flicker-detect (FD) engine, reports 50/60 Hz mains
+ * ripple and optionally aligns integration to whole ripple periods
+ *
+ * With alignment on, ASTEP is set to one ripple period (10 ms at 50 Hz,
+ * 8.33 ms at 60 Hz), so every rung of the AGC ATIME ladder integrates a
+ * whole number of periods and grow-light ripple cancels instead of
+ * adding frame-to-frame noise. ATIME is rescaled with the step, so each
+ * rung keeps its integration time to the nearest period - only rungs
+ * shorter than one period get longer.
+ */
+
+#ifndef AS7343_FLICKER_H
+#define AS7343_FLICKER_H
+
+#include <Arduino.h>
+#include "as7343_sensor.h"
+#include "as7343_agc.h"
+#include "deferred_log.h"
+
+// ==========================================
+// FLICKER CONFIGURATION
+// ==========================================
+
+#define FLICKER_ENABLED           1
+#define FLICKER_ALIGN_INTEGRATION 1     // Lock ASTEP to the detected ripple period
+
+#define FLICKER_FD_TIME  359            // (FD_TIME + 1) x 2.78us = 1 ms per FD sample
+#define FLICKER_FD_GAIN  7              // AGAIN-style code (64x), stepped down on FD saturation
+#define FLICKER_CONFIRM  2              // Consecutive identical results before switching
+
+// ASTEP values giving one ripple period per integration step
+#define FLICKER_ASTEP_100HZ 3596        // 3597 x 2.78us = 10.00 ms
+#define FLICKER_ASTEP_120HZ 2997        // 2998 x 2.78us =  8.33 ms
+
+// ==========================================
+// FLICKER STATE
+// ==========================================
+
+struct AS7343FlickerState {
+  uint8_t  mains_hz;          // Confirmed mains frequency: 0 (none), 50 or 60
+  uint8_t  candidate_hz;      // Latest raw result awaiting confirmation
+  uint8_t  confirm;           // Consecutive frames agreeing with candidate_hz
+  uint8_t  fd_gain;           // FD gain currently programmed
+  uint8_t  last_status;       // Last FD_STATUS read
+  uint32_t measurements;      // Valid FD results since boot
+  uint32_t saturations;       // FD saturation events
+};
+
+AS7343FlickerState as7343_flicker = {0, 0, 0, FLICKER_FD_GAIN, 0, 0, 0};
+
+// Mirrors as7343_flicker.mains_hz for spectral_analysis.h
+uint8_t as7343_mains_hz = 0;
+
+// ==========================================
+// FLICKER FUNCTIONS
+// ==========================================
+
+void as7343_flicker_set_gain(uint8_t gain) {
+  as7343_write_reg(AS7343_FD_TIME_2, (gain << 3) | ((FLICKER_FD_TIME >> 8) & 0x07));
+  as7343_flicker.fd_gain = gain;
+}
+
+/**
+ * Configure and enable the FD engine (call after init_as7343())
+ */
+void as7343_flicker_init() {
+#if FLICKER_ENABLED
+  if (!as7343_ready) return;
+
+  // FD configuration is written with measurements stopped
+  uint8_t enable = as7343_read_reg(AS7343_ENABLE);
+  as7343_write_reg(AS7343_ENABLE, AS7343_ENABLE_PON);
+  as7343_write_reg(AS7343_FD_TIME, FLICKER_FD_TIME & 0xFF);
+  as7343_flicker_set_gain(FLICKER_FD_GAIN);
+  as7343_write_reg(AS7343_FD_STATUS, 0x3C);   // Clear stale results
+  as7343_write_reg(AS7343_ENABLE, enable | AS7343_ENABLE_FDEN);
+
+  Serial.println("[FLICKER] Detection enabled (50/60 Hz)");
+#endif
+}
+
+/**
+ * Program ASTEP for the confirmed mains frequency
+ * Falls back to the power-on ASTEP when no ripple is present, so daylight
+ * keeps the short integration steps.
+ */
+void as7343_flicker_align() {
+#if FLICKER_ALIGN_INTEGRATION
+  uint16_t astep = AS7343_DEFAULT_ASTEP;
+  if (as7343_flicker.mains_hz == 50) astep = FLICKER_ASTEP_100HZ;
+  if (as7343_flicker.mains_hz == 60) astep = FLICKER_ASTEP_120HZ;
+
+  if (astep != as7343_exposure.astep) {
+    // Same integration time in the new step size
+    as7343_set_exposure(as7343_exposure.gain, agc_rung_atime(as7343_agc.time_idx, astep), astep);
+    as7343_agc.settle = AGC_SETTLE_FRAMES;    // Frame in flight used the old step
+    as7343_agc.adjustments++;
+  }
+#endif
+}
+
+/**
+ * Read the FD result once per frame and update the mains estimate
+ * @return confirmed mains frequency (0, 50 or 60)
+ */
+uint8_t as7343_flicker_update() {
+#if FLICKER_ENABLED
+  uint8_t status = as7343_read_reg(AS7343_FD_STATUS);
+  as7343_flicker.last_status = status;
+  if (!(status & AS7343_FD_STATUS_VALID)) return as7343_flicker.mains_hz;
+
+  as7343_write_reg(AS7343_FD_STATUS, 0x3C);   // Acknowledge this result
+
+  if (status & AS7343_FD_STATUS_SAT) {
+    // Ripple amplitude unknown - back the FD gain off and retry
+    as7343_flicker.saturations++;
+    if (as7343_flicker.fd_gain > 0) as7343_flicker_set_gain(as7343_flicker.fd_gain - 1);
+    return as7343_flicker.mains_hz;
+  }
+
+  uint8_t hz = 0;
+  if ((status & AS7343_FD_STATUS_100HZ_VALID) && (status & AS7343_FD_STATUS_100HZ)) hz = 50;
+  else if ((status & AS7343_FD_STATUS_120HZ_VALID) && (status & AS7343_FD_STATUS_120HZ)) hz = 60;
+  as7343_flicker.measurements++;
+
+  // Debounce - lighting changes are rare, a single odd result is noise
+  if (hz == as7343_flicker.candidate_hz) {
+    if (as7343_flicker.confirm < FLICKER_CONFIRM) as7343_flicker.confirm++;
+  } else {
+    as7343_flicker.candidate_hz = hz;
+    as7343_flicker.confirm = 1;
+  }
+
+  if (as7343_flicker.confirm >= FLICKER_CONFIRM && hz != as7343_flicker.mains_hz) {
+    as7343_flicker.mains_hz = hz;
+    as7343_mains_hz = hz;
+    if (hz) DLOG_INFO("[FLICKER] Mains ripple: %u Hz", hz);
+    else DLOG_INFO("[FLICKER] Mains ripple: none");
+    as7343_flicker_align();
+  }
+#endif
+  return as7343_flicker.mains_hz;
+}
+
+/**
+ * Print flicker state
+ * (defaults to the live state; the pipeline passes its frame copy)
+ */
+void print_as7343_flicker(const AS7343FlickerState& flicker = as7343_flicker) {
+  Serial.print("[FLICKER] Mains:");
+  Serial.print(flicker.mains_hz);
+  Serial.print("Hz FD_STATUS:0x");
+  Serial.print(flicker.last_status, HEX);
+  Serial.print(" FDgain:");
+  Serial.print(flicker.fd_gain);
+  Serial.print(" Meas:");
+  Serial.print(flicker.measurements);
+  Serial.print(" Sat:");
+  Serial.println(flicker.saturations);
+}
+
+#endif // AS7343_FLICKER_H
@@ -1,5 +1,5 @@
 /**
- * AS7343 11-Channel Spectral Sensor Functions
+ * AS7343 12-Channel Spectral Sensor Functions
  * Measures light intensity across visible and near-infrared wavelengths
  * I2C interface
  */
@@ -9,6 +9,10 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "i2c_bus.h"
+#include "boot_profiler.h"
 #include "lora_config.h"
 
 // ==========================================
@@ -19,25 +23,213 @@
 #define AS7343_ENABLE 0x80
 #define AS7343_ATIME 0x81
 #define AS7343_WTIME 0x83
-#define AS7343_GAIN 0x8A        // Gain control
-#define AS7343_FD_TIME 0x8E     // Flick detection time
-#define AS7343_STATUS 0x93
+#define AS7343_GAIN 0xC6        // CFG1 - AGAIN (bits 4:0)
+#define AS7343_FD_TIME 0xE0     // FD_TIME_1 - flicker integration time [7:0]
+#define AS7343_FD_TIME_2 0xE2   // FD_GAIN (bits 7:3) + flicker integration time [10:8]
+#define AS7343_FD_STATUS 0xE3   // Flicker detection result (write 1 to clear bits 5:2)
+#define AS7343_STATUS2 0x90     // AVALID (bit 6) + saturation flags
+#define AS7343_STATUS 0x93      // Interrupt status (write 1 to clear)
 #define AS7343_CONFIG 0x8D      // Channel configuration
-#define AS7343_DATA_START 0x95  // Start of 12 channel data registers
-#define AS7343_BANK 0xAC        // Register bank selection (to access red/NIR)
+#define AS7343_ASTATUS 0x94     // Saturation + gain status (reading latches DATA_0..17)
+#define AS7343_DATA_START 0x95  // Start of 18 channel data registers (DATA_0_L)
+#define AS7343_CFG0 0xBF        // REG_BANK (bit 4) - 0 selects registers 0x80 and up
+#define AS7343_PERS 0xCF        // Interrupt persistence (0 = every cycle)
+#define AS7343_ASTEP_L 0xD4     // Integration step size, low byte
+#define AS7343_ASTEP_H 0xD5     // Integration step size, high byte
+#define AS7343_CFG20 0xD6       // auto_smux mode (bits 6:5)
+#define AS7343_INTENAB 0xF9     // Interrupt enables
+
+// Register bits
+#define AS7343_ENABLE_PON     0x01  // Power on
+#define AS7343_ENABLE_SP_EN   0x02  // Spectral measurement enable
+#define AS7343_ENABLE_FDEN    0x40  // Flicker detection enable
+#define AS7343_STATUS2_AVALID 0x40  // Spectral data valid (cleared on data read)
+#define AS7343_STATUS_AINT    0x08  // Spectral measurement complete
+#define AS7343_INTENAB_SP_IEN 0x08  // Drive INT low when a spectral cycle completes
+#define AS7343_ASTATUS_ASAT   0x80  // Analog or digital saturation in this frame
+#define AS7343_CFG20_SMUX_18CH 0x60 // Auto-cycle 3 SMUX passes per measurement
+#define AS7343_FD_STATUS_VALID     0x20  // Flicker measurement complete
+#define AS7343_FD_STATUS_SAT       0x10  // Flicker ADC saturated
+#define AS7343_FD_STATUS_120HZ_VALID 0x08
+#define AS7343_FD_STATUS_100HZ_VALID 0x04
+#define AS7343_FD_STATUS_120HZ     0x02  // 120 Hz ripple (60 Hz mains) detected
+#define AS7343_FD_STATUS_100HZ     0x01  // 100 Hz ripple (50 Hz mains) detected
+
+// Integration time = (ATIME + 1) x (ASTEP + 1) x 2.78us per SMUX pass
+#define AS7343_STEP_US 2.78f
+
+// Power-on exposure (the AGC in as7343_agc.h takes over from here)
+#define AS7343_DEFAULT_GAIN  1     // 1x
+#define AS7343_DEFAULT_ATIME 15    // 16 steps
+#define AS7343_DEFAULT_ASTEP 999   // 2.78ms per step -> ~44ms per pass
+
+// 18-channel auto-SMUX readout: ASTATUS + 18 x 16-bit data in one burst
+#define AS7343_NUM_RAW 18
+#define AS7343_BURST_LEN (1 + 2 * AS7343_NUM_RAW)
+
+// If no INT edge arrives within this window, fall back to polling AVALID
+// (covers a missed edge while INT is still latched low)
+#define AS7343_INT_TIMEOUT_MS 250
 
 // ==========================================
 // AS7343 SENSOR VARIABLES
 // ==========================================
 
-// Store spectral channel readings (11 channels + clear)
-uint16_t as7343_ch[12] = {0};  // Channels: 415nm, 445nm, 480nm, 510nm, 545nm, 580nm, 610nm, 645nm, 680nm, 705nm, 940nm, Clear
+/**
+ * Fixed channel order of as7343_ch[] - ascending wavelength, clear last
+ */
+enum AS7343Channel {
+  AS7343_F1_405   = 0,
+  AS7343_F2_425   = 1,
+  AS7343_FZ_450   = 2,
+  AS7343_F3_475   = 3,
+  AS7343_F4_515   = 4,
+  AS7343_F5_550   = 5,
+  AS7343_FY_555   = 6,
+  AS7343_FXL_600  = 7,
+  AS7343_F6_640   = 8,
+  AS7343_F7_690   = 9,
+  AS7343_F8_745   = 10,
+  AS7343_NIR_855  = 11,
+  AS7343_CLEAR    = 12,  // VIS photodiode, averaged over the 3 SMUX passes
+  AS7343_NUM_CHANNELS
+};
+
+/**
+ * Burst register order in 18-channel auto-SMUX mode (DATA_0..DATA_17):
+ *   Pass 1:  0 FZ   1 FY   2 FXL  3 NIR  4 VIS  5 FD
+ *   Pass 2:  6 F2   7 F3   8 F4   9 F6  10 VIS 11 FD
+ *   Pass 3: 12 F1  13 F7  14 F8  15 F5  16 VIS 17 FD
+ * Maps each raw slot to its as7343_ch[] index (FD slots are skipped, the
+ * flicker ADC has its own status register).
+ */
+#define AS7343_RAW_SKIP 0xFF
+const uint8_t as7343_smux_map[AS7343_NUM_RAW] = {
+  AS7343_FZ_450, AS7343_FY_555, AS7343_FXL_600, AS7343_NIR_855, AS7343_CLEAR, AS7343_RAW_SKIP,
+  AS7343_F2_425, AS7343_F3_475, AS7343_F4_515,  AS7343_F6_640,  AS7343_CLEAR, AS7343_RAW_SKIP,
+  AS7343_F1_405, AS7343_F7_690, AS7343_F8_745,  AS7343_F5_550,  AS7343_CLEAR, AS7343_RAW_SKIP
+};
+
+// Store spectral channel readings (12 bands + clear, see AS7343Channel)
+uint16_t as7343_ch[AS7343_NUM_CHANNELS] = {0};
 
 // Channel names
-const char* as7343_names[] = {"415", "445", "480", "510", "545", "580", "610", "645", "680", "705", "940", "CLR"};
+const char* as7343_names[AS7343_NUM_CHANNELS] = {
+  "405", "425", "450", "475", "515", "550", "555", "600", "640", "690", "745", "855", "CLR"
+};
 
 bool as7343_ready = false;
 
+/**
+ * Metadata of the most recent frame in as7343_ch[]
+ */
+struct AS7343Frame {
+  uint32_t seq;           // Increments once per fresh frame
+  uint32_t timestamp_ms;  // millis() when data-ready was observed
+  uint32_t interval_ms;   // Time since the previous frame
+  uint8_t  astatus;       // ASTATUS latched with the data (ASAT + gain)
+};
+
+AS7343Frame as7343_frame = {0, 0, 0, 0};
+
+/**
+ * Exposure currently programmed into the sensor
+ */
+struct AS7343Exposure {
+  uint8_t  gain;   // AGAIN code: 0 = 0.5x, 1 = 1x, 2 = 2x ... 12 = 2048x
+  uint8_t  atime;  // Integration steps - 1
+  uint16_t astep;  // Step size - 1 (in 2.78us units)
+};
+
+AS7343Exposure as7343_exposure = {AS7343_DEFAULT_GAIN, AS7343_DEFAULT_ATIME, AS7343_DEFAULT_ASTEP};
+
+// Set by the INT pin ISR, cleared when the frame is read
+volatile bool as7343_int_pending = false;
+uint32_t as7343_last_int_check = 0;
+TaskHandle_t as7343_notify_task = NULL;   // Woken by the INT pin ISR (acquisition stage)
+
+// ==========================================
+// AS7343 REGISTER ACCESS
+// ==========================================
+
+// All transfers go through the shared bus manager at sensor priority
+
+void as7343_write_reg(uint8_t reg, uint8_t value) {
+  uint8_t buf[2] = {reg, value};
+  i2c_bus_write(AS7343_I2C_ADDRESS, I2C_PRIO_SENSOR, buf, 2);
+}
+
+uint8_t as7343_read_reg(uint8_t reg) {
+  uint8_t value = 0;
+  if (!i2c_bus_write_read(AS7343_I2C_ADDRESS, I2C_PRIO_SENSOR, reg, &value, 1)) return 0;
+  return value;
+}
+
+/**
+ * Read a block of consecutive registers in one I2C transaction
+ * @return true if all bytes arrived
+ */
+bool as7343_read_block(uint8_t reg, uint8_t* buf, uint8_t len) {
+  return i2c_bus_write_read(AS7343_I2C_ADDRESS, I2C_PRIO_SENSOR, reg, buf, len);
+}
+
+/**
+ * Program gain and integration time, writing only the registers that change
+ * Takes effect from the next integration cycle.
+ */
+void as7343_set_exposure(uint8_t gain, uint8_t atime, uint16_t astep) {
+  if (gain != as7343_exposure.gain) {
+    as7343_write_reg(AS7343_GAIN, gain & 0x1F);
+  }
+  if (atime != as7343_exposure.atime) {
+    as7343_write_reg(AS7343_ATIME, atime);
+  }
+  if (astep != as7343_exposure.astep) {
+    as7343_write_reg(AS7343_ASTEP_L, astep & 0xFF);
+    as7343_write_reg(AS7343_ASTEP_H, astep >> 8);
+  }
+  as7343_exposure.gain = gain;
+  as7343_exposure.atime = atime;
+  as7343_exposure.astep = astep;
+}
+
+/**
+ * Gain multiplier for an AGAIN code (0 = 0.5x, then doubling)
+ */
+float as7343_gain_factor(uint8_t gain) {
+  if (gain == 0) return 0.5f;
+  return (float)(1UL << (gain - 1));
+}
+
+/**
+ * Integration time of one SMUX pass in milliseconds
+ */
+float as7343_integration_ms(uint8_t atime, uint16_t astep) {
+  return (atime + 1) * ((uint32_t)astep + 1) * AS7343_STEP_US / 1000.0f;
+}
+
+/**
+ * ADC full-scale count for an exposure: (ATIME+1) x (ASTEP+1), max 65535
+ */
+uint16_t as7343_full_scale(uint8_t atime, uint16_t astep) {
+  uint32_t fs = (uint32_t)(atime + 1) * ((uint32_t)astep + 1);
+  return (fs > 65535) ? 65535 : (uint16_t)fs;
+}
+
+/**
+ * INT pin handler - AS7343 pulls INT low when a spectral cycle completes
+ */
+void IRAM_ATTR as7343_isr() {
+  as7343_int_pending = true;
+  if (as7343_notify_task) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(as7343_notify_task, &woken);
+    if (woken) {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
+
 // ==========================================
 // AS7343 INITIALIZATION
 // ==========================================
@@ -50,10 +242,7 @@ void scan_i2c_bus() {
   int found = 0;
   
   for (int addr = 1; addr < 127; addr++) {
-    Wire.beginTransmission(addr);
-    int error = Wire.endTransmission();
-    
-    if (error == 0) {
+    if (i2c_bus_probe(addr) == 0) {
       Serial.print("[I2C] FOUND at 0x");
       Serial.print(addr, HEX);
       
@@ -73,103 +262,108 @@ void scan_i2c_bus() {
 
 void init_as7343() {
   Serial.println("\n[AS7343] ===== INITIALIZATION START =====");
-  Serial.flush();
+  BOOT_FLUSH();
   
   // First, verify I2C bus is working by checking OLED
   Serial.print("[I2C] Checking if OLED is present at 0x3C... ");
-  Serial.flush();
-  Wire.beginTransmission(0x3C);
-  if (Wire.endTransmission() == 0) {
+  BOOT_FLUSH();
+  if (i2c_bus_probe(0x3C) == 0) {
     Serial.println("YES (I2C bus working)");
   } else {
     Serial.println("NO (I2C bus may not be working)");
   }
-  Serial.flush();
+  BOOT_FLUSH();
   
   Serial.println("[AS7343] Attempting to initialize spectral sensor...");
-  Serial.flush();
-  delay(100);
+  BOOT_FLUSH();
+  BOOT_DELAY(100);
   
   // Try multiple times at 0x39
   for (int attempt = 1; attempt <= 3; attempt++) {
     Serial.print("[AS7343] Attempt ");
     Serial.print(attempt);
     Serial.print("/3: Querying 0x39... ");
-    Serial.flush();
+    BOOT_FLUSH();
     
-    Wire.beginTransmission(AS7343_I2C_ADDRESS);
-    int error = Wire.endTransmission();
+    int error = i2c_bus_probe(AS7343_I2C_ADDRESS);
     
     if (error == 0) {
       as7343_ready = true;
       Serial.println("SUCCESS!");
       Serial.println("[AS7343] Spectral Sensor Initialized");
       Serial.println("  I2C Address: 0x39");
-      Serial.println("  Channels: 415, 445, 480, 510, 545, 580, 610, 645, 680, 705, 940nm + Clear");
-      Serial.flush();
+      Serial.println("  Channels: 405, 425, 450, 475, 515, 550, 555, 600, 640, 690, 745, 855nm + Clear");
+      BOOT_FLUSH();
       
       // Configure AS7343 for measurement
       Serial.println("[AS7343] Configuring measurement mode...");
-      Serial.flush();
+      BOOT_FLUSH();
       
       // Step 1: Power on and enable AEN (ADC Enable)
-      Wire.beginTransmission(AS7343_I2C_ADDRESS);
-      Wire.write(AS7343_ENABLE);
-      Wire.write(0x01);  // POWER_ON (bit 0)
-      Wire.endTransmission();
+      as7343_write_reg(AS7343_ENABLE, 0x01);  // POWER_ON (bit 0)
+#if FAST_START
+      delayMicroseconds(200);                 // PON -> register access minimum
+#else
       delay(10);
+#endif
       
-      // Step 2: Set integration time (ATIME) - very short to prevent saturation
-      // 0x00 = 2.78ms, 0x10 = ~11ms, 0xFF = 711ms
-      // Using 0x10 (~11ms) to avoid saturation
-      Wire.beginTransmission(AS7343_I2C_ADDRESS);
-      Wire.write(AS7343_ATIME);
-      Wire.write(0x10);  // ~11ms integration time
-      Wire.endTransmission();
-      delay(10);
+      // Step 2-3: Power-on gain and integration time - the AGC adjusts
+      // these per frame once measurements are running
+      as7343_write_reg(AS7343_GAIN, AS7343_DEFAULT_GAIN);
+      as7343_write_reg(AS7343_ATIME, AS7343_DEFAULT_ATIME);
+      as7343_write_reg(AS7343_ASTEP_L, AS7343_DEFAULT_ASTEP & 0xFF);
+      as7343_write_reg(AS7343_ASTEP_H, AS7343_DEFAULT_ASTEP >> 8);
+      as7343_exposure.gain = AS7343_DEFAULT_GAIN;
+      as7343_exposure.atime = AS7343_DEFAULT_ATIME;
+      as7343_exposure.astep = AS7343_DEFAULT_ASTEP;
+      BOOT_DELAY(10);
       
-      // Step 3: Set GAIN for better sensitivity but avoid saturation
-      // 0 = 0.5x, 1 = 1x, 2 = 2x, 3 = 4x, 4 = 8x, 5 = 16x, 6 = 32x, 7 = 64x, 8 = 128x, 9 = 256x
-      // Using 1x (gain = 1) for minimal amplification with fast 11ms sampling
-      Wire.beginTransmission(AS7343_I2C_ADDRESS);
-      Wire.write(AS7343_GAIN);
-      Wire.write(0x01);  // 1x gain - minimal to prevent saturation
-      Wire.endTransmission();
-      delay(10);
-      
-      // Step 4: Configure channel bank to measure all wavelengths
-      Wire.beginTransmission(AS7343_I2C_ADDRESS);
-      Wire.write(AS7343_BANK);
-      Wire.write(0x00);  // Bank 0 for normal measurement
-      Wire.endTransmission();
-      delay(10);
+      // Step 4: Auto-cycle all three SMUX passes so one measurement covers
+      // every channel (no bank switching, one coherent frame)
+      as7343_write_reg(AS7343_CFG0, 0x00);  // REG_BANK = 0
+      as7343_write_reg(AS7343_CFG20, AS7343_CFG20_SMUX_18CH);
+      BOOT_DELAY(10);
       
       // Step 5: Enable measurement mode (AEN)
-      Wire.beginTransmission(AS7343_I2C_ADDRESS);
-      Wire.write(AS7343_ENABLE);
-      Wire.write(0x03);  // POWER_ON + AEN (measurement enable)
-      Wire.endTransmission();
-      delay(100);  // Wait for first measurement
+      as7343_write_reg(AS7343_ENABLE, 0x03);  // POWER_ON + AEN (measurement enable)
+      
+      // Step 6: Data-ready signalling - interrupt on every completed cycle
+      as7343_write_reg(AS7343_PERS, 0x00);
+      as7343_write_reg(AS7343_STATUS, 0xFF);  // Clear any stale interrupt
+#if AS7343_INT_PIN >= 0
+      as7343_write_reg(AS7343_INTENAB, AS7343_INTENAB_SP_IEN);
+      pinMode(AS7343_INT_PIN, INPUT);  // Open-drain, pull-up on breakout board
+      attachInterrupt(digitalPinToInterrupt(AS7343_INT_PIN), as7343_isr, FALLING);
+      Serial.print("[AS7343] Data-ready on INT pin GPIO");
+      Serial.println(AS7343_INT_PIN);
+#else
+      Serial.println("[AS7343] Data-ready by AVALID polling (no INT pin)");
+#endif
+      as7343_last_int_check = millis();
       
-      Serial.println("[AS7343] Fast-sampling mode enabled (1x gain, 11ms integration)");
+      Serial.print("[AS7343] Measurement running (");
+      Serial.print(as7343_gain_factor(as7343_exposure.gain), 1);
+      Serial.print("x gain, ");
+      Serial.print(as7343_integration_ms(as7343_exposure.atime, as7343_exposure.astep), 1);
+      Serial.println("ms per SMUX pass)");
       Serial.println("[AS7343] ===== INITIALIZATION SUCCESS =====\n");
-      Serial.flush();
+      BOOT_FLUSH();
       return;
     } else {
       Serial.print("FAILED (error=");
       Serial.print(error);
       Serial.println(")");
-      Serial.flush();
+      BOOT_FLUSH();
       delay(200);
     }
   }
   
   as7343_ready = false;
   Serial.println("\n[AS7343] NOT RESPONDING at 0x39 - scanning I2C bus...");
-  Serial.flush();
+  BOOT_FLUSH();
   scan_i2c_bus();
   Serial.println("[AS7343] ===== INITIALIZATION FAILED =====\n");
-  Serial.flush();
+  BOOT_FLUSH();
 }
 
 // ==========================================
@@ -177,105 +371,129 @@ void init_as7343() {
 // ==========================================
 
 /**
- * Read all 12 channels from AS7343 with bank switching for red/NIR
- * Bank 0: 415, 445, 480, 510, 545, 580, 610, 645, 680, 705nm
- * Bank 1: 610, 645, 680, 705, 910, 940nm (red and NIR)
+ * Check whether a fresh frame is waiting in the sensor
+ * Uses the INT pin flag when wired, otherwise polls AVALID.
+ * Non-blocking - call as often as possible from loop().
+ * @return true if read_as7343() should be called
  */
-void read_as7343() {
-  if (!as7343_ready) return;
+bool as7343_data_ready() {
+  if (!as7343_ready) return false;
   
-  // Always start with bank 0 - read visible wavelengths (415-705nm) + clear
-  Wire.beginTransmission(AS7343_I2C_ADDRESS);
-  Wire.write(AS7343_BANK);
-  Wire.write(0x00);
-  Wire.endTransmission();
-  delayMicroseconds(100);
+#if AS7343_INT_PIN >= 0
+  if (as7343_int_pending) return true;
   
-  Wire.beginTransmission(AS7343_I2C_ADDRESS);
-  Wire.write(AS7343_DATA_START);
-  Wire.endTransmission();
+  // INT stays latched low until STATUS is cleared, so a missed edge would
+  // stall acquisition for good - recover by polling after a timeout
+  if (millis() - as7343_last_int_check < AS7343_INT_TIMEOUT_MS) return false;
+  as7343_last_int_check = millis();
+#endif
+  
+  return (as7343_read_reg(AS7343_STATUS2) & AS7343_STATUS2_AVALID) != 0;
+}
+
+/**
+ * Convert an 18-channel auto-SMUX burst into as7343_ch[] order
+ * @param raw ASTATUS byte followed by DATA_0_L..DATA_17_H
+ * @param out AS7343_NUM_CHANNELS values, wavelength order (AS7343Channel)
+ */
+void as7343_decode_frame(const uint8_t* raw, uint16_t* out) {
+  uint32_t clear_sum = 0;
+  const uint8_t* data = raw + 1;
   
-  // Read all 24 bytes from bank 0 (12 channels)
-  Wire.requestFrom(AS7343_I2C_ADDRESS, 24);
-  for (int i = 0; i < 12; i++) {
-    if (Wire.available() >= 2) {
-      uint8_t low = Wire.read();
-      uint8_t high = Wire.read();
-      as7343_ch[i] = (high << 8) | low;
+  for (uint8_t i = 0; i < AS7343_NUM_RAW; i++) {
+    uint8_t ch = as7343_smux_map[i];
+    uint16_t value = (uint16_t)data[2 * i] | ((uint16_t)data[2 * i + 1] << 8);
+    
+    if (ch == AS7343_CLEAR) {
+      clear_sum += value;
+    } else if (ch != AS7343_RAW_SKIP) {
+      out[ch] = value;
     }
   }
+  out[AS7343_CLEAR] = clear_sum / 3;
+}
+
+/**
+ * Read all 12 bands + clear from one auto-SMUX measurement
+ * A single burst from ASTATUS latches and returns all 18 data registers,
+ * so every channel comes from the same integration cycle.
+ * 
+ * Only copies data when AVALID is set, so stale or half-updated registers
+ * never reach as7343_ch[]. Updates as7343_frame on success.
+ * @return true if a fresh frame was read
+ */
+bool read_as7343() {
+  if (!as7343_ready) return false;
   
-  // Switch to bank 1 for better red/NIR data (some boards swap banks)
-  Wire.beginTransmission(AS7343_I2C_ADDRESS);
-  Wire.write(AS7343_BANK);
-  Wire.write(0x01);
-  Wire.endTransmission();
-  delayMicroseconds(100);
-  
-  Wire.beginTransmission(AS7343_I2C_ADDRESS);
-  Wire.write(AS7343_DATA_START);
-  Wire.endTransmission();
+  // An INT edge already guarantees AVALID - skip the extra status read
+  bool valid = as7343_int_pending ||
+               (as7343_read_reg(AS7343_STATUS2) & AS7343_STATUS2_AVALID);
+  as7343_int_pending = false;
+  if (!valid) return false;
+  uint32_t now = millis();
   
-  // Try to read alternative red/NIR from bank 1
-  Wire.requestFrom(AS7343_I2C_ADDRESS, 24);
-  uint16_t bank1_ch[12] = {0};
-  for (int i = 0; i < 12; i++) {
-    if (Wire.available() >= 2) {
-      uint8_t low = Wire.read();
-      uint8_t high = Wire.read();
-      bank1_ch[i] = (high << 8) | low;
-    }
+  uint8_t raw[AS7343_BURST_LEN];
+  if (!as7343_read_block(AS7343_ASTATUS, raw, AS7343_BURST_LEN)) {
+    return false;
   }
+  as7343_decode_frame(raw, as7343_ch);
   
-  // Use bank 1 data for channels 6-11 if they have better values (red/NIR)
-  for (int i = 6; i < 12; i++) {
-    if (bank1_ch[i] > as7343_ch[i]) {
-      as7343_ch[i] = bank1_ch[i];
-    }
-  }
+  // Release INT for the next cycle
+  as7343_write_reg(AS7343_STATUS, 0xFF);
+  as7343_last_int_check = now;
   
-  // Switch back to bank 0
-  Wire.beginTransmission(AS7343_I2C_ADDRESS);
-  Wire.write(AS7343_BANK);
-  Wire.write(0x00);
-  Wire.endTransmission();
+  as7343_frame.interval_ms = (as7343_frame.seq > 0) ? (now - as7343_frame.timestamp_ms) : 0;
+  as7343_frame.timestamp_ms = now;
+  as7343_frame.astatus = raw[0];
+  as7343_frame.seq++;
+  return true;
 }
 
 /**
- * Get channel value by index (0-11)
+ * Get channel value by index (0-12, see AS7343Channel)
  */
 uint16_t get_as7343_channel(uint8_t ch) {
-  if (ch < 12) return as7343_ch[ch];
+  if (ch < AS7343_NUM_CHANNELS) return as7343_ch[ch];
   return 0;
 }
 
 /**
  * Print AS7343 sensor data to serial
+ * (defaults to the current frame; the pipeline passes its frame copy)
  */
-void print_as7343_data() {
+void print_as7343_data(const AS7343Frame& frame = as7343_frame, const uint16_t* ch = as7343_ch,
+                       const AS7343Exposure& exposure = as7343_exposure) {
   if (!as7343_ready) {
     Serial.println("[AS7343] Sensor not ready");
     return;
   }
   
-  // Check for saturation
-  bool saturated = (as7343_ch[5] >= 65535);  // Channel 5 = 580nm
+  // Saturation: ASTATUS flag plus any channel at ADC full scale
+  uint16_t full_scale = as7343_full_scale(exposure.atime, exposure.astep);
+  bool saturated = (frame.astatus & AS7343_ASTATUS_ASAT) != 0;
   
-  Serial.print("[AS7343] ");
-  for (int i = 0; i < 12; i++) {
+  Serial.print("[AS7343] #");
+  Serial.print(frame.seq);
+  Serial.print(" @");
+  Serial.print(frame.timestamp_ms);
+  Serial.print("ms (+");
+  Serial.print(frame.interval_ms);
+  Serial.print(") ");
+  for (int i = 0; i < AS7343_NUM_CHANNELS; i++) {
     Serial.print(as7343_names[i]);
     Serial.print(":");
     // Show saturated channels with special marker
-    if (i == 5 && saturated) {
+    if (ch[i] >= full_scale) {
       Serial.print("SAT");
+      saturated = true;
     } else {
-      Serial.print(as7343_ch[i]);
+      Serial.print(ch[i]);
     }
-    if (i < 11) Serial.print(" ");
+    if (i < AS7343_NUM_CHANNELS - 1) Serial.print(" ");
   }
   
   if (saturated) {
-    Serial.print(" [⚠ 580nm saturated - reduce gain or integration time]");
+    Serial.print(" [⚠ saturated]");
   }
   Serial.println();
 }
@@ -288,7 +506,7 @@ uint8_t get_as7343_dominant() {
   uint16_t maxVal = 0;
   uint8_t maxIdx = 0;
   
-  for (int i = 0; i < 11; i++) {  // Skip CLEAR channel
+  for (int i = 0; i < AS7343_CLEAR; i++) {  // Skip CLEAR channel
     if (as7343_ch[i] > maxVal) {
       maxVal = as7343_ch[i];
       maxIdx = i;
@@ -0,0 +1,110 @@
+/**
+ * Boot Profiler
+ * Per-stage boot timings and the FAST_START switch
+ *
+ * Stages are marked from setup() with boot_stage(); each one records the
+ * time since the previous mark. The profile is printed at the end of
+ * setup() and again when the first valid spectral frame arrives, so the
+ * app start -> first frame budget can be read straight off the log.
+ * ROM and second-stage bootloader time is not included (see boot_stage()).
+ *
+ * FAST_START drops cosmetic delays, Serial.flush() calls and the OLED
+ * splash, and lets setup() start the AS7343 integrating before the radio
+ * and display are brought up.
+ */
+
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+
+// ==========================================
+// BOOT CONFIGURATION
+// ==========================================
+
+#ifndef FAST_START
+#define FAST_START 0              // 1 = duty-cycled nodes: shortest path to the first frame
+#endif
+
+#define BOOT_MAX_STAGES 12
+
+#if FAST_START
+#define BOOT_DELAY(ms)   do { } while (0)
+#define BOOT_FLUSH()     do { } while (0)
+#else
+#define BOOT_DELAY(ms)   delay(ms)
+#define BOOT_FLUSH()     Serial.flush()
+#endif
+
+// ==========================================
+// BOOT PROFILE STATE
+// ==========================================
+
+struct BootStage {
+  const char* name;
+  uint32_t    end_us;             // micros() at the end of the stage
+  uint32_t    duration_us;
+};
+
+struct BootProfile {
+  BootStage stages[BOOT_MAX_STAGES];
+  uint8_t   count;
+  uint32_t  last_us;              // End of the previous stage
+  uint32_t  first_frame_us;       // 0 until the first valid frame
+};
+
+BootProfile boot_profile = {{}, 0, 0, 0};
+
+// ==========================================
+// BOOT PROFILER FUNCTIONS
+// ==========================================
+
+/**
+ * Close the current stage (micros() is the esp_timer, which starts when
+ * the app starts - the first stage covers runtime init up to the first
+ * mark, not the ROM and bootloader before it)
+ */
+void boot_stage(const char* name) {
+  uint32_t now = micros();
+  if (boot_profile.count < BOOT_MAX_STAGES) {
+    BootStage* s = &boot_profile.stages[boot_profile.count++];
+    s->name = name;
+    s->end_us = now;
+    s->duration_us = now - boot_profile.last_us;
+  }
+  boot_profile.last_us = now;
+}
+
+void print_boot_profile() {
+  Serial.print("\n[BOOT] Profile (");
+  Serial.print(FAST_START ? "fast start" : "normal");
+  Serial.println("):");
+  for (uint8_t i = 0; i < boot_profile.count; i++) {
+    const BootStage& s = boot_profile.stages[i];
+    Serial.print("  ");
+    Serial.print(s.name);
+    Serial.print(": ");
+    Serial.print(s.duration_us / 1000.0f, 1);
+    Serial.print(" ms (at ");
+    Serial.print(s.end_us / 1000.0f, 1);
+    Serial.println(" ms)");
+  }
+  if (boot_profile.first_frame_us) {
+    Serial.print("  First valid frame at ");
+    Serial.print(boot_profile.first_frame_us / 1000.0f, 1);
+    Serial.println(" ms after app start");
+  }
+}
+
+/**
+ * Call for every valid frame - records and reports the first one only
+ */
+inline void boot_first_frame() {
+  if (boot_profile.first_frame_us) return;
+  boot_profile.first_frame_us = micros();
+  Serial.print("[BOOT] First valid frame at ");
+  Serial.print(boot_profile.first_frame_us / 1000.0f, 1);
+  Serial.println(" ms after app start");
+}
+
+#endif // BOOT_PROFILER_H
@@ -7,8 +7,8 @@
 #define DATA_STRUCTURES_H
 
 #include <Arduino.h>
-#include <map>
-#include <vector>
+#include "msg_dedup.h"
+#include "node_table.h"
 
 // ==========================================
 // CONFIGURATION STRUCTURE
@@ -91,47 +91,13 @@ struct SystemStatus {
         uptime_ms(0) {}
 };
 
-// ==========================================
-// NODE DATA STORAGE STRUCTURE
-// ==========================================
-
-/**
- * Information from a single LoRa node
- * Stores sensor readings and metadata
- */
-struct NodeInfo {
-    float t;                // Temperature (°C) or Voltage (V)
-    float h;                // Humidity (%) - optional
-    float b;                // Battery (V) or Power (W)
-    float v;                // Voltage (V) - PZEM
-    float a;                // Current (A) - PZEM
-    float w;                // Power (W) - PZEM
-    float wh;               // Energy (Wh) - PZEM
-    
-    int rssi;               // Received Signal Strength (dBm)
-    String path;            // Route path (DIRECT, RELAY, etc)
-    int via;                // Relay node ID (if relayed)
-    int seq;                // Sequence number
-    
-    unsigned long ts_local; // Local timestamp (millis)
-    unsigned long ts_recv;  // Receive timestamp
-    
-    // Constructor with defaults
-    NodeInfo() :
-        t(0), h(0), b(0), v(0), a(0), w(0), wh(0),
-        rssi(-130), path(""), via(0), seq(0),
-        ts_local(0), ts_recv(0) {}
-};
-
 // ==========================================
 // GLOBAL DATA STORAGE
 // ==========================================
 
-// Map: Node ID -> Node Data
-extern std::map<int, NodeInfo> nodesDataStore;
+// Node ID -> Node Data: flat table + PSRAM history (node_table.h)
 
-// Deduplication buffer: stores message hashes
-extern std::vector<uint32_t> seenMsgs;
+// Deduplication buffer: ring + hash set of message hashes (msg_dedup.h)
 
 // ==========================================
 // HELPER FUNCTIONS FOR DATA STRUCTURES
@@ -141,7 +107,7 @@ extern std::vector<uint32_t> seenMsgs;
  * Clear all node data
  */
 inline void clear_nodes_data() {
-    nodesDataStore.clear();
+    node_table_clear();
     Serial.println("[Data] Cleared all node data");
 }
 
@@ -149,7 +115,7 @@ inline void clear_nodes_data() {
  * Clear deduplication buffer
  */
 inline void clear_dedup_buffer() {
-    seenMsgs.clear();
+    msg_dedup_clear();
     Serial.println("[Data] Cleared deduplication buffer");
 }
 
@@ -158,54 +124,44 @@ inline void clear_dedup_buffer() {
  * @return Number of active nodes
  */
 inline int get_node_count() {
-    return nodesDataStore.size();
+    return node_table.count;
 }
 
 /**
  * Get node data by ID
  * @param node_id Node ID to retrieve
- * @return NodeInfo structure, or default if not found
+ * @return Pointer to the stored record (no copy), or NULL if not found
  */
-inline NodeInfo get_node_data(int node_id) {
-    if (nodesDataStore.find(node_id) != nodesDataStore.end()) {
-        return nodesDataStore[node_id];
-    }
-    return NodeInfo();  // Return default/empty struct
+inline const NodeInfo* get_node_data(int node_id) {
+    return node_table_find(node_id);
 }
 
 /**
- * Update node data
+ * Update node data and append it to the node's history
  * @param node_id Node ID
  * @param info New node information
+ * @return false if the node is new and the table is full
  */
-inline void update_node_data(int node_id, const NodeInfo& info) {
-    nodesDataStore[node_id] = info;
+inline bool update_node_data(int node_id, const NodeInfo& info) {
+    return node_table_record(node_id, info);
 }
 
 /**
  * Check if message is duplicate
  * @param hash Message hash (combination of sender + sequence)
- * @return true if duplicate found
+ * @return true if seen within DEDUP_EXPIRY_MS
  */
 inline bool is_duplicate_msg(uint32_t hash) {
-    for (uint32_t h : seenMsgs) {
-        if (h == hash) {
-            return true;
-        }
-    }
-    return false;
+    return msg_dedup_contains(hash);
 }
 
 /**
  * Add message hash to deduplication buffer
+ * Oldest entry is evicted once DEDUP_BUFFER_SIZE hashes are held.
  * @param hash Message hash to add
- * @param max_buffer Maximum buffer size before cleanup
  */
-inline void add_msg_hash(uint32_t hash, int max_buffer = 50) {
-    seenMsgs.push_back(hash);
-    if ((int)seenMsgs.size() > max_buffer) {
-        seenMsgs.erase(seenMsgs.begin());
-    }
+inline void add_msg_hash(uint32_t hash) {
+    msg_dedup_check_and_add(hash);
 }
 
 /**
@@ -251,7 +207,7 @@ void print_system_status(const SystemStatus& status) {
     Serial.print("  Relayed: ");
     Serial.println(status.gateway_relayed);
     Serial.print("  Active Nodes: ");
-    Serial.println(nodesDataStore.size());
+    Serial.println(get_node_count());
     
     Serial.println("===================================\n");
 }
@@ -7,18 +7,15 @@
 #define DEBUG_FUNCTIONS_H
 
 #include <Arduino.h>
+#include "deferred_log.h"
 
 // ==========================================
 // DEBUG LEVELS
 // ==========================================
-#define DEBUG_NONE 0
-#define DEBUG_ERROR 1
-#define DEBUG_WARN 2
-#define DEBUG_INFO 3
-#define DEBUG_VERBOSE 4
-
-// Current debug level
-#define DEBUG_LEVEL DEBUG_VERBOSE
+// DEBUG_NONE .. DEBUG_VERBOSE and DEBUG_LEVEL live in deferred_log.h.
+// The debug_*() helpers below queue through DLOG_*: levels above
+// DEBUG_LEVEL compile to empty functions, enabled ones are formatted by
+// the log task. message must be a string literal (only the pointer is kept).
 
 // ==========================================
 // SERIAL DEBUG OUTPUT
@@ -35,7 +32,8 @@ void init_serial_debug(unsigned long baud = 115200) {
     Serial.println("=========================================");
     Serial.println("  ESP32 LoRa Gateway - Debug Console");
     Serial.println("=========================================");
-    Serial.println("[DEBUG] Serial initialized at " + String(baud) + " baud");
+    dlog_init();
+    DLOG_INFO("[DEBUG] Serial initialized at %lu baud", baud);
 }
 
 /**
@@ -65,10 +63,7 @@ void print_debug_header(const char* level) {
  * @param message Error message
  */
 void debug_error(const char* message) {
-    if (DEBUG_LEVEL >= DEBUG_ERROR) {
-        print_debug_header("[ERROR]");
-        Serial.println(message);
-    }
+    DLOG_ERROR("%s", message);
 }
 
 /**
@@ -77,11 +72,7 @@ void debug_error(const char* message) {
  * @param value Numeric value
  */
 void debug_error(const char* message, int value) {
-    if (DEBUG_LEVEL >= DEBUG_ERROR) {
-        print_debug_header("[ERROR]");
-        Serial.print(message);
-        Serial.println(value);
-    }
+    DLOG_ERROR("%s%d", message, value);
 }
 
 // ==========================================
@@ -93,10 +84,7 @@ void debug_error(const char* message, int value) {
  * @param message Warning message
  */
 void debug_warn(const char* message) {
-    if (DEBUG_LEVEL >= DEBUG_WARN) {
-        print_debug_header("[WARN]");
-        Serial.println(message);
-    }
+    DLOG_WARN("%s", message);
 }
 
 /**
@@ -105,11 +93,7 @@ void debug_warn(const char* message) {
  * @param value Numeric value
  */
 void debug_warn(const char* message, float value) {
-    if (DEBUG_LEVEL >= DEBUG_WARN) {
-        print_debug_header("[WARN]");
-        Serial.print(message);
-        Serial.println(value);
-    }
+    DLOG_WARN("%s%.2f", message, value);
 }
 
 // ==========================================
@@ -121,10 +105,7 @@ void debug_warn(const char* message, float value) {
  * @param message Info message
  */
 void debug_info(const char* message) {
-    if (DEBUG_LEVEL >= DEBUG_INFO) {
-        print_debug_header("[INFO]");
-        Serial.println(message);
-    }
+    DLOG_INFO("%s", message);
 }
 
 /**
@@ -133,24 +114,22 @@ void debug_info(const char* message) {
  * @param value Numeric value
  */
 void debug_info(const char* message, int value) {
-    if (DEBUG_LEVEL >= DEBUG_INFO) {
-        print_debug_header("[INFO]");
-        Serial.print(message);
-        Serial.println(value);
-    }
+    DLOG_INFO("%s%d", message, value);
 }
 
 /**
  * Log info with float value
  * @param message Info message
  * @param value Float value
- * @param decimals Decimal places
+ * @param decimals Decimal places (0-4)
  */
 void debug_info(const char* message, float value, int decimals = 2) {
-    if (DEBUG_LEVEL >= DEBUG_INFO) {
-        print_debug_header("[INFO]");
-        Serial.print(message);
-        Serial.println(value, decimals);
+    switch (decimals) {
+        case 0:  DLOG_INFO("%s%.0f", message, value); break;
+        case 1:  DLOG_INFO("%s%.1f", message, value); break;
+        case 3:  DLOG_INFO("%s%.3f", message, value); break;
+        case 4:  DLOG_INFO("%s%.4f", message, value); break;
+        default: DLOG_INFO("%s%.2f", message, value); break;
     }
 }
 
@@ -163,10 +142,7 @@ void debug_info(const char* message, float value, int decimals = 2) {
  * @param message Verbose message
  */
 void debug_verbose(const char* message) {
-    if (DEBUG_LEVEL >= DEBUG_VERBOSE) {
-        print_debug_header("[VERBOSE]");
-        Serial.println(message);
-    }
+    DLOG_VERBOSE("%s", message);
 }
 
 /**
@@ -175,11 +151,7 @@ void debug_verbose(const char* message) {
  * @param value Value
  */
 void debug_verbose(const char* message, int value) {
-    if (DEBUG_LEVEL >= DEBUG_VERBOSE) {
-        print_debug_header("[VERBOSE]");
-        Serial.print(message);
-        Serial.println(value);
-    }
+    DLOG_VERBOSE("%s%d", message, value);
 }
 
 // ==========================================
@@ -314,6 +286,12 @@ void print_memory_stats() {
     Serial.print("  Total Heap: ");
     Serial.print(ESP.getHeapSize());
     Serial.println(" bytes");
+    Serial.print("  Largest Block: ");
+    Serial.print(ESP.getMaxAllocHeap());
+    Serial.println(" bytes");
+    Serial.print("  Min Free Heap: ");
+    Serial.print(ESP.getMinFreeHeap());
+    Serial.println(" bytes");
 }
 
 /**
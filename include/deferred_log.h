@@ -0,0 +1,376 @@
+/**
+ * Deferred Logging
+ * Compile-time levels, lock-free record ring, formatting in a low-priority task
+ *
+ *   DLOG_INFO("[LoRa] TX %u bytes to %u", len, to);
+ *
+ * A call site at a level above DEBUG_LEVEL expands to nothing, so its
+ * arguments are not even evaluated. An enabled call stores a pointer to
+ * its static site (format string + level), a millisecond timestamp and up
+ * to DLOG_MAX_ARGS raw 32-bit arguments in a ring slot - a few dozen
+ * cycles, no formatting, no UART. The formatter task turns records into
+ * text and writes them only when the UART TX ring has room, so logging
+ * never blocks the sensor or radio paths. When the ring is full the
+ * message is dropped and counted.
+ *
+ * Arguments: integers up to 32 bits, float/double (logged as float),
+ * pointers for %p and const char* - which must stay valid until formatted
+ * (string literals, const tables), since only the pointer is stored. The
+ * ring is multi-producer (any task, or an ISR), single consumer (the
+ * formatter).
+ */
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// ==========================================
+// LOG LEVELS
+// ==========================================
+#define DEBUG_NONE 0
+#define DEBUG_ERROR 1
+#define DEBUG_WARN 2
+#define DEBUG_INFO 3
+#define DEBUG_VERBOSE 4
+
+// Highest level compiled in (e.g. build_flags = -DDEBUG_LEVEL=2)
+#ifndef DEBUG_LEVEL
+#define DEBUG_LEVEL DEBUG_VERBOSE
+#endif
+
+// ==========================================
+// LOG CONFIGURATION
+// ==========================================
+
+#define DLOG_RING_SIZE    64        // Records (power of two), 40 bytes each
+#define DLOG_MAX_ARGS     6
+#define DLOG_LINE_MAX     160       // Formatted line, longer output is cut
+#define DLOG_TASK_STACK   3072
+#define DLOG_TASK_PRIO    1         // Just above idle
+#define DLOG_TASK_CORE    0
+#define DLOG_FLUSH_MS     10        // Formatter poll period when the ring is empty
+
+static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0, "DLOG_RING_SIZE must be a power of two");
+
+// ==========================================
+// RECORDS
+// ==========================================
+
+enum DlogArgType : uint8_t {
+  DLOG_ARG_INT = 0,
+  DLOG_ARG_UINT,
+  DLOG_ARG_FLOAT,
+  DLOG_ARG_STR
+};
+
+/**
+ * One call site - static, so its address is the format id
+ */
+struct DlogSite {
+  const char* fmt;
+  uint8_t     level;
+};
+
+struct DlogRecord {
+  std::atomic<uint32_t> seq;        // Slot sequence (bounded MPMC ring protocol)
+  const DlogSite* site;
+  uint32_t ts_ms;
+  uint8_t  nargs;
+  uint16_t types;                   // 2 bits per argument, DlogArgType
+  uintptr_t args[DLOG_MAX_ARGS];     // 32 bits on the ESP32, pointer-sized on the host
+};
+
+struct DlogArg {
+  uintptr_t v;
+  uint8_t  t;
+};
+
+struct DlogStats {
+  std::atomic<uint32_t> logged;
+  std::atomic<uint32_t> dropped;    // Ring full
+  uint32_t written;                 // Lines formatted and sent
+  uint32_t reported_drops;          // Drops already announced
+};
+
+DlogRecord dlog_ring[DLOG_RING_SIZE];
+std::atomic<uint32_t> dlog_head(0);   // Next slot to claim (producers)
+uint32_t dlog_tail = 0;               // Next slot to format (consumer only)
+DlogStats dlog_stats;
+TaskHandle_t dlog_task_handle = NULL;
+
+const char* const dlog_level_names[] = {"", "[ERROR]", "[WARN]", "[INFO]", "[VERBOSE]"};
+
+// ==========================================
+// PRODUCER SIDE
+// ==========================================
+
+inline DlogArg dlog_arg(int v)                { return {(uintptr_t)(uint32_t)v, DLOG_ARG_INT}; }
+inline DlogArg dlog_arg(long v)               { return {(uintptr_t)(uint32_t)v, DLOG_ARG_INT}; }
+inline DlogArg dlog_arg(short v)              { return {(uintptr_t)(uint32_t)(int)v, DLOG_ARG_INT}; }
+inline DlogArg dlog_arg(signed char v)        { return {(uintptr_t)(uint32_t)(int)v, DLOG_ARG_INT}; }
+inline DlogArg dlog_arg(char v)               { return {(uintptr_t)(uint32_t)(int)v, DLOG_ARG_INT}; }
+inline DlogArg dlog_arg(bool v)               { return {(uintptr_t)(uint32_t)v, DLOG_ARG_INT}; }
+inline DlogArg dlog_arg(unsigned int v)       { return {(uintptr_t)(uint32_t)v, DLOG_ARG_UINT}; }
+inline DlogArg dlog_arg(unsigned long v)      { return {(uintptr_t)(uint32_t)v, DLOG_ARG_UINT}; }
+inline DlogArg dlog_arg(unsigned short v)     { return {(uintptr_t)(uint32_t)v, DLOG_ARG_UINT}; }
+inline DlogArg dlog_arg(unsigned char v)      { return {(uintptr_t)(uint32_t)v, DLOG_ARG_UINT}; }
+inline DlogArg dlog_arg(const char* v)        { return {(uintptr_t)v, DLOG_ARG_STR}; }
+inline DlogArg dlog_arg(const void* v)        { return {(uintptr_t)v, DLOG_ARG_UINT}; }
+inline DlogArg dlog_arg(float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, 4);
+  return {bits, DLOG_ARG_FLOAT};
+}
+inline DlogArg dlog_arg(double v)             { return dlog_arg((float)v); }
+
+/**
+ * Claim a slot, copy the arguments and publish it (lock-free, ISR-safe)
+ */
+template <typename... Args>
+void dlog_push(const DlogSite* site, Args... args) {
+  static_assert(sizeof...(Args) <= DLOG_MAX_ARGS, "Too many log arguments (DLOG_MAX_ARGS)");
+  const DlogArg packed[] = {DlogArg{0, 0}, dlog_arg(args)...};
+
+  uint32_t pos = dlog_head.load(std::memory_order_relaxed);
+  DlogRecord* r;
+  for (;;) {
+    r = &dlog_ring[pos & (DLOG_RING_SIZE - 1)];
+    int32_t diff = (int32_t)(r->seq.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (dlog_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      dlog_stats.dropped.fetch_add(1, std::memory_order_relaxed);   // Full
+      return;
+    } else {
+      pos = dlog_head.load(std::memory_order_relaxed);
+    }
+  }
+
+  r->site = site;
+  r->ts_ms = millis();
+  r->nargs = sizeof...(Args);
+  r->types = 0;
+  for (uint8_t i = 0; i < sizeof...(Args); i++) {
+    r->args[i] = packed[i + 1].v;
+    r->types |= packed[i + 1].t << (i * 2);
+  }
+  r->seq.store(pos + 1, std::memory_order_release);
+  dlog_stats.logged.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Never called - lets the compiler check each format string against its arguments
+static inline void __attribute__((format(printf, 1, 2))) dlog_check_format(const char*, ...) {}
+
+#define DLOG_AT(lvl, fmt, ...) do {                       \
+    static const DlogSite dlog_site_ = {fmt, lvl};        \
+    if (0) dlog_check_format(fmt, ##__VA_ARGS__);         \
+    dlog_push(&dlog_site_, ##__VA_ARGS__);                \
+  } while (0)
+
+#if DEBUG_LEVEL >= DEBUG_ERROR
+#define DLOG_ERROR(fmt, ...) DLOG_AT(DEBUG_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_ERROR(fmt, ...) do {} while (0)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_WARN
+#define DLOG_WARN(fmt, ...) DLOG_AT(DEBUG_WARN, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_WARN(fmt, ...) do {} while (0)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_INFO
+#define DLOG_INFO(fmt, ...) DLOG_AT(DEBUG_INFO, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_INFO(fmt, ...) do {} while (0)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_VERBOSE
+#define DLOG_VERBOSE(fmt, ...) DLOG_AT(DEBUG_VERBOSE, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_VERBOSE(fmt, ...) do {} while (0)
+#endif
+
+// ==========================================
+// FORMATTER
+// ==========================================
+
+/**
+ * Expand one conversion spec (e.g. "%5.2f") with a stored argument
+ * @return characters written (clamped to cap - 1)
+ */
+static size_t dlog_format_arg(char* out, size_t cap, const char* spec, uintptr_t v, uint8_t type) {
+  bool is_long = strchr(spec, 'l') != NULL;
+  int n;
+  switch (type) {
+    case DLOG_ARG_FLOAT: {
+      uint32_t bits = (uint32_t)v;
+      float f;
+      memcpy(&f, &bits, 4);
+      n = snprintf(out, cap, spec, (double)f);
+      break;
+    }
+    case DLOG_ARG_STR:
+      n = snprintf(out, cap, spec, v ? (const char*)(uintptr_t)v : "(null)");
+      break;
+    case DLOG_ARG_UINT:
+      if (spec[strlen(spec) - 1] == 'p') {
+        n = snprintf(out, cap, spec, (void*)(uintptr_t)v);
+        break;
+      }
+      n = is_long ? snprintf(out, cap, spec, (unsigned long)v) : snprintf(out, cap, spec, (unsigned int)v);
+      break;
+    default:
+      n = is_long ? snprintf(out, cap, spec, (long)(int32_t)v) : snprintf(out, cap, spec, (int)(int32_t)v);
+      break;
+  }
+  if (n < 0) return 0;
+  return ((size_t)n < cap) ? (size_t)n : cap - 1;
+}
+
+/**
+ * Format a record as "[sec.mmm] [LEVEL]: message\r\n"
+ * @return line length
+ */
+size_t dlog_format(const DlogRecord* r, char* out, size_t cap) {
+  size_t pos = snprintf(out, cap, "[%lu.%03lu] %s: ", (unsigned long)(r->ts_ms / 1000),
+                        (unsigned long)(r->ts_ms % 1000), dlog_level_names[r->site->level]);
+  size_t end = cap - 3;             // Room for "\r\n" and the terminator
+  uint8_t arg = 0;
+
+  for (const char* p = r->site->fmt; *p && pos < end; p++) {
+    if (*p != '%') {
+      out[pos++] = *p;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[pos++] = '%';
+      p++;
+      continue;
+    }
+    // Copy the spec up to its conversion character
+    char spec[16];
+    uint8_t n = 0;
+    spec[n++] = *p++;
+    while (*p && !strchr("diouxXcsfFeEgGaAp", *p) && n < sizeof(spec) - 2) spec[n++] = *p++;
+    if (!*p) break;
+    spec[n++] = *p;
+    spec[n] = '\0';
+    if (arg < r->nargs) {
+      pos += dlog_format_arg(out + pos, end - pos + 1, spec, r->args[arg], (r->types >> (arg * 2)) & 3);
+      arg++;
+    }
+  }
+  if (pos > end) pos = end;
+  out[pos++] = '\r';
+  out[pos++] = '\n';
+  out[pos] = '\0';
+  return pos;
+}
+
+/**
+ * Format and write queued records while the output has room (consumer side)
+ * @param out       destination
+ * @param max_lines stop after this many lines
+ * @return lines written
+ */
+uint32_t dlog_drain(Print& out, uint32_t max_lines = DLOG_RING_SIZE) {
+  char line[DLOG_LINE_MAX];
+  uint32_t lines = 0;
+
+  uint32_t dropped = dlog_stats.dropped.load(std::memory_order_relaxed);
+  if (dropped != dlog_stats.reported_drops) {
+    int n = snprintf(line, sizeof(line), "[LOG] %lu messages dropped (ring full)\r\n",
+                     (unsigned long)(dropped - dlog_stats.reported_drops));
+    if (out.availableForWrite() < n) return 0;
+    out.write((const uint8_t*)line, n);
+    dlog_stats.reported_drops = dropped;
+    lines++;
+  }
+
+  while (lines < max_lines) {
+    DlogRecord* r = &dlog_ring[dlog_tail & (DLOG_RING_SIZE - 1)];
+    if (r->seq.load(std::memory_order_acquire) != dlog_tail + 1) break;   // Empty or being written
+
+    size_t n = dlog_format(r, line, sizeof(line));
+    if (out.availableForWrite() < (int)n) break;                         // Retry once the UART drains
+    out.write((const uint8_t*)line, n);
+
+    r->seq.store(dlog_tail + DLOG_RING_SIZE, std::memory_order_release);  // Free the slot
+    dlog_tail++;
+    dlog_stats.written++;
+    lines++;
+  }
+  return lines;
+}
+
+// ==========================================
+// FORMATTER TASK
+// ==========================================
+
+void dlog_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    if (dlog_drain(Serial, 8) == 0) vTaskDelay(pdMS_TO_TICKS(DLOG_FLUSH_MS));
+  }
+}
+
+/**
+ * Reset the ring (at static-init time, before anything logs)
+ */
+struct DlogRingInit {
+  DlogRingInit() {
+    for (uint32_t i = 0; i < DLOG_RING_SIZE; i++) dlog_ring[i].seq.store(i, std::memory_order_relaxed);
+  }
+};
+DlogRingInit dlog_ring_init;
+
+/**
+ * Start the formatter task (call once Serial is up)
+ * Records logged before this are kept and printed when it starts
+ * @return true if successful
+ */
+bool dlog_init() {
+  if (dlog_task_handle) return true;
+  if (xTaskCreatePinnedToCore(dlog_task, "log", DLOG_TASK_STACK, NULL,
+                              DLOG_TASK_PRIO, &dlog_task_handle, DLOG_TASK_CORE) != pdPASS) {
+    Serial.println("[LOG] Formatter task creation FAILED");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Wait for queued records to reach the UART (e.g. before deep sleep)
+ * Drains in the caller if the formatter task is not running
+ * @param timeout_ms give up after this long
+ */
+void dlog_flush(uint32_t timeout_ms = 100) {
+  uint32_t start = millis();
+  while (dlog_ring[dlog_tail & (DLOG_RING_SIZE - 1)].seq.load(std::memory_order_acquire) == dlog_tail + 1) {
+    if (millis() - start >= timeout_ms) break;
+    if (dlog_task_handle) {
+      vTaskDelay(1);
+    } else if (dlog_drain(Serial) == 0) {
+      delay(1);
+    }
+  }
+}
+
+void print_dlog_stats() {
+  Serial.println("\n[Log Statistics]");
+  Serial.print("  Level: ");
+  Serial.println(DEBUG_LEVEL > DEBUG_NONE ? dlog_level_names[DEBUG_LEVEL] : "[NONE]");
+  Serial.print("  Logged: ");
+  Serial.print(dlog_stats.logged.load());
+  Serial.print("  Written: ");
+  Serial.print(dlog_stats.written);
+  Serial.print("  Dropped: ");
+  Serial.println(dlog_stats.dropped.load());
+}
+
+#endif // DEFERRED_LOG_H
@@ -0,0 +1,209 @@
+/**
+ * Duty-Cycled Sensing
+ * wake -> one AS7343 frame -> indices -> LoRa report -> deep sleep
+ *
+ * Everything a wake needs lives in RTC slow memory: calibration, AGC and
+ * exposure, flicker state and sequence numbers. A timer wake therefore
+ * skips the full setup(): it brings up the two buses, restores the RTC
+ * copy and starts one integration on the sensor, which stays powered
+ * and configured through deep sleep (only measurement is stopped).
+ *
+ * A cold boot runs the normal setup(); the first report then enters the
+ * cycle. The OLED is switched off for the cycle. Wakes whose frame the
+ * report policy suppresses go back to sleep without transmitting.
+ */
+
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <esp_sleep.h>
+#include "lora_config.h"
+#include "i2c_bus.h"
+#include "oled_display.h"
+#include "as7343_sensor.h"
+#include "as7343_agc.h"
+#include "as7343_flicker.h"
+#include "spectral_analysis.h"
+#include "spectral_codec.h"
+#include "lora_functions.h"
+#include "lora_rx_queue.h"
+#include "report_policy.h"
+#include "deferred_log.h"
+
+// ==========================================
+// DUTY CYCLE CONFIGURATION
+// ==========================================
+
+#ifndef DUTY_CYCLE_ENABLED
+#define DUTY_CYCLE_ENABLED 0
+#endif
+
+#define DUTY_CYCLE_INTERVAL_S       DEFAULT_SEND_INTERVAL  // Wake period
+#define DUTY_CYCLE_FRAME_TIMEOUT_MS 1500    // Sleep anyway if no valid frame by then
+#define DUTY_CYCLE_MIN_SLEEP_MS     1000
+#define DUTY_CYCLE_MAGIC            0x44435943  // "DCYC"
+
+// ==========================================
+// RTC-RETAINED STATE
+// ==========================================
+
+struct DutyCycleRtc {
+  uint32_t magic;
+  uint32_t wakes;
+  uint32_t last_awake_ms;                     // Awake window of the previous cycle
+  uint16_t report_seq;
+  uint32_t frame_seq;
+  AS7343Exposure exposure;
+  AS7343AgcState agc;
+  AS7343FlickerState flicker;
+  ReportPolicyState report;                   // Last report sent, quiet-frame count
+  uint8_t calibration[sizeof(spectral_calibration)];
+};
+
+RTC_DATA_ATTR DutyCycleRtc duty_rtc;
+
+bool duty_cycle_woke = false;                 // This boot is a timer wake with RTC state
+bool duty_cycle_oled_on = false;              // OLED was initialised (cold boot)
+
+// ==========================================
+// DUTY CYCLE FUNCTIONS
+// ==========================================
+
+void duty_cycle_save() {
+  duty_rtc.report_seq = spectral_report_seq;
+  duty_rtc.frame_seq = as7343_frame.seq;
+  duty_rtc.exposure = as7343_exposure;
+  duty_rtc.agc = as7343_agc;
+  duty_rtc.flicker = as7343_flicker;
+  duty_rtc.report = report_policy;
+  memcpy(duty_rtc.calibration, &spectral_calibration, sizeof(duty_rtc.calibration));
+  duty_rtc.magic = DUTY_CYCLE_MAGIC;
+}
+
+/**
+ * Restore RTC state after a timer wake (call first thing in setup())
+ * @return true if this is a wake with valid state - use duty_cycle_wake_init()
+ */
+bool duty_cycle_resume() {
+#if DUTY_CYCLE_ENABLED
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) return false;
+  if (duty_rtc.magic != DUTY_CYCLE_MAGIC) return false;
+
+  spectral_report_seq = duty_rtc.report_seq;
+  as7343_frame.seq = duty_rtc.frame_seq;
+  as7343_exposure = duty_rtc.exposure;
+  as7343_agc = duty_rtc.agc;
+  as7343_flicker = duty_rtc.flicker;
+  as7343_mains_hz = duty_rtc.flicker.mains_hz;
+  report_policy = duty_rtc.report;
+  report_policy_init();                               // Deadbands are not retained
+  memcpy(&spectral_calibration, duty_rtc.calibration, sizeof(duty_rtc.calibration));
+  duty_rtc.wakes++;
+  duty_cycle_woke = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Minimal bring-up on a timer wake: buses, one integration, radio
+ * The sensor kept its registers through sleep, so only measurement is
+ * restarted; the radio is configured while it integrates.
+ */
+void duty_cycle_wake_init() {
+  i2c_bus_init();
+  SPI.begin(LORA_SCK, LORA_MISO, LORA_MOSI, LORA_SS);
+
+  as7343_ready = true;
+  as7343_write_reg(AS7343_STATUS, 0xFF);      // Clear the last cycle's interrupt
+#if AS7343_INT_PIN >= 0
+  pinMode(AS7343_INT_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(AS7343_INT_PIN), as7343_isr, FALLING);
+#endif
+  as7343_last_int_check = millis();
+  as7343_write_reg(AS7343_ENABLE, AS7343_ENABLE_PON | AS7343_ENABLE_SP_EN |
+                                  (FLICKER_ENABLED ? AS7343_ENABLE_FDEN : 0));
+
+  if (!rf95.init()) {
+    Serial.println("[DUTY] LoRa init failed");
+  }
+  configure_lora();
+
+  Serial.print("[DUTY] Wake ");
+  Serial.print(duty_rtc.wakes);
+  Serial.print(" (previous awake ");
+  Serial.print(duty_rtc.last_awake_ms);
+  Serial.println(" ms)");
+}
+
+/**
+ * Park the hardware and deep-sleep until the next period
+ */
+void duty_cycle_sleep() {
+  duty_cycle_save();
+
+  as7343_write_reg(AS7343_ENABLE, AS7343_ENABLE_PON);   // Stop measuring, keep config
+  lora_radio_lock();
+  rf95.sleep();
+  lora_radio_unlock();
+  if (duty_cycle_oled_on && i2c_bus_acquire(I2C_PRIO_DISPLAY)) {
+    display.ssd1306_command(SSD1306_DISPLAYOFF);
+    i2c_bus_release();
+  }
+
+  uint32_t awake_ms = millis();
+  duty_rtc.last_awake_ms = awake_ms;
+  uint32_t period_ms = DUTY_CYCLE_INTERVAL_S * 1000UL;
+  uint32_t sleep_ms = (awake_ms + DUTY_CYCLE_MIN_SLEEP_MS < period_ms) ? period_ms - awake_ms
+                                                                       : DUTY_CYCLE_MIN_SLEEP_MS;
+
+  Serial.print("[DUTY] Awake ");
+  Serial.print(awake_ms);
+  Serial.print(" ms, sleeping ");
+  Serial.print(sleep_ms);
+  Serial.println(" ms");
+  dlog_flush();                                         // Queued log lines, then the UART
+  Serial.flush();
+
+  esp_sleep_enable_timer_wakeup((uint64_t)sleep_ms * 1000ULL);
+  esp_deep_sleep_start();
+}
+
+/**
+ * Call after the indices of a valid frame are computed: send the report
+ * if the policy wants it (unacknowledged - no ACK wait in the awake
+ * window) and sleep
+ */
+void duty_cycle_after_frame() {
+#if DUTY_CYCLE_ENABLED
+  uint8_t reason = report_policy_evaluate(report_clock_ms());
+  if (reason != REPORT_SUPPRESS) {
+    uint8_t buf[MAX_PACKET_LEN];
+    size_t len = spectral_build_report(buf, sizeof(buf));
+    if (len > 0) {
+      if (lora_radio_send(buf, len, GATEWAY_ADDRESS)) rf95.waitPacketSent();
+    }
+  }
+  Serial.print("[DUTY] Report: ");
+  Serial.println(report_reason_name(reason));
+  duty_cycle_sleep();
+#endif
+}
+
+/**
+ * Call from loop() - gives up on the frame after DUTY_CYCLE_FRAME_TIMEOUT_MS
+ * (sensor missing or still settling) so a wake can never stay up
+ */
+void duty_cycle_poll() {
+#if DUTY_CYCLE_ENABLED
+  if (duty_cycle_woke && millis() > DUTY_CYCLE_FRAME_TIMEOUT_MS) {
+    Serial.println("[DUTY] No valid frame - sleeping");
+    duty_cycle_sleep();
+  }
+#endif
+}
+
+#endif // DUTY_CYCLE_H
@@ -0,0 +1,815 @@
+/**
+ * ESP-NOW Master / Node Control Loop
+ * Series DC converter nodes (node_config.h) balanced by one master,
+ * following MASTER_CONTROLLER.md and FAULT_DETECTION_COMPENSATION.md
+ *
+ * Both roles run a fixed-rate FreeRTOS task (ESPNOW_CONTROL_PERIOD_MS)
+ * pinned next to the WiFi task on core 0, away from loop() on core 1:
+ *   Node:   sense -> status to master every period; a received command is
+ *           actuated as soon as it arrives (task notification), not at the
+ *           next tick
+ *   Master: each tick takes the latest status of every node, runs fault
+ *           compensation (fast path, every tick with fresh data) and the
+ *           documented voltage optimisation (every VOLTAGE_RAMP_INTERVAL),
+ *           then broadcasts the command
+ * The radio callback only copies packets into per-node slots.
+ *
+ * Latency: every command carries the master's micros(). Nodes echo the
+ * last one with how long they held it, which gives the master a per-node
+ * round trip and hence a sense -> decide -> actuate cycle estimate,
+ * checked against ESPNOW_CYCLE_BUDGET_US.
+ *
+ * Build with ESPNOW_CONTROL_ROLE=1 (master) or 2 (node). Node hardware is
+ * attached with espnow_node_set_io(). ESP-NOW shares the radio with WiFi
+ * STA - a WiFi-connected master has to use its AP's channel.
+ */
+
+#ifndef ESPNOW_CONTROL_H
+#define ESPNOW_CONTROL_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "node_config.h"
+#include "deferred_log.h"
+
+// ==========================================
+// CONTROL CONFIGURATION
+// ==========================================
+
+#define ESPNOW_ROLE_NONE   0
+#define ESPNOW_ROLE_MASTER 1
+#define ESPNOW_ROLE_NODE   2
+
+#define ESPNOW_CHANNEL            1
+#define ESPNOW_CONTROL_PERIOD_MS  10        // Control / status rate (100 Hz)
+#define ESPNOW_CYCLE_BUDGET_US    50000     // Sense -> decide -> actuate target
+#define ESPNOW_TASK_STACK         4096
+#define ESPNOW_TASK_PRIO          (configMAX_PRIORITIES - 3)   // Below WiFi, above loop()
+#define ESPNOW_TASK_CORE          0
+
+#define ESPNOW_PROTO_VERSION      1
+#define ESPNOW_MSG_COMMAND        0x43      // 'C'
+#define ESPNOW_MSG_STATUS         0x53      // 'S'
+#define ESPNOW_BROADCAST_ID       0xFF
+
+// Master - MASTER_CONTROLLER.md
+#define VOLTAGE_RAMP_STEP         0.1f
+#define VOLTAGE_RAMP_INTERVAL     2000      // ms between optimisation steps
+#define MIN_SYSTEM_VOLTAGE        36.0f
+#define MAX_SYSTEM_VOLTAGE        60.0f
+#define VOLTAGE_BALANCE_TOLERANCE 1.0f
+#define OVERVOLTAGE_THRESHOLD     14.0f     // Per node
+#define OVERCURRENT_THRESHOLD     35.0f     // System
+#define EFFICIENCY_WARNING        80.0f     // %
+#define NODE_TIMEOUT              5000      // ms without status -> offline
+#define RECOVERY_CYCLES           10        // Fault-free optimisation steps before ramping back
+#define FAULT_RESET_HOLDOFF_MS    30000     // A node latched failed this long is sent NODE_CMD_RESET
+#define MIN_NODES_FOR_OPTIMISE    2
+
+// Compensation - FAULT_DETECTION_COMPENSATION.md
+#define FAULT_MIN_POWER_DETECTION   1.0f    // W - no efficiency judgement below this
+#define FAULT_VOLTAGE_COLLAPSE      5.0f
+#define FAULT_CURRENT_COLLAPSE      0.5f
+#define FAULT_POWER_LOSS_THRESHOLD  0.90f
+#define MIN_NODES_FOR_COMPENSATION  2
+#define MAX_COMPENSATION_VOLTAGE    20.0f   // Per node safety limit
+
+// Node status codes
+#define NODE_STATUS_NORMAL        0
+#define NODE_STATUS_SHADING       1
+#define NODE_STATUS_OVERVOLTAGE   2
+#define NODE_STATUS_OVERCURRENT   3
+#define NODE_STATUS_SOFT_FAULT    254       // >90% power loss
+#define NODE_STATUS_HARD_FAULT    255       // Panel or string open
+
+// Master fault bits
+#define FAULT_NODE_OFFLINE        0x01
+#define FAULT_OVERVOLTAGE         0x02
+#define FAULT_OVERCURRENT         0x04
+#define FAULT_LOW_EFFICIENCY      0x08
+#define FAULT_IMBALANCE           0x10
+#define FAULT_SHADING             0x20      // Informational
+#define FAULT_NODE_FAILED         0x40      // Status 254/255 reported
+
+// Commands
+#define NODE_CMD_RUN              0
+#define NODE_CMD_SHUTDOWN         1
+#define NODE_CMD_RESET            2
+
+// ==========================================
+// WIRE FORMAT
+// ==========================================
+
+struct __attribute__((packed)) MasterCommand {
+  uint8_t  type;                // ESPNOW_MSG_COMMAND
+  uint8_t  version;
+  uint8_t  node_id;             // ESPNOW_BROADCAST_ID = every node
+  uint8_t  command;             // NODE_CMD_*
+  uint16_t seq;
+  uint16_t working_nodes;       // Nodes the setpoint is shared across
+  float    target_voltage;      // Per node (V)
+  float    max_current;         // A
+  uint32_t master_us;           // Master micros() at send - echoed by nodes
+};
+
+struct __attribute__((packed)) NodeStatus {
+  uint8_t  type;                // ESPNOW_MSG_STATUS
+  uint8_t  version;
+  uint8_t  node_id;             // 1..NUM_SERIES_NODES
+  uint8_t  status;              // NODE_STATUS_*
+  uint16_t seq;
+  uint16_t cmd_seq;             // Last command applied
+  uint32_t timestamp;           // Node millis() at the sample
+  uint32_t echo_master_us;      // master_us of that command
+  uint32_t hold_us;             // Command receipt -> this status sent
+  uint32_t actuate_us;          // Command receipt -> setpoint applied
+  float    input_voltage;
+  float    input_current;
+  float    input_power;
+  float    output_voltage;
+  float    output_current;
+  float    output_power;
+  float    duty_cycle_percent;
+  float    efficiency;
+};
+
+/**
+ * One sample from the node's converter (filled by the sense hook)
+ */
+struct NodeMeasurement {
+  float input_voltage;
+  float input_current;
+  float output_voltage;
+  float output_current;
+  float duty_cycle_percent;
+};
+
+typedef bool (*espnow_sense_fn)(NodeMeasurement* m);
+typedef void (*espnow_actuate_fn)(float target_voltage, float max_current, uint8_t command);
+
+// ==========================================
+// SHARED STATE
+// ==========================================
+
+struct EspnowStats {
+  uint32_t ticks;
+  uint32_t tx;
+  uint32_t tx_errors;
+  uint32_t rx;
+  uint32_t rx_invalid;
+  uint32_t late_ticks;          // Tick started a full period late
+  uint32_t max_jitter_us;
+  uint32_t max_decide_us;
+  uint32_t budget_misses;       // Cycle estimate over ESPNOW_CYCLE_BUDGET_US
+  uint32_t last_cycle_us;
+  uint32_t max_cycle_us;
+};
+
+const uint8_t espnow_broadcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+const uint8_t espnow_master_mac[6] = MASTER_MAC_ADDR;
+
+portMUX_TYPE espnow_mux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t espnow_task_handle = NULL;
+EspnowStats espnow_stats;
+
+// ==========================================
+// MASTER STATE
+// ==========================================
+
+struct NodeTrack {
+  NodeStatus status;            // Latest report
+  uint32_t rx_us;               // Master micros() when it arrived
+  uint32_t rx_ms;
+  uint16_t last_used_seq;       // Status seq the controller last acted on
+  bool     online;
+  bool     seen;
+  uint32_t rtt_us;              // Command -> node -> status, node hold time removed
+  uint32_t max_rtt_us;
+  float    prev_input_power;
+  uint32_t failed_since_ms;     // Start of the current 254/255 run (or last reset), 0 = not failed
+};
+
+struct SystemState {
+  uint8_t  nodes_online;
+  uint8_t  nodes_working;
+  uint8_t  shaded;
+  float    system_voltage;
+  float    system_current;
+  float    input_power;
+  float    output_power;
+  float    efficiency;
+  float    v_min;
+  float    v_max;
+};
+
+struct MasterState {
+  NodeTrack node[NUM_SERIES_NODES + 1];   // 1-based, as NODE_ID
+  SystemState sys;
+  float    base_setpoint;       // Optimised per-node voltage for all nodes working
+  float    setpoint;            // Sent: base, rescaled for the working nodes
+  uint8_t  command;
+  uint8_t  faults;              // FAULT_* bits of the last tick
+  uint8_t  clean_cycles;        // Fault-free optimisation steps
+  uint16_t seq;
+  uint32_t last_optimise_ms;
+  volatile uint8_t reset_request;   // Operator reset: node id, ESPNOW_BROADCAST_ID = all, 0 = none
+  uint32_t resets_sent;
+};
+
+MasterState master;
+
+// ==========================================
+// NODE STATE
+// ==========================================
+
+struct NodeState {
+  espnow_sense_fn   sense;
+  espnow_actuate_fn actuate;
+  MasterCommand cmd;            // Latest command (written by the radio callback)
+  bool     cmd_pending;
+  uint32_t cmd_rx_us;
+  uint32_t applied_rx_us;       // Receipt time of the applied command
+  uint32_t cmd_applied_us;
+  uint16_t applied_seq;
+  uint32_t applied_master_us;
+  uint16_t seq;
+  NodeStatus prev;
+  bool     have_prev;
+  uint8_t  latched_fault;       // Status 254/255 held until NODE_CMD_RESET
+};
+
+NodeState node_ctl;
+
+// ==========================================
+// RADIO
+// ==========================================
+
+bool espnow_send(const uint8_t* mac, const void* msg, size_t len) {
+  esp_err_t err = esp_now_send(mac, (const uint8_t*)msg, len);
+  espnow_stats.tx++;
+  if (err != ESP_OK) {
+    espnow_stats.tx_errors++;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Radio callback (WiFi task) - copy into the state slot and return
+ */
+void espnow_handle_rx(const uint8_t* data, int len) {
+  uint32_t now = micros();
+  if (len < 2 || data[1] != ESPNOW_PROTO_VERSION) {
+    espnow_stats.rx_invalid++;
+    return;
+  }
+
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_MASTER
+  if (data[0] != ESPNOW_MSG_STATUS || len != sizeof(NodeStatus)) {
+    espnow_stats.rx_invalid++;
+    return;
+  }
+  const NodeStatus* s = (const NodeStatus*)data;
+  if (s->node_id < 1 || s->node_id > NUM_SERIES_NODES) {
+    espnow_stats.rx_invalid++;
+    return;
+  }
+  NodeTrack* t = &master.node[s->node_id];
+  portENTER_CRITICAL(&espnow_mux);
+  memcpy(&t->status, s, sizeof(NodeStatus));
+  t->rx_us = now;
+  t->rx_ms = millis();
+  t->seen = true;
+  portEXIT_CRITICAL(&espnow_mux);
+  espnow_stats.rx++;
+
+#elif ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_NODE
+  if (data[0] != ESPNOW_MSG_COMMAND || len != sizeof(MasterCommand)) {
+    espnow_stats.rx_invalid++;
+    return;
+  }
+  const MasterCommand* c = (const MasterCommand*)data;
+  if (c->node_id != ESPNOW_BROADCAST_ID && c->node_id != NODE_ID) return;
+  portENTER_CRITICAL(&espnow_mux);
+  memcpy(&node_ctl.cmd, c, sizeof(MasterCommand));
+  node_ctl.cmd_rx_us = now;
+  node_ctl.cmd_pending = true;
+  portEXIT_CRITICAL(&espnow_mux);
+  espnow_stats.rx++;
+  if (espnow_task_handle) xTaskNotifyGive(espnow_task_handle);   // Actuate now
+#else
+  (void)now;
+#endif
+}
+
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+void espnow_rx_cb(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+  (void)info;
+  espnow_handle_rx(data, len);
+}
+#else
+void espnow_rx_cb(const uint8_t* mac, const uint8_t* data, int len) {
+  (void)mac;
+  espnow_handle_rx(data, len);
+}
+#endif
+
+bool espnow_add_peer(const uint8_t* mac) {
+  esp_now_peer_info_t peer;
+  memset(&peer, 0, sizeof(peer));
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;                             // Whatever channel the radio is on (AP's if connected)
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+// ==========================================
+// MASTER CONTROL
+// ==========================================
+
+/**
+ * Snapshot node reports and aggregate the system state
+ * @return true if any node reported since the previous tick
+ */
+bool master_collect(NodeStatus* snap, bool* fresh) {
+  uint32_t now_ms = millis();
+  bool any_fresh = false;
+  SystemState* sys = &master.sys;
+  memset(sys, 0, sizeof(*sys));
+  sys->v_min = 1e9f;
+
+  for (uint8_t id = 1; id <= NUM_SERIES_NODES; id++) {
+    NodeTrack* t = &master.node[id];
+    uint32_t rx_ms;
+    portENTER_CRITICAL(&espnow_mux);
+    memcpy(&snap[id], &t->status, sizeof(NodeStatus));
+    rx_ms = t->rx_ms;
+    bool seen = t->seen;
+    portEXIT_CRITICAL(&espnow_mux);
+
+    t->online = seen && (now_ms - rx_ms) < NODE_TIMEOUT;
+    fresh[id] = t->online && snap[id].seq != t->last_used_seq;
+    if (fresh[id]) {
+      t->last_used_seq = snap[id].seq;
+      any_fresh = true;
+    }
+    if (!t->online) continue;
+
+    const NodeStatus* s = &snap[id];
+    sys->nodes_online++;
+    if (s->status < NODE_STATUS_SOFT_FAULT) sys->nodes_working++;   // Not power-gated: a stopped string draws none
+    if (s->status == NODE_STATUS_SHADING) sys->shaded++;
+    sys->system_voltage += s->output_voltage;
+    sys->system_current = max(sys->system_current, s->output_current);   // Series: one current
+    sys->input_power += s->input_power;
+    sys->output_power += s->output_power;
+    sys->v_min = min(sys->v_min, s->output_voltage);
+    sys->v_max = max(sys->v_max, s->output_voltage);
+  }
+  sys->efficiency = sys->input_power > 0 ? sys->output_power / sys->input_power * 100.0f : 0;
+  if (sys->nodes_online == 0) sys->v_min = sys->v_max = 0;
+  return any_fresh;
+}
+
+/**
+ * Fault flags from the current snapshot (fault table, MASTER_CONTROLLER.md)
+ */
+uint8_t master_detect_faults(const NodeStatus* snap) {
+  SystemState* sys = &master.sys;
+  uint8_t faults = 0;
+  if (sys->nodes_online < NUM_SERIES_NODES) faults |= FAULT_NODE_OFFLINE;
+  if (sys->system_current > OVERCURRENT_THRESHOLD) faults |= FAULT_OVERCURRENT;
+  if (sys->nodes_online > 1 && sys->v_max - sys->v_min > VOLTAGE_BALANCE_TOLERANCE) faults |= FAULT_IMBALANCE;
+  if (sys->input_power > FAULT_MIN_POWER_DETECTION && sys->efficiency < EFFICIENCY_WARNING) faults |= FAULT_LOW_EFFICIENCY;
+  if (sys->shaded) faults |= FAULT_SHADING;
+  uint32_t now_ms = millis();
+  for (uint8_t id = 1; id <= NUM_SERIES_NODES; id++) {
+    NodeTrack* t = &master.node[id];
+    bool failed = t->online && snap[id].status >= NODE_STATUS_SOFT_FAULT;
+    if (!failed) t->failed_since_ms = 0;
+    else if (t->failed_since_ms == 0) t->failed_since_ms = now_ms | 1;
+    if (!t->online) continue;
+    if (snap[id].output_voltage > OVERVOLTAGE_THRESHOLD) faults |= FAULT_OVERVOLTAGE;
+    if (failed) faults |= FAULT_NODE_FAILED;
+  }
+  return faults;
+}
+
+/**
+ * Node to send NODE_CMD_RESET this tick: an operator request, else a node
+ * that has reported 254/255 for FAULT_RESET_HOLDOFF_MS. The node clears its
+ * latch and re-classifies; a fault that persists latches again and is
+ * retried after another hold-off.
+ * @return node id, ESPNOW_BROADCAST_ID for all, or 0 for none
+ */
+uint8_t master_reset_due() {
+  uint8_t id = master.reset_request;
+  if (id) {
+    master.reset_request = 0;
+  } else {
+    uint32_t now_ms = millis();
+    for (uint8_t n = 1; n <= NUM_SERIES_NODES && !id; n++) {
+      NodeTrack* t = &master.node[n];
+      if (t->failed_since_ms && now_ms - t->failed_since_ms >= FAULT_RESET_HOLDOFF_MS) id = n;
+    }
+  }
+  if (id == 0) return 0;
+  for (uint8_t n = 1; n <= NUM_SERIES_NODES; n++) {
+    NodeTrack* t = &master.node[n];
+    if ((id == ESPNOW_BROADCAST_ID || id == n) && t->failed_since_ms) t->failed_since_ms = millis() | 1;
+  }
+  master.resets_sent++;
+  DLOG_WARN("[MASTER] Reset sent to node %u", id);
+  return id;
+}
+
+/**
+ * Ask the master to clear latched node faults on its next tick (any task)
+ * @param node_id 1..NUM_SERIES_NODES, or ESPNOW_BROADCAST_ID for every node
+ */
+void espnow_master_request_reset(uint8_t node_id) {
+  master.reset_request = node_id;
+}
+
+/**
+ * Voltage optimisation step (every VOLTAGE_RAMP_INTERVAL): balance first,
+ * then efficiency, then ramp toward the system voltage limit
+ */
+void master_optimise(uint8_t faults) {
+  float v = master.base_setpoint;
+
+  if (faults & ~FAULT_SHADING) {
+    master.clean_cycles = 0;
+  } else if (master.clean_cycles < RECOVERY_CYCLES) {
+    master.clean_cycles++;
+  }
+
+  if (faults & FAULT_OVERCURRENT) {
+    v -= VOLTAGE_RAMP_STEP;
+  } else if (faults & FAULT_IMBALANCE) {
+    v -= VOLTAGE_RAMP_STEP * 0.5f;
+  } else if (faults & FAULT_LOW_EFFICIENCY) {
+    v -= VOLTAGE_RAMP_STEP;
+  } else if (faults & FAULT_NODE_OFFLINE) {
+    // Hold - compensation rescales the working nodes
+  } else if (master.clean_cycles >= RECOVERY_CYCLES || v < TARGET_NODE_VOLTAGE) {
+    float system_voltage = v * NUM_SERIES_NODES;
+    if (system_voltage < MAX_SYSTEM_VOLTAGE) v += VOLTAGE_RAMP_STEP;
+    else if (system_voltage > MAX_SYSTEM_VOLTAGE) v -= VOLTAGE_RAMP_STEP;
+  }
+  master.base_setpoint = constrain(v, MIN_SYSTEM_VOLTAGE / NUM_SERIES_NODES,
+                                   MAX_SYSTEM_VOLTAGE / NUM_SERIES_NODES);
+}
+
+/**
+ * Fast path, every tick: over-voltage backs off as soon as it is reported,
+ * failed / offline nodes are compensated by rescaling the working ones and
+ * fewer than MIN_NODES_FOR_COMPENSATION working shuts the string down
+ */
+void master_compensate(uint8_t faults, bool fresh) {
+  SystemState* sys = &master.sys;
+  uint8_t working = sys->nodes_working;
+
+  if (sys->nodes_online == 0 || working < MIN_NODES_FOR_COMPENSATION) {
+    if (master.command != NODE_CMD_SHUTDOWN) {
+      DLOG_ERROR("[MASTER] CRITICAL: %u node(s) working - emergency shutdown", working);
+    }
+    master.command = NODE_CMD_SHUTDOWN;         // Cannot hold the string voltage
+    master.setpoint = 0;
+    return;
+  }
+  master.command = NODE_CMD_RUN;
+
+  if (fresh && (faults & FAULT_OVERVOLTAGE)) {
+    master.base_setpoint = max(master.base_setpoint - 0.2f, MIN_SYSTEM_VOLTAGE / NUM_SERIES_NODES);
+  }
+
+  float v = master.base_setpoint;
+  if (working < NUM_SERIES_NODES) {
+    v = master.base_setpoint * NUM_SERIES_NODES / working;   // Keep the string voltage
+    if (v > MAX_COMPENSATION_VOLTAGE) v = MAX_COMPENSATION_VOLTAGE;
+  }
+  master.setpoint = v;
+}
+
+/**
+ * Update round-trip and cycle estimates from the echoed command stamps
+ */
+void master_track_latency(const NodeStatus* snap, const bool* fresh, uint32_t decide_us) {
+  uint32_t worst = 0;
+  for (uint8_t id = 1; id <= NUM_SERIES_NODES; id++) {
+    NodeTrack* t = &master.node[id];
+    if (!fresh[id] || snap[id].echo_master_us == 0) continue;
+    uint32_t rtt = (t->rx_us - snap[id].echo_master_us) - snap[id].hold_us;
+    if (rtt > 1000000UL) continue;                               // Stale echo
+    t->rtt_us = t->rtt_us ? (t->rtt_us * 7 + rtt) / 8 : rtt;
+    if (rtt > t->max_rtt_us) t->max_rtt_us = rtt;
+
+    // Sample -> master (half RTT) + wait for this tick + decide + command
+    // flight (half RTT) + node actuation
+    uint32_t age = micros() - t->rx_us;
+    uint32_t cycle = rtt / 2 + age + decide_us + rtt / 2 + snap[id].actuate_us;
+    if (cycle > worst) worst = cycle;
+  }
+  if (worst == 0) return;
+  espnow_stats.last_cycle_us = worst;
+  if (worst > espnow_stats.max_cycle_us) espnow_stats.max_cycle_us = worst;
+  if (worst > ESPNOW_CYCLE_BUDGET_US) espnow_stats.budget_misses++;
+}
+
+void master_tick() {
+  static NodeStatus snap[NUM_SERIES_NODES + 1];
+  bool fresh[NUM_SERIES_NODES + 1];
+  uint32_t t0 = micros();
+
+  bool any_fresh = master_collect(snap, fresh);
+  uint8_t faults = master_detect_faults(snap);
+  if ((faults & ~master.faults) & ~FAULT_SHADING) {
+    DLOG_WARN("[MASTER] Fault 0x%02X (%u/%u online, %u working)", faults,
+              master.sys.nodes_online, NUM_SERIES_NODES, master.sys.nodes_working);
+  }
+  master.faults = faults;
+
+  uint32_t now_ms = millis();
+  if (master.sys.nodes_online >= MIN_NODES_FOR_OPTIMISE &&
+      now_ms - master.last_optimise_ms >= VOLTAGE_RAMP_INTERVAL) {
+    master.last_optimise_ms = now_ms;
+    master_optimise(faults);
+  }
+  master_compensate(faults, any_fresh);
+
+  MasterCommand cmd;
+  cmd.type = ESPNOW_MSG_COMMAND;
+  cmd.version = ESPNOW_PROTO_VERSION;
+  cmd.node_id = ESPNOW_BROADCAST_ID;
+  cmd.command = master.command;
+  cmd.seq = ++master.seq;
+  cmd.working_nodes = master.sys.nodes_working;
+  cmd.target_voltage = master.setpoint;
+  cmd.max_current = MAX_CURRENT_LIMIT;
+  uint32_t decide_us = micros() - t0;
+  if (decide_us > espnow_stats.max_decide_us) espnow_stats.max_decide_us = decide_us;
+  cmd.master_us = micros();
+  espnow_send(espnow_broadcast_mac, &cmd, sizeof(cmd));
+
+  // A reset rides on a command of its own, with the setpoint just sent
+  uint8_t reset_id = master_reset_due();
+  if (reset_id) {
+    cmd.node_id = reset_id;
+    cmd.command = NODE_CMD_RESET;
+    cmd.seq = ++master.seq;
+    cmd.master_us = micros();
+    espnow_send(espnow_broadcast_mac, &cmd, sizeof(cmd));
+  }
+
+  master_track_latency(snap, fresh, decide_us);
+}
+
+// ==========================================
+// NODE CONTROL
+// ==========================================
+
+/**
+ * Apply a pending command through the actuate hook
+ */
+void node_apply_command() {
+  MasterCommand c;
+  uint32_t rx_us;
+  portENTER_CRITICAL(&espnow_mux);
+  bool pending = node_ctl.cmd_pending;
+  memcpy(&c, &node_ctl.cmd, sizeof(c));
+  rx_us = node_ctl.cmd_rx_us;
+  node_ctl.cmd_pending = false;
+  portEXIT_CRITICAL(&espnow_mux);
+  if (!pending) return;
+
+  if (c.command == NODE_CMD_RESET) node_ctl.latched_fault = 0;
+  if (node_ctl.actuate) node_ctl.actuate(c.target_voltage, c.max_current, c.command);
+  node_ctl.cmd_applied_us = micros();
+  node_ctl.applied_rx_us = rx_us;
+  node_ctl.applied_seq = c.seq;
+  node_ctl.applied_master_us = c.master_us;
+}
+
+/**
+ * Node fault / shading classification (FAULT_DETECTION_COMPENSATION.md)
+ */
+uint8_t node_classify(const NodeStatus* cur, const NodeStatus* prev, bool have_prev) {
+  if (have_prev) {
+    if (prev->input_voltage > 20.0f && cur->input_voltage < FAULT_VOLTAGE_COLLAPSE) return NODE_STATUS_HARD_FAULT;
+    if (prev->input_current > 5.0f && cur->input_current < FAULT_CURRENT_COLLAPSE) return NODE_STATUS_HARD_FAULT;
+    if (prev->input_power > 50.0f &&
+        (prev->input_power - cur->input_power) / prev->input_power > FAULT_POWER_LOSS_THRESHOLD) {
+      return NODE_STATUS_SOFT_FAULT;
+    }
+  }
+  if (cur->output_voltage > OVERVOLTAGE_THRESHOLD) return NODE_STATUS_OVERVOLTAGE;
+  if (cur->output_current > MAX_CURRENT_LIMIT) return NODE_STATUS_OVERCURRENT;
+  // Panel voltage held but current well down against the previous sample
+  if (have_prev && prev->input_current > 1.0f && cur->input_voltage > FAULT_VOLTAGE_COLLAPSE &&
+      cur->input_current < prev->input_current * 0.5f) {
+    return NODE_STATUS_SHADING;
+  }
+  return NODE_STATUS_NORMAL;
+}
+
+void node_tick() {
+  NodeMeasurement m;
+  memset(&m, 0, sizeof(m));
+  if (!node_ctl.sense || !node_ctl.sense(&m)) return;
+
+  NodeStatus s;
+  s.type = ESPNOW_MSG_STATUS;
+  s.version = ESPNOW_PROTO_VERSION;
+  s.node_id = NODE_ID;
+  s.seq = ++node_ctl.seq;
+  s.timestamp = millis();
+  s.input_voltage = m.input_voltage;
+  s.input_current = m.input_current;
+  s.input_power = m.input_voltage * m.input_current;
+  s.output_voltage = m.output_voltage;
+  s.output_current = m.output_current;
+  s.output_power = m.output_voltage * m.output_current;
+  s.duty_cycle_percent = m.duty_cycle_percent;
+  s.efficiency = s.input_power > 0 ? s.output_power / s.input_power * 100.0f : 0;
+  s.status = node_classify(&s, &node_ctl.prev, node_ctl.have_prev);
+  if (s.status >= NODE_STATUS_SOFT_FAULT && s.status > node_ctl.latched_fault) node_ctl.latched_fault = s.status;
+  if (node_ctl.latched_fault) s.status = node_ctl.latched_fault;   // A collapse is only seen once
+  s.cmd_seq = node_ctl.applied_seq;
+  s.echo_master_us = node_ctl.applied_master_us;
+  s.actuate_us = node_ctl.cmd_applied_us - node_ctl.applied_rx_us;
+  s.hold_us = micros() - node_ctl.applied_rx_us;
+
+  espnow_send(espnow_master_mac, &s, sizeof(s));
+  node_ctl.prev = s;
+  node_ctl.have_prev = true;
+}
+
+/**
+ * Attach the converter: sense fills one measurement, actuate applies a
+ * setpoint (both run in the control task)
+ */
+void espnow_node_set_io(espnow_sense_fn sense, espnow_actuate_fn actuate) {
+  node_ctl.sense = sense;
+  node_ctl.actuate = actuate;
+}
+
+// ==========================================
+// CONTROL TASK
+// ==========================================
+
+void espnow_control_task(void* arg) {
+  (void)arg;
+  const TickType_t period = pdMS_TO_TICKS(ESPNOW_CONTROL_PERIOD_MS);
+  const uint32_t period_us = ESPNOW_CONTROL_PERIOD_MS * 1000UL;
+  TickType_t last_wake = xTaskGetTickCount();
+  uint32_t last_us = micros();
+
+  for (;;) {
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_NODE
+    // Sleep until the next tick, but wake early to actuate a command on arrival
+    TickType_t now = xTaskGetTickCount();
+    TickType_t due = last_wake + period;
+    if ((int32_t)(due - now) > 0 && ulTaskNotifyTake(pdTRUE, due - now) > 0) {
+      node_apply_command();
+      continue;
+    }
+    if ((int32_t)(now - due) > (int32_t)period) due = now;        // Overran - resync
+    last_wake = due;
+#else
+    vTaskDelayUntil(&last_wake, period);
+#endif
+    uint32_t now_us = micros();
+    uint32_t elapsed = now_us - last_us;
+    uint32_t jitter = elapsed > period_us ? elapsed - period_us : period_us - elapsed;
+    if (espnow_stats.ticks > 0) {
+      if (jitter > espnow_stats.max_jitter_us) espnow_stats.max_jitter_us = jitter;
+      if (elapsed > 2 * period_us) espnow_stats.late_ticks++;
+    }
+    last_us = now_us;
+    espnow_stats.ticks++;
+
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_MASTER
+    master_tick();
+#elif ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_NODE
+    node_apply_command();
+    node_tick();
+#endif
+  }
+}
+
+/**
+ * Bring up ESP-NOW and start the control task
+ * @return true if successful (false also when no role is configured)
+ */
+bool espnow_control_init() {
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_NONE
+  return false;
+#else
+  if (WiFi.getMode() == WIFI_OFF) {
+    WiFi.mode(WIFI_STA);
+    esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);   // Otherwise the AP's channel applies
+  }
+  esp_wifi_set_ps(WIFI_PS_NONE);                // Modem sleep adds up to a beacon interval
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("[ESPNOW] Init FAILED");
+    return false;
+  }
+  esp_now_register_recv_cb(espnow_rx_cb);
+
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_MASTER
+  espnow_add_peer(espnow_broadcast_mac);
+  master.base_setpoint = TARGET_NODE_VOLTAGE;
+  master.setpoint = TARGET_NODE_VOLTAGE;
+  master.last_optimise_ms = millis();
+#else
+  espnow_add_peer(espnow_master_mac);
+#endif
+
+  if (xTaskCreatePinnedToCore(espnow_control_task, "espnow_ctl", ESPNOW_TASK_STACK, NULL,
+                              ESPNOW_TASK_PRIO, &espnow_task_handle, ESPNOW_TASK_CORE) != pdPASS) {
+    Serial.println("[ESPNOW] Task creation FAILED");
+    return false;
+  }
+
+  Serial.print("[ESPNOW] ");
+  Serial.print(ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_MASTER ? "Master" : "Node ");
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_NODE
+  Serial.print(NODE_ID);
+#endif
+  Serial.print(" on channel ");
+  Serial.print(WiFi.channel());
+  Serial.print(", ");
+  Serial.print(ESPNOW_CONTROL_PERIOD_MS);
+  Serial.print(" ms loop, MAC ");
+  Serial.println(WiFi.macAddress());
+  return true;
+#endif
+}
+
+// ==========================================
+// STATUS OUTPUT
+// ==========================================
+
+const char* espnow_node_status_name(uint8_t status) {
+  switch (status) {
+    case NODE_STATUS_NORMAL:      return "NORMAL";
+    case NODE_STATUS_SHADING:     return "SHADED";
+    case NODE_STATUS_OVERVOLTAGE: return "OVER-V";
+    case NODE_STATUS_OVERCURRENT: return "OVER-I";
+    case NODE_STATUS_SOFT_FAULT:  return "SOFT-F";
+    case NODE_STATUS_HARD_FAULT:  return "FAULT";
+    default:                      return "?";
+  }
+}
+
+void print_espnow_control_status() {
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_MASTER
+  SystemState* sys = &master.sys;
+  Serial.println("\n[MASTER] System Status");
+  Serial.printf("  Nodes Online: %u/%u (working %u)\n", sys->nodes_online, NUM_SERIES_NODES, sys->nodes_working);
+  Serial.printf("  System Voltage: %.2fV (Target: %.1fV)  Current: %.2fA (Max: %.1fA)\n",
+                sys->system_voltage, (float)TARGET_SYSTEM_VOLTAGE, sys->system_current, OVERCURRENT_THRESHOLD);
+  Serial.printf("  Input Power: %.1fW | Output Power: %.1fW | Efficiency: %.1f%%\n",
+                sys->input_power, sys->output_power, sys->efficiency);
+  Serial.printf("  Voltage Setpoint: %.2fV/node (base %.2fV) | Shaded: %u | Faults: 0x%02X%s | Resets: %lu\n",
+                master.setpoint, master.base_setpoint, sys->shaded, master.faults,
+                master.command == NODE_CMD_SHUTDOWN ? " EMERGENCY STOP" : "",
+                (unsigned long)master.resets_sent);
+  Serial.println("  Node  In V/A        Out V   Out W   Duty%  Eff%   Status  RTT us (max)");
+  for (uint8_t id = 1; id <= NUM_SERIES_NODES; id++) {
+    NodeTrack* t = &master.node[id];
+    if (!t->online) {
+      Serial.printf("  %-4u  offline\n", id);
+      continue;
+    }
+    const NodeStatus* s = &t->status;
+    Serial.printf("  %-4u  %5.1f/%-5.1f  %6.2f  %6.1f  %5.1f  %5.1f  %-6s  %lu (%lu)\n", id,
+                  s->input_voltage, s->input_current, s->output_voltage, s->output_power,
+                  s->duty_cycle_percent, s->efficiency, espnow_node_status_name(s->status),
+                  (unsigned long)t->rtt_us, (unsigned long)t->max_rtt_us);
+  }
+#elif ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_NODE
+  Serial.printf("\n[NODE %u] Last command #%u: %.2fV, actuated %lu us after receipt\n", NODE_ID,
+                node_ctl.applied_seq, node_ctl.cmd.target_voltage,
+                (unsigned long)(node_ctl.cmd_applied_us - node_ctl.applied_rx_us));
+#endif
+  Serial.printf("  Loop: %lu ticks, max jitter %lu us, late %lu | TX %lu (err %lu) RX %lu (bad %lu)\n",
+                (unsigned long)espnow_stats.ticks, (unsigned long)espnow_stats.max_jitter_us,
+                (unsigned long)espnow_stats.late_ticks, (unsigned long)espnow_stats.tx,
+                (unsigned long)espnow_stats.tx_errors, (unsigned long)espnow_stats.rx,
+                (unsigned long)espnow_stats.rx_invalid);
+#if ESPNOW_CONTROL_ROLE == ESPNOW_ROLE_MASTER
+  Serial.printf("  Cycle: last %lu us, max %lu us, over %lu us budget: %lu | decide max %lu us\n",
+                (unsigned long)espnow_stats.last_cycle_us, (unsigned long)espnow_stats.max_cycle_us,
+                (unsigned long)ESPNOW_CYCLE_BUDGET_US, (unsigned long)espnow_stats.budget_misses,
+                (unsigned long)espnow_stats.max_decide_us);
+#endif
+}
+
+#endif // ESPNOW_CONTROL_H
@@ -0,0 +1,366 @@
+/**
+ * On-device Binary Frame Log
+ * Fixed 64-byte records in a circular raw flash partition ("framelog")
+ *
+ * - Records are batched in RAM and written FRAMELOG_BATCH_BYTES at a time
+ *   (page-aligned); each 4 KB sector is erased once per pass, when the
+ *   head enters it, so wear is spread evenly over the partition
+ * - The write position is recovered at boot from the record sequence
+ *   numbers - no index or metadata sector to wear out
+ * - Export streams the raw records oldest-first in sector-sized chunks
+ *   over serial ('L') or HTTP; host decoder: read_framelog.py
+ *
+ * Flash writes stall the cache for their duration (~1-2 ms per batch,
+ * ~45 ms per sector erase); GPIO interrupts are serviced afterwards and
+ * the radio FIFO holds a packet that lands meanwhile.
+ */
+
+#ifndef FRAMELOG_H
+#define FRAMELOG_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <WebServer.h>
+#include "as7343_sensor.h"
+#include "as7343_agc.h"
+#include "as7343_flicker.h"
+#include "spectral_analysis.h"
+#include "lora_functions.h"
+
+// ==========================================
+// FRAME LOG CONFIGURATION
+// ==========================================
+
+#define FRAMELOG_ENABLED        1
+#define FRAMELOG_PARTITION      "framelog"      // See partitions.csv
+#define FRAMELOG_SUBTYPE        0x40            // Custom data subtype
+#define FRAMELOG_VERSION        1
+#define FRAMELOG_SECTOR         4096
+#define FRAMELOG_BATCH_BYTES    1024            // RAM batch per flash write (multiple of 256)
+#define FRAMELOG_DECIMATE       1               // Log every Nth valid frame
+#define FRAMELOG_ERASED_SEQ     0xFFFFFFFFu
+
+// ==========================================
+// RECORD LAYOUT
+// ==========================================
+
+/**
+ * One logged frame (little-endian, 64 bytes)
+ * Indices are IEEE half floats: the formulas span ratios in the tens and
+ * inverse differences around 1e-4, which no single int16 scale covers.
+ * CRC-16/MODBUS covers every byte before crc.
+ */
+struct __attribute__((packed)) FrameLogRecord {
+  uint32_t seq;                              // Log sequence, FRAMELOG_ERASED_SEQ = empty
+  uint32_t timestamp_ms;                     // as7343_frame.timestamp_ms
+  uint16_t ch[AS7343_NUM_CHANNELS];          // Raw counts, AS7343Channel order
+  uint16_t idx[SPECTRAL_TABLE_SIZE];         // float16, spectral_index_table order
+  uint8_t  health[2];                        // vigor|chlorophyll, stress|water nibbles
+  uint8_t  gain;                             // AGAIN code
+  uint8_t  atime;
+  uint16_t astep;
+  uint8_t  agc;                              // time_idx (3:0) | saturated (4) | settle (7:5)
+  uint8_t  peak;                             // AGC peak level x 255
+  uint8_t  mains_hz;
+  uint8_t  version;                          // FRAMELOG_VERSION
+  uint32_t frame_seq;                        // as7343_frame.seq (gaps = frames not logged)
+  uint16_t crc;
+};
+
+static_assert(sizeof(FrameLogRecord) == 64, "FrameLogRecord layout changed - update read_framelog.py");
+static_assert(FRAMELOG_BATCH_BYTES % 256 == 0 && FRAMELOG_SECTOR % FRAMELOG_BATCH_BYTES == 0,
+              "FRAMELOG_BATCH_BYTES must be page-aligned and divide the sector");
+
+#define FRAMELOG_PER_BATCH (FRAMELOG_BATCH_BYTES / sizeof(FrameLogRecord))
+
+// ==========================================
+// FRAME LOG STATE
+// ==========================================
+
+struct FrameLog {
+  const esp_partition_t* part;
+  uint32_t capacity;                         // Records in the partition
+  uint32_t head;                             // Next record slot
+  uint32_t tail;                             // Oldest slot (sector-aligned)
+  uint32_t used;                             // Slots from tail to head (incl. padding)
+  uint32_t next_seq;
+  uint16_t pending;                          // Records in the RAM batch
+  uint16_t decimate;
+  uint32_t written;                          // Records flushed since boot
+  uint32_t erases;
+  uint32_t errors;
+  uint32_t dropped;                          // Records lost to flash errors
+};
+
+FrameLog framelog = {NULL, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+FrameLogRecord framelog_batch[FRAMELOG_PER_BATCH];
+
+/**
+ * float -> IEEE 754 half (round to nearest, overflow to inf, NaN kept)
+ */
+static inline uint16_t framelog_half(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  uint16_t sign = (x >> 16) & 0x8000;
+  int32_t exp = (int32_t)((x >> 23) & 0xFF) - 127 + 15;
+  uint32_t mant = x & 0x7FFFFF;
+
+  if (((x >> 23) & 0xFF) == 0xFF) return sign | 0x7C00 | (mant ? 0x200 : 0);
+  if (exp >= 31) return sign | 0x7C00;
+  if (exp <= 0) {
+    if (exp < -10) return sign;                     // Underflow to zero
+    mant |= 0x800000;                               // Subnormal half
+    uint32_t shift = 14 - exp;
+    uint32_t h = mant >> shift;
+    if ((mant >> (shift - 1)) & 1) h++;
+    return sign | h;
+  }
+  uint32_t h = ((uint32_t)exp << 10) | (mant >> 13);
+  if (mant & 0x1000) h++;                           // Carry may roll into the exponent (correct)
+  return sign | h;
+}
+
+// ==========================================
+// FLASH I/O
+// ==========================================
+
+uint32_t framelog_read_seq(uint32_t slot) {
+  uint32_t seq = FRAMELOG_ERASED_SEQ;
+  esp_partition_read(framelog.part, slot * sizeof(FrameLogRecord), &seq, sizeof(seq));
+  return seq;
+}
+
+/**
+ * Drop the RAM batch after a flash error so appends restart at slot 0
+ */
+static inline void framelog_drop_batch() {
+  framelog.errors++;
+  framelog.dropped += framelog.pending;
+  framelog.pending = 0;
+}
+
+/**
+ * Write the RAM batch at head (erasing the sector first if head starts one)
+ * On a flash error the batch is dropped; a failed write also skips the
+ * page, which may be partly programmed (its records fail the CRC).
+ */
+void framelog_flush() {
+  if (!framelog.part || framelog.pending == 0) return;
+
+  uint32_t offset = framelog.head * sizeof(FrameLogRecord);
+  if (offset % FRAMELOG_SECTOR == 0) {
+    if (esp_partition_erase_range(framelog.part, offset, FRAMELOG_SECTOR) != ESP_OK) {
+      framelog_drop_batch();
+      return;
+    }
+    framelog.erases++;
+    if (framelog.used > 0 && framelog.head == framelog.tail) {
+      // Log was full: the sector just erased held the oldest records
+      uint32_t per_sector = FRAMELOG_SECTOR / sizeof(FrameLogRecord);
+      framelog.tail = (framelog.tail + per_sector) % framelog.capacity;
+      framelog.used -= per_sector;
+    }
+  }
+
+  // A short batch (explicit flush) is padded with erased records so the
+  // write stays page-sized and the pad reads back as empty
+  for (uint16_t i = framelog.pending; i < FRAMELOG_PER_BATCH; i++) {
+    memset(&framelog_batch[i], 0xFF, sizeof(FrameLogRecord));
+  }
+  bool ok = esp_partition_write(framelog.part, offset, framelog_batch, FRAMELOG_BATCH_BYTES) == ESP_OK;
+  if (ok) {
+    framelog.written += framelog.pending;
+    framelog.pending = 0;
+  } else {
+    framelog_drop_batch();
+  }
+  framelog.used += FRAMELOG_PER_BATCH;
+  framelog.head = (framelog.head + FRAMELOG_PER_BATCH) % framelog.capacity;
+}
+
+// ==========================================
+// FRAME LOG API
+// ==========================================
+
+/**
+ * Find the partition and recover the write position
+ * Sector heads are scanned for the newest sequence; the log continues at
+ * the first empty batch after it (a partially padded batch is skipped,
+ * since flash can only be rewritten after an erase).
+ * @return true if the partition exists
+ */
+bool framelog_init() {
+#if FRAMELOG_ENABLED
+  framelog.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                           (esp_partition_subtype_t)FRAMELOG_SUBTYPE,
+                                           FRAMELOG_PARTITION);
+  if (!framelog.part) {
+    Serial.println("[FRAMELOG] No 'framelog' partition - logging disabled");
+    return false;
+  }
+  framelog.capacity = framelog.part->size / sizeof(FrameLogRecord);
+  framelog.capacity -= framelog.capacity % (FRAMELOG_SECTOR / sizeof(FrameLogRecord));
+
+  uint32_t per_sector = FRAMELOG_SECTOR / sizeof(FrameLogRecord);
+  uint32_t sectors = framelog.capacity / per_sector;
+  uint32_t newest_sector = 0, newest_seq = 0;
+  uint32_t oldest_sector = 0, oldest_seq = FRAMELOG_ERASED_SEQ;
+  bool any = false;
+
+  for (uint32_t s = 0; s < sectors; s++) {
+    uint32_t seq = framelog_read_seq(s * per_sector);
+    if (seq == FRAMELOG_ERASED_SEQ) continue;
+    if (!any || seq > newest_seq) { newest_seq = seq; newest_sector = s; }
+    if (seq < oldest_seq) { oldest_seq = seq; oldest_sector = s; }
+    any = true;
+  }
+
+  if (any) {
+    // Walk the newest sector batch by batch for the first empty one
+    uint32_t slot = newest_sector * per_sector;
+    uint32_t end = slot + per_sector;
+    uint32_t last_seq = newest_seq;
+    while (slot < end && framelog_read_seq(slot) != FRAMELOG_ERASED_SEQ) {
+      for (uint32_t i = 0; i < FRAMELOG_PER_BATCH; i++) {
+        uint32_t seq = framelog_read_seq(slot + i);
+        if (seq != FRAMELOG_ERASED_SEQ) last_seq = seq;
+      }
+      slot += FRAMELOG_PER_BATCH;
+    }
+    framelog.head = slot % framelog.capacity;
+    framelog.tail = oldest_sector * per_sector;
+    framelog.used = (framelog.head + framelog.capacity - framelog.tail) % framelog.capacity;
+    if (framelog.used == 0) framelog.used = framelog.capacity;
+    framelog.next_seq = last_seq + 1;
+  }
+
+  framelog.decimate = FRAMELOG_DECIMATE;
+  Serial.print("[FRAMELOG] ");
+  Serial.print(framelog.used);
+  Serial.print("/");
+  Serial.print(framelog.capacity);
+  Serial.print(" slots used (");
+  Serial.print(framelog.part->size / 1024);
+  Serial.println(" KB partition)");
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Append the current frame (call once per valid frame)
+ */
+void framelog_append() {
+  if (!framelog.part) return;
+  static uint16_t skip = 0;
+  if (++skip < framelog.decimate) return;
+  skip = 0;
+
+  FrameLogRecord* r = &framelog_batch[framelog.pending];
+  r->seq = framelog.next_seq++;
+  r->timestamp_ms = as7343_frame.timestamp_ms;
+  memcpy(r->ch, as7343_ch, sizeof(r->ch));
+  for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+    uint8_t slot = spectral_index_table[i].slot;
+    r->idx[i] = framelog_half(spectral_indices[slot]);
+  }
+  r->health[0] = (health_levels.vigor & 0x0F) | (health_levels.chlorophyll << 4);
+  r->health[1] = (health_levels.stress & 0x0F) | (health_levels.water << 4);
+  r->gain = as7343_exposure.gain;
+  r->atime = as7343_exposure.atime;
+  r->astep = as7343_exposure.astep;
+  r->agc = (as7343_agc.time_idx & 0x0F) | (as7343_agc.saturated ? 0x10 : 0) |
+           ((as7343_agc.settle & 0x07) << 5);
+  r->peak = (uint8_t)constrain((int)(as7343_agc.peak_level * 255.0f + 0.5f), 0, 255);
+  r->mains_hz = as7343_mains_hz;
+  r->version = FRAMELOG_VERSION;
+  r->frame_seq = as7343_frame.seq;
+  r->crc = crc16_modbus((const uint8_t*)r, sizeof(*r) - 2);
+
+  if (++framelog.pending == FRAMELOG_PER_BATCH) framelog_flush();
+}
+
+/**
+ * Stream the whole log, oldest first, in sector-sized chunks
+ * Emits "FRAMELOG <bytes>\n" then raw records; erased slots are skipped
+ * by the decoder (seq == 0xFFFFFFFF), the byte count is exact.
+ * @param out Serial, or a network client (see framelog_http_export())
+ * @return bytes of record data sent
+ */
+uint32_t framelog_export(Print& out, bool header = true) {
+  if (!framelog.part) return 0;
+  framelog_flush();                          // Include the RAM batch
+
+  static uint8_t chunk[FRAMELOG_SECTOR];
+  uint32_t slot = framelog.tail;
+  uint32_t bytes = framelog.used * sizeof(FrameLogRecord);
+
+  if (header) {
+    out.print("FRAMELOG ");
+    out.println(bytes);
+  }
+
+  uint32_t sent = 0;
+  while (sent < bytes) {
+    uint32_t offset = slot * sizeof(FrameLogRecord);
+    uint32_t n = min((uint32_t)sizeof(chunk), bytes - sent);
+    n = min(n, (uint32_t)(framelog.capacity * sizeof(FrameLogRecord)) - offset);   // Wrap point
+    if (esp_partition_read(framelog.part, offset, chunk, n) != ESP_OK) break;
+    out.write(chunk, n);
+    sent += n;
+    slot = (slot + n / sizeof(FrameLogRecord)) % framelog.capacity;
+  }
+  return sent;
+}
+
+/**
+ * HTTP handler body for a download route, e.g.
+ *   server.on("/framelog", []() { framelog_http_export(server); });
+ * The exact length goes in Content-Length and the records are written
+ * straight to the socket, one 4 KB flash read per chunk.
+ */
+void framelog_http_export(WebServer& server) {
+  if (!framelog.part) {
+    server.send(404, "text/plain", "no framelog partition");
+    return;
+  }
+  framelog_flush();
+  server.setContentLength(framelog.used * sizeof(FrameLogRecord));
+  server.sendHeader("Content-Disposition", "attachment; filename=framelog.bin");
+  server.send(200, "application/octet-stream", "");
+  WiFiClient client = server.client();
+  framelog_export(client, false);
+}
+
+/**
+ * Erase the whole log
+ */
+void framelog_clear() {
+  if (!framelog.part) return;
+  esp_partition_erase_range(framelog.part, 0, framelog.capacity * sizeof(FrameLogRecord));
+  framelog.head = 0;
+  framelog.tail = 0;
+  framelog.used = 0;
+  framelog.pending = 0;
+  Serial.println("[FRAMELOG] Cleared");
+}
+
+void print_framelog_stats() {
+  Serial.print("[FRAMELOG] Slots:");
+  Serial.print(framelog.used);
+  Serial.print("/");
+  Serial.print(framelog.capacity);
+  Serial.print(" Pending:");
+  Serial.print(framelog.pending);
+  Serial.print(" Written:");
+  Serial.print(framelog.written);
+  Serial.print(" Erases:");
+  Serial.print(framelog.erases);
+  Serial.print(" Err:");
+  Serial.print(framelog.errors);
+  Serial.print(" Dropped:");
+  Serial.println(framelog.dropped);
+}
+
+#endif // FRAMELOG_H
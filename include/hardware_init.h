@@ -12,6 +12,9 @@
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
 #include "lora_config.h"
+#include "i2c_bus.h"
+#include "oled_display.h"
+#include "boot_profiler.h"
 
 // ==========================================
 // GLOBAL HARDWARE OBJECTS
@@ -28,8 +31,13 @@ extern Adafruit_SSD1306 display;
  * @return true if successful, false otherwise
  */
 bool init_i2c() {
-    Wire.begin(OLED_SDA, OLED_SCL);
-    Serial.println("[I2C] Bus initialized on GPIO21(SDA), GPIO22(SCL)");
+    if (!i2c_bus_init()) {
+        Serial.println("[I2C] FAILED to initialize bus!");
+        return false;
+    }
+    Serial.print("[I2C] Bus initialized on GPIO21(SDA), GPIO22(SCL) at ");
+    Serial.print(I2C_BUS_FREQ / 1000);
+    Serial.println(" kHz");
     return true;
 }
 
@@ -50,7 +58,12 @@ void init_spi() {
  * @return true if display initialized successfully
  */
 bool init_oled() {
-    if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS)) {
+    bool ok = i2c_bus_acquire(I2C_PRIO_DISPLAY);  // Timed out: bus is not ours to release
+    if (ok) {
+        ok = display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS);
+        i2c_bus_release();
+    }
+    if (!ok) {
         Serial.println("[OLED] FAILED to initialize!");
         return false;
     }
@@ -58,9 +71,12 @@ bool init_oled() {
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     display.clearDisplay();
+    oled_invalidate();                   // Panel RAM is unknown after begin()
+#if !FAST_START
     display.setCursor(0, 0);
     display.println("OLED OK");
-    display.display();
+    oled_flush();                        // Splash - skipped on fast start
+#endif
     
     Serial.println("[OLED] Initialized (128x64, I2C Address: 0x3C)");
     return true;
@@ -86,11 +102,17 @@ void init_gpio() {
 void init_lora_gpio() {
     pinMode(LORA_RST, OUTPUT);
     digitalWrite(LORA_RST, HIGH);
-    delay(100);
+    BOOT_DELAY(100);
     digitalWrite(LORA_RST, LOW);
+#if FAST_START
+    delayMicroseconds(100);              // SX1276 minimum reset pulse
+    digitalWrite(LORA_RST, HIGH);
+    delay(5);                            // SX1276 ready after reset
+#else
     delay(10);
     digitalWrite(LORA_RST, HIGH);
     delay(100);
+#endif
     
     Serial.println("[LoRa GPIO] Reset sequence completed");
 }
@@ -99,13 +121,11 @@ void init_lora_gpio() {
  * Display boot message on OLED
  */
 void display_boot_message(const char* message) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     display.setCursor(0, 0);
     display.println("=== BOOTING ===");
     display.println(message);
-    display.display();
+    oled_flush();
 }
 
 #endif // HARDWARE_INIT_H
@@ -0,0 +1,199 @@
+/**
+ * Shared I2C Bus Manager
+ * Owns the Wire peripheral, runs it in fast mode and serialises access
+ * from every driver and FreeRTOS task
+ *
+ * Each device driver issues its transfers through the i2c_bus_* calls
+ * below (or brackets raw Wire/Adafruit calls with acquire/release).
+ * Sensor transactions take priority: a long display push checks
+ * i2c_bus_yield() between chunks and steps aside while a sensor request
+ * is waiting, so a frame read waits at most one chunk (~1 ms).
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "lora_config.h"
+
+// ==========================================
+// BUS CONFIGURATION
+// ==========================================
+
+// Priorities - lower value is more urgent
+#define I2C_PRIO_SENSOR  0    // AS7343 frame reads and register writes
+#define I2C_PRIO_DISPLAY 1    // SSD1306 pushes (preemptible at chunk boundaries)
+
+#define I2C_BUS_TIMEOUT_MS 100  // Give up acquiring the bus after this
+
+// ==========================================
+// BUS STATE
+// ==========================================
+
+struct I2cBusStats {
+  uint32_t transactions;      // Completed i2c_bus_* transfers
+  uint32_t errors;            // NACKs / short reads
+  uint32_t timeouts;          // Failed acquires
+  uint32_t yields;            // Display pushes that stepped aside for the sensor
+  uint32_t max_wait_us;       // Longest wait for the bus at I2C_PRIO_SENSOR
+};
+
+SemaphoreHandle_t i2c_bus_mutex = NULL;
+portMUX_TYPE i2c_bus_mux = portMUX_INITIALIZER_UNLOCKED;
+volatile uint8_t i2c_bus_high_waiting = 0;   // Sensor-priority requests queued
+uint8_t i2c_bus_depth = 0;                   // Recursive hold count of the owner
+I2cBusStats i2c_bus_stats = {0, 0, 0, 0, 0};
+
+// ==========================================
+// BUS OWNERSHIP
+// ==========================================
+
+/**
+ * Start the I2C peripheral in fast mode and create the bus lock
+ * @return true if successful
+ */
+bool i2c_bus_init() {
+  if (i2c_bus_mutex == NULL) {
+    i2c_bus_mutex = xSemaphoreCreateRecursiveMutex();
+    if (i2c_bus_mutex == NULL) return false;
+  }
+  if (!Wire.begin(OLED_SDA, OLED_SCL, I2C_BUS_FREQ)) return false;
+  Wire.setClock(I2C_BUS_FREQ);
+  return true;
+}
+
+/**
+ * Take the bus for one or more transfers
+ * Recursive - a driver holding the bus may call the transfer helpers.
+ * @param prio I2C_PRIO_* of the caller
+ * @return true if the bus is held (release with i2c_bus_release())
+ */
+bool i2c_bus_acquire(uint8_t prio) {
+  uint32_t start = micros();
+
+  if (prio == I2C_PRIO_SENSOR) {
+    portENTER_CRITICAL(&i2c_bus_mux);
+    i2c_bus_high_waiting++;
+    portEXIT_CRITICAL(&i2c_bus_mux);
+  }
+
+  bool ok = xSemaphoreTakeRecursive(i2c_bus_mutex, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)) == pdTRUE;
+
+  if (prio == I2C_PRIO_SENSOR) {
+    portENTER_CRITICAL(&i2c_bus_mux);
+    i2c_bus_high_waiting--;
+    portEXIT_CRITICAL(&i2c_bus_mux);
+    uint32_t waited = micros() - start;
+    if (waited > i2c_bus_stats.max_wait_us) i2c_bus_stats.max_wait_us = waited;
+  }
+
+  if (!ok) {
+    i2c_bus_stats.timeouts++;
+    return false;
+  }
+  i2c_bus_depth++;
+  return true;
+}
+
+void i2c_bus_release() {
+  i2c_bus_depth--;
+  xSemaphoreGiveRecursive(i2c_bus_mutex);
+}
+
+/**
+ * Preemption point for long low-priority transfers
+ * Call between chunks while holding the bus at I2C_PRIO_DISPLAY. If a
+ * sensor request is waiting, hands the bus over and re-takes it after.
+ * The caller must leave the device in a resumable state (e.g. the SSD1306
+ * keeps its column/page pointer across foreign transactions).
+ * @return true if the bus is still held
+ */
+bool i2c_bus_yield() {
+  if (i2c_bus_high_waiting == 0 || i2c_bus_depth != 1) return true;
+
+  i2c_bus_release();
+  while (i2c_bus_high_waiting > 0) {
+    vTaskDelay(1);             // Block so the waiter can run at any task priority
+  }
+  i2c_bus_stats.yields++;
+  return i2c_bus_acquire(I2C_PRIO_DISPLAY);
+}
+
+// ==========================================
+// TRANSFERS
+// ==========================================
+
+/**
+ * Write a buffer to a device in one transaction
+ * @return true if the device ACKed every byte
+ */
+bool i2c_bus_write(uint8_t addr, uint8_t prio, const uint8_t* buf, uint8_t len) {
+  if (!i2c_bus_acquire(prio)) return false;
+  Wire.beginTransmission(addr);
+  Wire.write(buf, len);
+  bool ok = Wire.endTransmission() == 0;
+  i2c_bus_release();
+
+  i2c_bus_stats.transactions++;
+  if (!ok) i2c_bus_stats.errors++;
+  return ok;
+}
+
+/**
+ * Write a register address, then read len bytes with a repeated start
+ * @return true if all bytes arrived
+ */
+bool i2c_bus_write_read(uint8_t addr, uint8_t prio, uint8_t reg, uint8_t* buf, uint8_t len) {
+  if (!i2c_bus_acquire(prio)) return false;
+  bool ok = false;
+  Wire.beginTransmission(addr);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) == 0 && Wire.requestFrom((int)addr, (int)len) == len) {
+    for (uint8_t i = 0; i < len; i++) {
+      buf[i] = Wire.read();
+    }
+    ok = true;
+  }
+  i2c_bus_release();
+
+  i2c_bus_stats.transactions++;
+  if (!ok) i2c_bus_stats.errors++;
+  return ok;
+}
+
+/**
+ * Check whether a device ACKs its address
+ * @return Wire error code (0 = ACK), 0xFF if the bus could not be acquired
+ */
+uint8_t i2c_bus_probe(uint8_t addr) {
+  if (!i2c_bus_acquire(I2C_PRIO_SENSOR)) return 0xFF;
+  Wire.beginTransmission(addr);
+  uint8_t error = Wire.endTransmission();
+  i2c_bus_release();
+  return error;
+}
+
+/**
+ * Print bus statistics
+ * (defaults to the live counters; the pipeline passes its frame copy)
+ */
+void print_i2c_bus_stats(const I2cBusStats& stats = i2c_bus_stats) {
+  Serial.print("[I2C] ");
+  Serial.print(I2C_BUS_FREQ / 1000);
+  Serial.print("kHz Xfer:");
+  Serial.print(stats.transactions);
+  Serial.print(" Err:");
+  Serial.print(stats.errors);
+  Serial.print(" Timeout:");
+  Serial.print(stats.timeouts);
+  Serial.print(" Yield:");
+  Serial.print(stats.yields);
+  Serial.print(" MaxWait:");
+  Serial.print(stats.max_wait_us);
+  Serial.println("us");
+}
+
+#endif // I2C_BUS_H
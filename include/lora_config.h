@@ -13,6 +13,12 @@
 #define MODE_GATEWAY 1
 #define MODE_CONFIG 2
 
+// WiFi gateway: received node reports batched to MQTT (mqtt_uplink.h),
+// live frame stream on port 81 (web_stream.h)
+#ifndef WIFI_GATEWAY_ENABLED
+#define WIFI_GATEWAY_ENABLED 0
+#endif
+
 // ==========================================
 // LOCKED CONFIGURATION (DO NOT EDIT)
 // ==========================================
@@ -58,6 +64,13 @@
 
 // AS7343 Spectral Sensor (I2C) - 11-channel spectral sensor
 #define AS7343_I2C_ADDRESS 0x39  // AS7343 default I2C address (7-bit)
+#define AS7343_INT_PIN 34        // AS7343 INT (open-drain, active low) - set -1 to poll AVALID
+
+// AS7343 array behind a TCA9548A I2C mux (as7343_array.h) - replaces the single sensor
+#ifndef AS7343_ARRAY_ENABLED
+#define AS7343_ARRAY_ENABLED 0
+#endif
+#define TCA9548A_I2C_ADDRESS 0x70
 
 // OLED Display (I2C)
 #define OLED_SDA 21
@@ -66,6 +79,9 @@
 #define SCREEN_HEIGHT 64
 #define OLED_I2C_ADDRESS 0x3C
 
+// Shared I2C bus (AS7343 + OLED) - 400 kHz fast mode is the SSD1306 limit
+#define I2C_BUS_FREQ 400000
+
 // LoRa Radio (SPI) - SX127x Module
 #define LORA_SCK 18           // SPI Clock
 #define LORA_MISO 19          // SPI MISO
@@ -74,6 +90,17 @@
 #define LORA_RST 4            // Reset Pin
 #define LORA_DIO0 35          // Interrupt Pin
 
+// AD7343 ADC (SPI) - own host, DMA + hardware CS (ad7343_sensor.h)
+#ifndef AD7343_ENABLED
+#define AD7343_ENABLED 0      // Continuous power-monitor sampling
+#endif
+#define AD7343_SPI_HOST SPI2_HOST   // HSPI - VSPI belongs to the LoRa radio
+#define AD7343_CLK 14         // SPI Clock
+#define AD7343_DOUT 27        // ADC data out (MISO) - GPIO12 is a boot strap
+#define AD7343_DIN 13         // ADC data in (MOSI)
+#define AD7343_CS 15          // Chip Select (hardware)
+#define AD7343_SAMPLE_RATE_HZ 4000
+
 // ==========================================
 // SYSTEM CONSTANTS
 // ==========================================
@@ -84,6 +111,6 @@
 #define CONFIG_TIMEOUT_MS 300000  // 5 minutes
 #define MQTT_RECONNECT_INTERVAL 5000
 #define WIFI_CONNECT_TIMEOUT 10000
-#define DEDUP_BUFFER_SIZE 50
+#define DEDUP_BUFFER_SIZE 2048  // Seen-message ring (msg_dedup.h)
 
 #endif // LORA_CONFIG_H
@@ -10,12 +10,24 @@
 #include <RH_RF95.h>
 #include <RHReliableDatagram.h>
 #include "lora_config.h"
+#include "lora_packet.h"
+#include "deferred_log.h"
 
 // ==========================================
 // GLOBAL RADIO OBJECTS
 // ==========================================
 
-extern RH_RF95 rf95;
+/**
+ * RH_RF95 with its DIO0 service routine exposed, so the receive path can
+ * run it from a task instead of RadioHead's own ISR (see lora_rx_queue.h)
+ */
+class LoraRadio : public RH_RF95 {
+public:
+    using RH_RF95::RH_RF95;
+    using RH_RF95::handleInterrupt;
+};
+
+extern LoraRadio rf95;
 extern RHReliableDatagram manager;
 
 // ==========================================
@@ -80,16 +92,13 @@ bool init_lora_radio() {
  * @param encLen Output parameter for encrypted length
  */
 void xor_encrypt_str(const String& plaintext, uint8_t* encrypted, int& encLen) {
-    int keyLen = strlen(FIXED_CRYPTO_KEY);
     encLen = plaintext.length();
     
     for (int i = 0; i < encLen; i++) {
-        encrypted[i] = (uint8_t)plaintext[i] ^ (uint8_t)FIXED_CRYPTO_KEY[i % keyLen];
+        encrypted[i] = (uint8_t)plaintext[i] ^ (uint8_t)FIXED_CRYPTO_KEY[i % LORA_KEY_LEN];
     }
     
-    Serial.print("[CRYPTO] Encrypted ");
-    Serial.print(encLen);
-    Serial.println(" bytes");
+    DLOG_VERBOSE("[CRYPTO] Encrypted %d bytes", encLen);
 }
 
 /**
@@ -99,29 +108,46 @@ void xor_encrypt_str(const String& plaintext, uint8_t* encrypted, int& encLen) {
  * @return Decrypted string
  */
 String xor_decrypt_str(const uint8_t* cipher, int len) {
-    int keyLen = strlen(FIXED_CRYPTO_KEY);
     String res = "";
     
     for (int i = 0; i < len; i++) {
-        res += (char)(cipher[i] ^ FIXED_CRYPTO_KEY[i % keyLen]);
+        res += (char)(cipher[i] ^ FIXED_CRYPTO_KEY[i % LORA_KEY_LEN]);
     }
     
     res.trim();
     return res;
 }
 
+/**
+ * XOR encrypt/decrypt a binary buffer in place (symmetric)
+ * @param buf Data buffer
+ * @param len Length of data
+ */
+void xor_crypt_buf(uint8_t* buf, int len) {
+    for (int i = 0; i < len; i++) {
+        buf[i] ^= (uint8_t)FIXED_CRYPTO_KEY[i % LORA_KEY_LEN];
+    }
+}
+
 // ==========================================
 // CRC16 CALCULATION
 // ==========================================
 
 /**
  * Calculate CRC16 checksum (CRC-16-MODBUS algorithm)
- * Used for data integrity verification
+ * Used for data integrity verification - table-driven (lora_packet.h)
  * @param data Input data buffer
  * @param length Length of data
  * @return Calculated CRC16 value
  */
 uint16_t calculateCRC16(uint8_t* data, uint8_t length) {
+    return crc16_modbus(data, length);
+}
+
+/**
+ * Bit-by-bit CRC-16/MODBUS - reference for tests and benchmarks
+ */
+uint16_t calculateCRC16_bitwise(const uint8_t* data, uint8_t length) {
     uint16_t crc = 0xFFFF;
     
     for (int i = 0; i < length; i++) {
@@ -151,6 +177,73 @@ bool verify_crc16(const uint8_t* data, uint8_t dataLen, uint16_t receivedCRC) {
     return (calculatedCRC == receivedCRC);
 }
 
+// ==========================================
+// PACKET KERNEL BENCHMARK
+// ==========================================
+
+#define LORA_BENCH_ITERATIONS 200
+
+/**
+ * Compare the fused open kernel with the original path
+ * (bit-by-bit CRC + String decrypt) on a sealed packet of each size,
+ * and check both produce the same plaintext
+ */
+void lora_packet_benchmark() {
+    static const uint8_t sizes[] = {16, 64, 128, 250};
+    uint8_t plain[MAX_PACKET_LEN];
+    uint8_t sealed[MAX_PACKET_LEN];
+    uint8_t work[MAX_PACKET_LEN];
+
+    Serial.println("\n[BENCH] Packet open: bitwise CRC + String decrypt vs fused kernel (cycles/packet)");
+    for (size_t s = 0; s < sizeof(sizes); s++) {
+        uint8_t n = sizes[s];
+        // Printable, non-space payload - xor_decrypt_str() trims isspace() characters
+        for (uint8_t i = 0; i < n; i++) plain[i] = (uint8_t)(0x21 + (i * 37 + 11) % 94);
+        memcpy(sealed, plain, n);
+        uint8_t len = lora_packet_seal(sealed, n, sizeof(sealed));
+
+        // Original path
+        bool ok_old = true;
+        String text;
+        uint32_t t0 = ESP.getCycleCount();
+        for (int it = 0; it < LORA_BENCH_ITERATIONS; it++) {
+            uint16_t crc = calculateCRC16_bitwise(sealed, len - 2);
+            ok_old &= (crc == (((uint16_t)sealed[len - 2] << 8) | sealed[len - 1]));
+            text = xor_decrypt_str(sealed, len - 2);
+        }
+        uint32_t old_cycles = (ESP.getCycleCount() - t0) / LORA_BENCH_ITERATIONS;
+
+        // Fused kernel (copy restores the ciphertext each pass; measured separately)
+        bool ok_new = true;
+        uint8_t payloadLen = 0;
+        uint32_t t1 = ESP.getCycleCount();
+        for (int it = 0; it < LORA_BENCH_ITERATIONS; it++) {
+            memcpy(work, sealed, len);
+        }
+        uint32_t copy_cycles = ESP.getCycleCount() - t1;
+        t1 = ESP.getCycleCount();
+        for (int it = 0; it < LORA_BENCH_ITERATIONS; it++) {
+            memcpy(work, sealed, len);
+            ok_new &= (lora_packet_open(work, len, &payloadLen) == LORA_PKT_OK);
+        }
+        uint32_t new_total = ESP.getCycleCount() - t1;
+        uint32_t new_cycles = (new_total > copy_cycles ? new_total - copy_cycles : 0) / LORA_BENCH_ITERATIONS;
+
+        bool match = ok_old && ok_new && payloadLen == n &&
+                     memcmp(work, plain, n) == 0 && memcmp(text.c_str(), plain, n) == 0;
+
+        Serial.print("[BENCH] ");
+        Serial.print(n);
+        Serial.print(" B: old ");
+        Serial.print(old_cycles);
+        Serial.print("  fused ");
+        Serial.print(new_cycles);
+        Serial.print("  x");
+        Serial.print(new_cycles ? (float)old_cycles / new_cycles : 0.0f, 1);
+        Serial.println(match ? "  match" : "  MISMATCH");
+    }
+}
+
 // ==========================================
 // MESSAGE DEDUPLICATION
 // ==========================================
@@ -158,10 +251,10 @@ bool verify_crc16(const uint8_t* data, uint8_t dataLen, uint16_t receivedCRC) {
 /**
  * Generate hash for message deduplication
  * @param sender Sender node ID
- * @param seq Sequence number
+ * @param seq Sequence number (16-bit, wraps after 65536 messages)
  * @return Hash value combining sender and sequence
  */
-uint32_t get_hash(uint8_t sender, uint8_t seq) {
+uint32_t get_hash(uint8_t sender, uint16_t seq) {
     return ((uint32_t)sender << 16) | seq;
 }
 
@@ -0,0 +1,242 @@
+/**
+ * Interrupt-driven LoRa Receive Queue
+ * DIO0 edge -> high-priority RX task -> preallocated packet pool ->
+ * lock-free queue -> consumer in loop()
+ *
+ * The RX task replaces RadioHead's own DIO0 ISR: it runs
+ * rf95.handleInterrupt() in task context (so SPI never runs inside an
+ * ISR), drains each frame into a pool slot, verifies the CRC and
+ * decrypts in place. No heap allocation per packet; if the consumer
+ * falls behind, packets are dropped and counted rather than blocking
+ * the radio.
+ *
+ * TxDone is signalled on DIO0 too, so RHReliableDatagram sends keep
+ * working - the same task services them.
+ *
+ * The radio is shared with senders on other tasks (report uplink,
+ * profiler packet). Everything that touches rf95 / manager while the
+ * task runs holds lora_radio_mutex; senders go through lora_radio_send(),
+ * which waits for a previous TX to finish with the lock released (only
+ * this task can see its TxDone).
+ */
+
+#ifndef LORA_RX_QUEUE_H
+#define LORA_RX_QUEUE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "lora_config.h"
+#include "lora_functions.h"
+#include "spsc_queue.h"
+
+// ==========================================
+// RX QUEUE CONFIGURATION
+// ==========================================
+
+#define LORA_RX_POOL_SIZE   8       // Packet buffers (power of two)
+#define LORA_RX_TASK_STACK  3072
+#define LORA_RX_TASK_PRIO   (configMAX_PRIORITIES - 2)
+#define LORA_RX_TASK_CORE   0       // Radio / network core - acquisition owns core 1
+#define LORA_RX_POLL_MS     1000    // Service the radio anyway if no edge arrives
+#define LORA_TX_WAIT_MS     2000    // Longest wait for the previous TX (SF12 airtime)
+
+// ==========================================
+// PACKET POOL
+// ==========================================
+
+/**
+ * One received packet - payload is decrypted in place when status is LORA_PKT_OK
+ */
+struct LoraRxPacket {
+  uint8_t  data[RH_RF95_MAX_MESSAGE_LEN];
+  uint8_t  len;              // Payload length (CRC stripped)
+  uint8_t  status;           // LORA_PKT_*
+  uint8_t  from;             // RadioHead header
+  uint8_t  to;
+  uint8_t  id;
+  uint8_t  flags;
+  int16_t  rssi;
+  uint32_t timestamp_ms;
+};
+
+struct LoraRxStats {
+  uint32_t received;         // Frames drained from the radio
+  uint32_t crc_errors;
+  uint32_t dropped;          // No free pool slot
+  uint32_t max_queued;       // High-water mark of the ready queue
+};
+
+LoraRxPacket lora_rx_pool[LORA_RX_POOL_SIZE];
+SpscQueue<uint8_t, LORA_RX_POOL_SIZE> lora_rx_free;    // Consumer -> RX task
+SpscQueue<uint8_t, LORA_RX_POOL_SIZE> lora_rx_ready;   // RX task -> consumer
+LoraRxStats lora_rx_stats = {0, 0, 0, 0};
+TaskHandle_t lora_rx_task_handle = NULL;
+SemaphoreHandle_t lora_radio_mutex = NULL;   // NULL until lora_rx_init() - single-threaded
+uint32_t lora_tx_timeouts = 0;
+
+// ==========================================
+// RADIO LOCK
+// ==========================================
+
+/**
+ * Take the radio (no-op before lora_rx_init(), e.g. on a duty-cycle wake)
+ */
+bool lora_radio_lock(TickType_t wait = portMAX_DELAY) {
+  if (lora_radio_mutex == NULL) return true;
+  return xSemaphoreTake(lora_radio_mutex, wait) == pdTRUE;
+}
+
+void lora_radio_unlock() {
+  if (lora_radio_mutex != NULL) xSemaphoreGive(lora_radio_mutex);
+}
+
+/**
+ * Unacknowledged send from any task. Waits (unlocked) until a previous
+ * TX has completed, so RadioHead never spins on TxDone while holding
+ * the radio; the frame itself goes out in the background.
+ * @return true if the frame was handed to the radio
+ */
+bool lora_radio_send(const uint8_t* buf, uint8_t len, uint8_t dest) {
+  uint32_t start = millis();
+  for (;;) {
+    if (!lora_radio_lock()) return false;
+    if (lora_radio_mutex == NULL || rf95.mode() != RHGenericDriver::RHModeTx) break;
+    lora_radio_unlock();
+    if (millis() - start >= LORA_TX_WAIT_MS) {
+      lora_tx_timeouts++;
+      return false;
+    }
+    vTaskDelay(1);
+  }
+  bool ok = manager.sendto((uint8_t*)buf, len, dest);
+  lora_radio_unlock();
+  return ok;
+}
+
+// ==========================================
+// RX TASK
+// ==========================================
+
+void IRAM_ATTR lora_rx_isr() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(lora_rx_task_handle, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+/**
+ * Move the frame held by the driver into a pool slot and queue it
+ */
+void lora_rx_store() {
+  static uint8_t scratch[RH_RF95_MAX_MESSAGE_LEN];
+  uint8_t idx;
+
+  if (!lora_rx_free.pop(&idx)) {
+    uint8_t len = sizeof(scratch);
+    rf95.recv(scratch, &len);           // Release the driver buffer
+    lora_rx_stats.dropped++;
+    return;
+  }
+
+  LoraRxPacket* p = &lora_rx_pool[idx];
+  uint8_t len = sizeof(p->data);
+  if (!rf95.recv(p->data, &len)) {
+    lora_rx_free.push(idx);
+    return;
+  }
+
+  p->from = rf95.headerFrom();
+  p->to = rf95.headerTo();
+  p->id = rf95.headerId();
+  p->flags = rf95.headerFlags();
+  p->rssi = rf95.lastRssi();
+  p->timestamp_ms = millis();
+  p->status = lora_packet_open(p->data, len, &p->len);
+
+  lora_rx_stats.received++;
+  if (p->status == LORA_PKT_CRC_FAIL) lora_rx_stats.crc_errors++;
+
+  lora_rx_ready.push(idx);              // Cannot fail - at most POOL_SIZE slots exist
+  uint32_t queued = lora_rx_ready.size();
+  if (queued > lora_rx_stats.max_queued) lora_rx_stats.max_queued = queued;
+}
+
+void lora_rx_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LORA_RX_POLL_MS));
+    lora_radio_lock();
+    rf95.handleInterrupt();             // RxDone / TxDone / CadDone
+    while (rf95.available()) {          // Also returns the radio to RX after TxDone
+      lora_rx_store();
+    }
+    lora_radio_unlock();
+  }
+}
+
+// ==========================================
+// RX QUEUE API
+// ==========================================
+
+/**
+ * Start the RX task and take over DIO0 (call after rf95.init())
+ * @return true if successful
+ */
+bool lora_rx_init() {
+  for (uint8_t i = 0; i < LORA_RX_POOL_SIZE; i++) {
+    lora_rx_free.push(i);
+  }
+  lora_radio_mutex = xSemaphoreCreateMutex();
+  if (lora_radio_mutex == NULL) {
+    Serial.println("[LoRa RX] Radio mutex creation FAILED");
+    return false;
+  }
+
+  if (xTaskCreatePinnedToCore(lora_rx_task, "lora_rx", LORA_RX_TASK_STACK, NULL,
+                              LORA_RX_TASK_PRIO, &lora_rx_task_handle, LORA_RX_TASK_CORE) != pdPASS) {
+    Serial.println("[LoRa RX] Task creation FAILED");
+    return false;
+  }
+
+  // Replaces the ISR RadioHead attached in init()
+  attachInterrupt(digitalPinToInterrupt(LORA_DIO0), lora_rx_isr, RISING);
+  lora_radio_lock();
+  rf95.setModeRx();
+  lora_radio_unlock();
+
+  Serial.print("[LoRa RX] Interrupt-driven queue ready (");
+  Serial.print(LORA_RX_POOL_SIZE);
+  Serial.println(" buffers)");
+  return true;
+}
+
+/**
+ * Next received packet, or NULL if none - return it with lora_rx_release()
+ */
+LoraRxPacket* lora_rx_receive() {
+  uint8_t idx;
+  if (!lora_rx_ready.pop(&idx)) return NULL;
+  return &lora_rx_pool[idx];
+}
+
+void lora_rx_release(LoraRxPacket* p) {
+  lora_rx_free.push((uint8_t)(p - lora_rx_pool));
+}
+
+void print_lora_rx_stats() {
+  Serial.print("[LoRa RX] Rx:");
+  Serial.print(lora_rx_stats.received);
+  Serial.print(" CRC:");
+  Serial.print(lora_rx_stats.crc_errors);
+  Serial.print(" Drop:");
+  Serial.print(lora_rx_stats.dropped);
+  Serial.print(" MaxQ:");
+  Serial.print(lora_rx_stats.max_queued);
+  Serial.print(" TxTimeout:");
+  Serial.println(lora_tx_timeouts);
+}
+
+#endif // LORA_RX_QUEUE_H
@@ -0,0 +1,387 @@
+/**
+ * MQTT Uplink
+ * Batched, non-blocking publishing of node reports with an offline backlog
+ *
+ * loop() / the RX path only push reports into a lock-free queue. A
+ * dedicated task on the WiFi core owns mqttClient and:
+ * - runs the broker connection as a state machine with exponential
+ *   backoff (a blocking connect attempt stalls this task, never loop())
+ * - packs reports into one JSON publish per batch, flushed when
+ *   UPLINK_BATCH_MAX_NODES / UPLINK_BATCH_MAX_BYTES is reached or the
+ *   oldest report is UPLINK_FLUSH_MS old
+ * - parks batches in a PSRAM backlog ring while the broker is down and
+ *   drains it (oldest first) once the connection returns
+ *
+ * Once uplink_init() has run, publish only through this module -
+ * PubSubClient is not thread-safe.
+ */
+
+#ifndef MQTT_UPLINK_H
+#define MQTT_UPLINK_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <ArduinoJson.h>
+#include "lora_config.h"
+#include "wifi_functions.h"
+#include "node_table.h"
+#include "spsc_queue.h"
+
+// ==========================================
+// UPLINK CONFIGURATION
+// ==========================================
+
+#define UPLINK_TOPIC            MQTT_TOPIC "/batch"
+#define UPLINK_QUEUE_LEN        64          // Reports waiting for the task (power of two)
+#define UPLINK_BATCH_MAX_NODES  16
+#define UPLINK_BATCH_MAX_BYTES  1536        // JSON payload limit per publish
+#define UPLINK_FLUSH_MS         5000        // Max age of the oldest report in a batch
+#define UPLINK_BACKLOG_PSRAM    (256 * 1024)
+#define UPLINK_BACKLOG_SRAM     (8 * 1024)  // Fallback without PSRAM
+#define UPLINK_DRAIN_PER_POLL   4           // Backlogged batches sent per task cycle
+#define UPLINK_BACKOFF_MIN_MS   1000
+#define UPLINK_BACKOFF_MAX_MS   60000
+#define UPLINK_TASK_STACK       6144
+#define UPLINK_TASK_PRIO        1
+#define UPLINK_TASK_CORE        0           // WiFi / lwIP core
+#define UPLINK_POLL_MS          20
+
+// ==========================================
+// UPLINK STATE
+// ==========================================
+
+/**
+ * One node report, as handed from the RX path to the uplink task
+ */
+struct UplinkReport {
+    uint16_t node_id;
+    uint16_t seq;
+    int16_t  rssi;
+    uint8_t  path;
+    uint8_t  via;
+    uint32_t ts_recv;
+    float    t;
+    float    h;
+    float    b;
+    float    w;
+};
+
+enum UplinkState : uint8_t {
+    UPLINK_WAIT_WIFI = 0,
+    UPLINK_BACKOFF,
+    UPLINK_CONNECTING,
+    UPLINK_CONNECTED
+};
+
+struct UplinkStats {
+    uint32_t reports;           // Accepted from the RX path
+    uint32_t queue_drops;       // Queue to the task was full
+    uint32_t batches;           // JSON batches built
+    uint32_t published;         // Batches delivered to the broker
+    uint32_t backlogged;        // Batches parked while offline
+    uint32_t backlog_drops;     // Oldest batches overwritten in the backlog
+    uint32_t connects;
+    uint32_t connect_failures;
+};
+
+SpscQueue<UplinkReport, UPLINK_QUEUE_LEN> uplink_queue;
+UplinkStats uplink_stats = {0, 0, 0, 0, 0, 0, 0, 0};
+UplinkState uplink_state = UPLINK_WAIT_WIFI;
+uint32_t uplink_backoff_ms = UPLINK_BACKOFF_MIN_MS;
+uint32_t uplink_retry_at = 0;
+uint32_t uplink_batch_seq = 0;
+TaskHandle_t uplink_task_handle = NULL;
+
+// Batch under construction (task-owned)
+StaticJsonDocument<UPLINK_BATCH_MAX_BYTES * 2> uplink_doc;
+uint32_t uplink_batch_start = 0;
+char uplink_payload[UPLINK_BATCH_MAX_BYTES];
+
+// ==========================================
+// BACKLOG RING
+// ==========================================
+
+/**
+ * Byte ring of length-prefixed batches: [len lo][len hi][payload...]
+ */
+struct UplinkBacklog {
+    uint8_t* buf;
+    uint32_t size;
+    uint32_t head;              // Write position
+    uint32_t tail;              // Oldest record
+    uint32_t used;
+    uint32_t records;
+};
+
+UplinkBacklog uplink_backlog = {NULL, 0, 0, 0, 0, 0};
+
+void uplink_backlog_copy_in(const uint8_t* data, uint32_t len) {
+    uint32_t first = min(len, uplink_backlog.size - uplink_backlog.head);
+    memcpy(uplink_backlog.buf + uplink_backlog.head, data, first);
+    memcpy(uplink_backlog.buf, data + first, len - first);
+    uplink_backlog.head = (uplink_backlog.head + len) % uplink_backlog.size;
+    uplink_backlog.used += len;
+}
+
+void uplink_backlog_copy_out(uint32_t pos, uint8_t* data, uint32_t len) {
+    uint32_t first = min(len, uplink_backlog.size - pos);
+    memcpy(data, uplink_backlog.buf + pos, first);
+    memcpy(data + first, uplink_backlog.buf, len - first);
+}
+
+uint16_t uplink_backlog_peek_len() {
+    uint8_t hdr[2];
+    uplink_backlog_copy_out(uplink_backlog.tail, hdr, 2);
+    return hdr[0] | ((uint16_t)hdr[1] << 8);
+}
+
+void uplink_backlog_drop_oldest() {
+    uint32_t rec = 2 + uplink_backlog_peek_len();
+    uplink_backlog.tail = (uplink_backlog.tail + rec) % uplink_backlog.size;
+    uplink_backlog.used -= rec;
+    uplink_backlog.records--;
+}
+
+/**
+ * Park a batch, overwriting the oldest ones if the ring is full
+ */
+void uplink_backlog_push(const char* payload, uint16_t len) {
+    if (!uplink_backlog.buf || (uint32_t)len + 2 > uplink_backlog.size) return;
+    while (uplink_backlog.size - uplink_backlog.used < (uint32_t)len + 2) {
+        uplink_backlog_drop_oldest();
+        uplink_stats.backlog_drops++;
+    }
+    uint8_t hdr[2] = { (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    uplink_backlog_copy_in(hdr, 2);
+    uplink_backlog_copy_in((const uint8_t*)payload, len);
+    uplink_backlog.records++;
+    uplink_stats.backlogged++;
+}
+
+/**
+ * Publish backlogged batches, oldest first; stops at the first failure
+ */
+void uplink_backlog_drain() {
+    for (int i = 0; i < UPLINK_DRAIN_PER_POLL && uplink_backlog.records > 0; i++) {
+        uint16_t len = uplink_backlog_peek_len();
+        uplink_backlog_copy_out((uplink_backlog.tail + 2) % uplink_backlog.size,
+                                (uint8_t*)uplink_payload, len);
+        if (!mqttClient.publish(UPLINK_TOPIC, (const uint8_t*)uplink_payload, len)) return;
+        uplink_backlog_drop_oldest();
+        uplink_stats.published++;
+    }
+}
+
+// ==========================================
+// BATCHING
+// ==========================================
+
+void uplink_batch_reset() {
+    uplink_doc.clear();
+    uplink_doc["gw"] = DEFAULT_DEVICE_ID;
+    uplink_doc.createNestedArray("nodes");
+}
+
+void uplink_batch_add(JsonArray nodes, const UplinkReport& r) {
+    JsonObject n = nodes.createNestedObject();
+    n["id"] = r.node_id;
+    n["seq"] = r.seq;
+    n["rssi"] = r.rssi;
+    n["path"] = node_path_name(r.path);
+    if (r.path == NODE_PATH_RELAY) n["via"] = r.via;
+    n["ts"] = r.ts_recv;
+    n["t"] = r.t;
+    n["h"] = r.h;
+    n["b"] = r.b;
+    n["w"] = r.w;
+}
+
+/**
+ * Serialise the pending batch and publish it (or park it in the backlog)
+ */
+void uplink_batch_flush() {
+    JsonArray nodes = uplink_doc["nodes"];
+    if (nodes.size() == 0) return;
+
+    uplink_doc["batch"] = uplink_batch_seq++;
+    size_t len = serializeJson(uplink_doc, uplink_payload, sizeof(uplink_payload));
+    uplink_stats.batches++;
+    uplink_batch_reset();
+
+    // Keep ordering: nothing new goes out ahead of the backlog
+    if (uplink_state == UPLINK_CONNECTED && uplink_backlog.records == 0 &&
+        mqttClient.publish(UPLINK_TOPIC, (const uint8_t*)uplink_payload, len)) {
+        uplink_stats.published++;
+        return;
+    }
+    uplink_backlog_push(uplink_payload, len);
+}
+
+/**
+ * Move queued reports into the batch, flushing on size or age
+ */
+void uplink_batch_collect() {
+    UplinkReport r;
+    while (uplink_queue.pop(&r)) {
+        JsonArray nodes = uplink_doc["nodes"];
+        if (nodes.size() == 0) uplink_batch_start = millis();
+        uplink_batch_add(nodes, r);
+
+        if (measureJson(uplink_doc) > UPLINK_BATCH_MAX_BYTES - 32) {
+            // Last report tipped it over: send the rest, start the next batch with it
+            nodes.remove(nodes.size() - 1);
+            uplink_batch_flush();
+            uplink_batch_start = millis();
+            uplink_batch_add(uplink_doc["nodes"], r);
+        } else if (nodes.size() >= UPLINK_BATCH_MAX_NODES) {
+            uplink_batch_flush();
+        }
+    }
+
+    JsonArray nodes = uplink_doc["nodes"];
+    if (nodes.size() > 0 && millis() - uplink_batch_start >= UPLINK_FLUSH_MS) {
+        uplink_batch_flush();
+    }
+}
+
+// ==========================================
+// CONNECTION STATE MACHINE
+// ==========================================
+
+void uplink_connection_step() {
+    uint32_t now = millis();
+
+    if (!sysStatus.wifi_connected) {
+        if (uplink_state == UPLINK_CONNECTED) mqttClient.disconnect();
+        uplink_state = UPLINK_WAIT_WIFI;
+        sysStatus.mqtt_connected = false;
+        return;
+    }
+
+    switch (uplink_state) {
+        case UPLINK_WAIT_WIFI:
+            uplink_backoff_ms = UPLINK_BACKOFF_MIN_MS;
+            uplink_state = UPLINK_CONNECTING;
+            break;
+
+        case UPLINK_BACKOFF:
+            if ((int32_t)(now - uplink_retry_at) >= 0) uplink_state = UPLINK_CONNECTING;
+            break;
+
+        case UPLINK_CONNECTING:
+            connect_mqtt();                 // One attempt; may block this task only
+            if (mqttClient.connected()) {
+                uplink_stats.connects++;
+                uplink_backoff_ms = UPLINK_BACKOFF_MIN_MS;
+                uplink_state = UPLINK_CONNECTED;
+            } else {
+                uplink_stats.connect_failures++;
+                uplink_retry_at = now + uplink_backoff_ms;
+                uplink_backoff_ms = min((uint32_t)UPLINK_BACKOFF_MAX_MS, uplink_backoff_ms * 2);
+                uplink_state = UPLINK_BACKOFF;
+            }
+            break;
+
+        case UPLINK_CONNECTED:
+            if (!mqttClient.loop()) {
+                Serial.println("[UPLINK] Broker connection lost");
+                sysStatus.mqtt_connected = false;
+                uplink_retry_at = now + uplink_backoff_ms;
+                uplink_state = UPLINK_BACKOFF;
+            }
+            break;
+    }
+}
+
+void uplink_task(void* arg) {
+    (void)arg;
+    uplink_batch_reset();
+    for (;;) {
+        uplink_connection_step();
+        if (uplink_state == UPLINK_CONNECTED) uplink_backlog_drain();
+        uplink_batch_collect();
+        vTaskDelay(pdMS_TO_TICKS(UPLINK_POLL_MS));
+    }
+}
+
+// ==========================================
+// UPLINK API
+// ==========================================
+
+/**
+ * Allocate the backlog and start the uplink task
+ * (call after mqttClient.setServer(); WiFi may connect later)
+ * @return true if the task started
+ */
+bool uplink_init() {
+    uint32_t size = UPLINK_BACKLOG_PSRAM;
+    uplink_backlog.buf = psramFound() ? (uint8_t*)ps_malloc(size) : NULL;
+    if (!uplink_backlog.buf) {
+        size = UPLINK_BACKLOG_SRAM;
+        uplink_backlog.buf = (uint8_t*)malloc(size);
+    }
+    uplink_backlog.size = uplink_backlog.buf ? size : 0;
+
+    mqttClient.setBufferSize(UPLINK_BATCH_MAX_BYTES + 64);   // Topic + MQTT header
+
+    if (xTaskCreatePinnedToCore(uplink_task, "uplink", UPLINK_TASK_STACK, NULL,
+                                UPLINK_TASK_PRIO, &uplink_task_handle, UPLINK_TASK_CORE) != pdPASS) {
+        Serial.println("[UPLINK] Task creation FAILED");
+        return false;
+    }
+
+    Serial.print("[UPLINK] Batched MQTT uplink ready, backlog ");
+    Serial.print(uplink_backlog.size / 1024);
+    Serial.println(" KB");
+    return true;
+}
+
+/**
+ * Queue a node's latest readings for the next batch (never blocks)
+ * @return false if the uplink queue is full
+ */
+bool uplink_report_node(uint16_t node_id, const NodeInfo& info) {
+    UplinkReport r;
+    r.node_id = node_id;
+    r.seq = info.seq;
+    r.rssi = info.rssi;
+    r.path = info.path;
+    r.via = info.via;
+    r.ts_recv = info.ts_recv;
+    r.t = info.t;
+    r.h = info.h;
+    r.b = info.b;
+    r.w = info.w;
+
+    if (!uplink_queue.push(r)) {
+        uplink_stats.queue_drops++;
+        return false;
+    }
+    uplink_stats.reports++;
+    return true;
+}
+
+void print_uplink_stats() {
+    static const char* states[] = {"WAIT_WIFI", "BACKOFF", "CONNECTING", "CONNECTED"};
+    Serial.print("[UPLINK] ");
+    Serial.print(states[uplink_state]);
+    Serial.print(" Rep:");
+    Serial.print(uplink_stats.reports);
+    Serial.print(" Batch:");
+    Serial.print(uplink_stats.batches);
+    Serial.print(" Pub:");
+    Serial.print(uplink_stats.published);
+    Serial.print(" Backlog:");
+    Serial.print(uplink_backlog.records);
+    Serial.print("/");
+    Serial.print(uplink_backlog.used / 1024);
+    Serial.print("KB Drop:");
+    Serial.print(uplink_stats.queue_drops + uplink_stats.backlog_drops);
+    Serial.print(" Conn:");
+    Serial.print(uplink_stats.connects);
+    Serial.print("/");
+    Serial.println(uplink_stats.connects + uplink_stats.connect_failures);
+}
+
+#endif // MQTT_UPLINK_H
@@ -0,0 +1,262 @@
+/**
+ * Message Deduplication
+ * Fixed-capacity seen-message set with O(1) lookup, insert and eviction
+ *
+ * - Ring buffer of (hash, time) in arrival order: eviction is a tail pop
+ * - Open-addressed hash set (linear probing, backward-shift delete) for
+ *   membership, so lookup cost does not grow with DEDUP_BUFFER_SIZE
+ * - Entries older than DEDUP_EXPIRY_MS are expired from the ring tail
+ *
+ * Every set entry has exactly one ring entry, so the set never holds more
+ * than DEDUP_BUFFER_SIZE hashes and stays at most half full. Keys are
+ * stored as hash + 1 (get_hash() never returns 0xFFFFFFFF), so a
+ * zero-initialised table is empty without an init call.
+ *
+ * The LoRa RX path uses per-sender sequence windows instead
+ * (msg_dedup_seq_check()). A wrapping 8-bit RadioHead id, or a report
+ * sequence restarting at 0 after a reboot, would otherwise collide with
+ * hashes still inside the 10-minute expiry.
+ */
+
+#ifndef MSG_DEDUP_H
+#define MSG_DEDUP_H
+
+#include <Arduino.h>
+#include "lora_config.h"
+
+// ==========================================
+// DEDUP CONFIGURATION
+// ==========================================
+
+#define DEDUP_TABLE_BITS 12                       // 4096 slots
+#define DEDUP_TABLE_SIZE (1u << DEDUP_TABLE_BITS)
+#define DEDUP_EXPIRY_MS  600000UL                 // Forget messages after 10 minutes
+#define DEDUP_EMPTY      0                        // Slots hold hash + 1, so zero-init is empty
+
+#define DEDUP_SEQ_WINDOW    32                    // Sequence numbers remembered behind the newest
+#define DEDUP_SEQ_RESYNC_MS 60000UL               // Sender silent this long: its next packet restarts the window
+#define DEDUP_SPACE_RH_ID   0                     // 8-bit RadioHead header id
+#define DEDUP_SPACE_REPORT  1                     // 16-bit spectral report sequence
+#define DEDUP_SPACES        2
+
+static_assert(DEDUP_TABLE_SIZE >= 2 * DEDUP_BUFFER_SIZE,
+              "DEDUP_TABLE_BITS too small: keep the hash set at most half full");
+
+// ==========================================
+// DEDUP STATE
+// ==========================================
+
+struct MsgDedupStats {
+  uint32_t lookups;
+  uint32_t duplicates;
+  uint32_t evicted;          // Dropped because the ring was full
+  uint32_t expired;          // Dropped by age
+  uint32_t max_probe;        // Longest probe sequence seen
+  uint32_t resyncs;          // Sequence windows restarted (reboot or long silence)
+};
+
+/**
+ * Recent sequence numbers of one sender
+ */
+struct DedupSeqWindow {
+  uint32_t seen;             // Bit n set: newest - n was received, 0 = never heard
+  uint32_t heard_ms;         // Last packet
+  uint16_t newest;
+};
+
+struct MsgDedup {
+  uint32_t ring_key[DEDUP_BUFFER_SIZE];
+  uint32_t ring_time[DEDUP_BUFFER_SIZE];
+  uint16_t ring_tail;        // Oldest entry
+  uint16_t ring_count;
+  uint32_t table[DEDUP_TABLE_SIZE];
+  MsgDedupStats stats;
+};
+
+MsgDedup msg_dedup;
+DedupSeqWindow msg_dedup_seq[DEDUP_SPACES][256];
+
+// ==========================================
+// HASH SET
+// ==========================================
+
+static inline uint32_t msg_dedup_home(uint32_t key) {
+  return (key * 0x9E3779B1u) >> (32 - DEDUP_TABLE_BITS);    // Fibonacci hashing
+}
+
+/**
+ * Probe for a key
+ * @return slot holding it, or the empty slot where it would go
+ */
+static inline uint32_t msg_dedup_find(uint32_t key) {
+  uint32_t i = msg_dedup_home(key);
+  uint32_t probe = 0;
+  while (msg_dedup.table[i] != DEDUP_EMPTY && msg_dedup.table[i] != key) {
+    i = (i + 1) & (DEDUP_TABLE_SIZE - 1);
+    probe++;
+  }
+  if (probe > msg_dedup.stats.max_probe) msg_dedup.stats.max_probe = probe;
+  return i;
+}
+
+/**
+ * Remove a key, shifting later members of its cluster back into the gap
+ * (no tombstones, so probe lengths do not degrade over time)
+ */
+void msg_dedup_erase(uint32_t key) {
+  uint32_t i = msg_dedup_find(key);
+  if (msg_dedup.table[i] == DEDUP_EMPTY) return;
+
+  uint32_t j = i;
+  for (;;) {
+    j = (j + 1) & (DEDUP_TABLE_SIZE - 1);
+    if (msg_dedup.table[j] == DEDUP_EMPTY) break;
+    uint32_t k = msg_dedup_home(msg_dedup.table[j]);
+    // Move j into the gap unless its home lies cyclically in (i, j]
+    bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+    if (!stays) {
+      msg_dedup.table[i] = msg_dedup.table[j];
+      i = j;
+    }
+  }
+  msg_dedup.table[i] = DEDUP_EMPTY;
+}
+
+// ==========================================
+// RING BUFFER
+// ==========================================
+
+void msg_dedup_pop_oldest() {
+  msg_dedup_erase(msg_dedup.ring_key[msg_dedup.ring_tail]);
+  msg_dedup.ring_tail = (msg_dedup.ring_tail + 1) % DEDUP_BUFFER_SIZE;
+  msg_dedup.ring_count--;
+}
+
+/**
+ * Drop entries older than DEDUP_EXPIRY_MS (oldest first, amortised O(1))
+ */
+void msg_dedup_expire(uint32_t now) {
+  while (msg_dedup.ring_count > 0 &&
+         now - msg_dedup.ring_time[msg_dedup.ring_tail] > DEDUP_EXPIRY_MS) {
+    msg_dedup_pop_oldest();
+    msg_dedup.stats.expired++;
+  }
+}
+
+// ==========================================
+// DEDUP API
+// ==========================================
+
+void msg_dedup_clear() {
+  for (uint32_t i = 0; i < DEDUP_TABLE_SIZE; i++) msg_dedup.table[i] = DEDUP_EMPTY;
+  msg_dedup.ring_tail = 0;
+  msg_dedup.ring_count = 0;
+  memset(&msg_dedup.stats, 0, sizeof(msg_dedup.stats));
+  memset(msg_dedup_seq, 0, sizeof(msg_dedup_seq));
+}
+
+/**
+ * Check whether a hash was seen within the expiry window
+ */
+bool msg_dedup_contains(uint32_t hash) {
+  msg_dedup_expire(millis());
+  msg_dedup.stats.lookups++;
+  uint32_t key = hash + 1;
+  return msg_dedup.table[msg_dedup_find(key)] == key;
+}
+
+/**
+ * Record a hash, evicting the oldest entry when full
+ * @return true if it was already present (duplicate, not re-recorded)
+ */
+bool msg_dedup_check_and_add(uint32_t hash) {
+  uint32_t now = millis();
+  msg_dedup_expire(now);
+  msg_dedup.stats.lookups++;
+
+  uint32_t key = hash + 1;
+  uint32_t slot = msg_dedup_find(key);
+  if (msg_dedup.table[slot] == key) {
+    msg_dedup.stats.duplicates++;
+    return true;
+  }
+
+  if (msg_dedup.ring_count == DEDUP_BUFFER_SIZE) {
+    msg_dedup_pop_oldest();
+    msg_dedup.stats.evicted++;
+    slot = msg_dedup_find(key);             // Erase may have shifted the cluster
+  }
+
+  msg_dedup.table[slot] = key;
+  uint16_t head = (msg_dedup.ring_tail + msg_dedup.ring_count) % DEDUP_BUFFER_SIZE;
+  msg_dedup.ring_key[head] = key;
+  msg_dedup.ring_time[head] = now;
+  msg_dedup.ring_count++;
+  return false;
+}
+
+/**
+ * Per-sender duplicate check on a wrapping sequence number
+ * A number up to DEDUP_SEQ_WINDOW behind the sender's newest is checked
+ * against the window. One further behind is taken as a reboot (the
+ * sequence restarted) and restarts the window, as does the first packet
+ * after DEDUP_SEQ_RESYNC_MS of silence.
+ * @param space DEDUP_SPACE_RH_ID or DEDUP_SPACE_REPORT
+ * @return true if the packet is a duplicate
+ */
+bool msg_dedup_seq_check(uint8_t space, uint8_t sender, uint16_t seq) {
+  DedupSeqWindow* w = &msg_dedup_seq[space][sender];
+  uint16_t mask = (space == DEDUP_SPACE_RH_ID) ? 0xFF : 0xFFFF;
+  uint32_t now = millis();
+  msg_dedup.stats.lookups++;
+
+  bool resync = w->seen == 0 || now - w->heard_ms > DEDUP_SEQ_RESYNC_MS;
+  w->heard_ms = now;
+  seq &= mask;
+  uint16_t ahead = (seq - w->newest) & mask;
+  uint16_t behind = (w->newest - seq) & mask;
+
+  if (!resync) {
+    if (ahead == 0) {
+      msg_dedup.stats.duplicates++;
+      return true;
+    }
+    if (ahead <= mask / 2) {
+      w->seen = (ahead < 32) ? (w->seen << ahead) | 1 : 1;
+      w->newest = seq;
+      return false;
+    }
+    if (behind < DEDUP_SEQ_WINDOW) {
+      uint32_t bit = 1UL << behind;
+      if (w->seen & bit) {
+        msg_dedup.stats.duplicates++;
+        return true;
+      }
+      w->seen |= bit;                        // Late copy, e.g. via a relay
+      return false;
+    }
+    msg_dedup.stats.resyncs++;
+  }
+  w->seen = 1;
+  w->newest = seq;
+  return false;
+}
+
+void print_msg_dedup_stats() {
+  Serial.print("[DEDUP] Entries:");
+  Serial.print(msg_dedup.ring_count);
+  Serial.print("/");
+  Serial.print(DEDUP_BUFFER_SIZE);
+  Serial.print(" Dup:");
+  Serial.print(msg_dedup.stats.duplicates);
+  Serial.print(" Evict:");
+  Serial.print(msg_dedup.stats.evicted);
+  Serial.print(" Exp:");
+  Serial.print(msg_dedup.stats.expired);
+  Serial.print(" MaxProbe:");
+  Serial.print(msg_dedup.stats.max_probe);
+  Serial.print(" Resync:");
+  Serial.println(msg_dedup.stats.resyncs);
+}
+
+#endif // MSG_DEDUP_H
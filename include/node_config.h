@@ -19,4 +19,9 @@
 #define VOLTAGE_HYSTERESIS       0.5
 #define MAX_CURRENT_LIMIT        30.0
 
+// ESP-NOW control role (espnow_control.h): 0 = off, 1 = master, 2 = node
+#ifndef ESPNOW_CONTROL_ROLE
+#define ESPNOW_CONTROL_ROLE      0
+#endif
+
 #endif
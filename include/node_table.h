@@ -0,0 +1,340 @@
+/**
+ * Node Table
+ * Fixed-capacity, open-addressed table of LoRa nodes with per-node
+ * reading history in PSRAM
+ *
+ * - Keys (node ids) live in their own compact array, so a lookup probes
+ *   a few adjacent 16-bit words instead of walking a tree
+ * - Records are plain structs (path is an integer code, no String), so an
+ *   update is a struct copy with no heap traffic
+ * - Each node keeps a ring of its last NODE_HISTORY_LEN readings in PSRAM;
+ *   pointers into the table and the rings are handed out directly
+ *
+ * Nodes are never removed individually (only node_table_clear()), so the
+ * table needs no tombstones.
+ */
+
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <Arduino.h>
+
+// ==========================================
+// NODE TABLE CONFIGURATION
+// ==========================================
+
+#define NODE_TABLE_BITS      9                        // 512 slots
+#define NODE_TABLE_CAPACITY  (1u << NODE_TABLE_BITS)
+#define NODE_TABLE_MAX_NODES (NODE_TABLE_CAPACITY * 3 / 4)  // Keep probes short
+#define NODE_HISTORY_LEN     32                       // Readings kept per node (PSRAM)
+
+// ==========================================
+// NODE DATA STRUCTURES
+// ==========================================
+
+/**
+ * Route a node's last message took
+ */
+enum NodePath : uint8_t {
+    NODE_PATH_UNKNOWN = 0,
+    NODE_PATH_DIRECT,       // Heard directly by this gateway
+    NODE_PATH_RELAY         // Forwarded by another node (see via)
+};
+
+inline const char* node_path_name(uint8_t path) {
+    switch (path) {
+        case NODE_PATH_DIRECT: return "DIRECT";
+        case NODE_PATH_RELAY:  return "RELAY";
+        default:               return "UNKNOWN";
+    }
+}
+
+/**
+ * Information from a single LoRa node
+ * Stores sensor readings and metadata
+ */
+struct NodeInfo {
+    float t;                // Temperature (°C) or Voltage (V)
+    float h;                // Humidity (%) - optional
+    float b;                // Battery (V) or Power (W)
+    float v;                // Voltage (V) - PZEM
+    float a;                // Current (A) - PZEM
+    float w;                // Power (W) - PZEM
+    float wh;               // Energy (Wh) - PZEM
+
+    int16_t rssi;           // Received Signal Strength (dBm)
+    uint8_t path;           // NodePath code
+    uint8_t via;            // Relay node ID (if relayed)
+    uint16_t seq;           // Sequence number
+
+    unsigned long ts_local; // Local timestamp (millis)
+    unsigned long ts_recv;  // Receive timestamp
+
+    // Constructor with defaults
+    NodeInfo() :
+        t(0), h(0), b(0), v(0), a(0), w(0), wh(0),
+        rssi(-130), path(NODE_PATH_UNKNOWN), via(0), seq(0),
+        ts_local(0), ts_recv(0) {}
+};
+
+/**
+ * One history entry - the readings of a NodeInfo at receive time
+ */
+struct NodeSample {
+    uint32_t ts_recv;
+    float    t;
+    float    h;
+    float    b;
+    float    w;
+    int16_t  rssi;
+    uint16_t seq;
+};
+
+// ==========================================
+// NODE TABLE STATE
+// ==========================================
+
+struct NodeTable {
+    uint16_t keys[NODE_TABLE_CAPACITY];         // Node id + 1, 0 = empty slot
+    NodeInfo info[NODE_TABLE_CAPACITY];
+    uint8_t  hist_head[NODE_TABLE_CAPACITY];    // Next write position per ring
+    uint8_t  hist_count[NODE_TABLE_CAPACITY];
+    NodeSample* history;                        // CAPACITY x history_len, PSRAM
+    uint8_t  history_len;                       // 0 if the rings could not be allocated
+    uint16_t count;
+    uint32_t full_drops;                        // Updates refused: table full
+};
+
+NodeTable node_table;
+
+// ==========================================
+// NODE TABLE FUNCTIONS
+// ==========================================
+
+/**
+ * Allocate the history rings (PSRAM when present)
+ * The table itself is static; without history it still works.
+ */
+bool node_table_init() {
+    size_t bytes = (size_t)NODE_TABLE_CAPACITY * NODE_HISTORY_LEN * sizeof(NodeSample);
+    if (psramFound()) {
+        node_table.history = (NodeSample*)ps_malloc(bytes);
+    }
+    node_table.history_len = node_table.history ? NODE_HISTORY_LEN : 0;
+
+    Serial.print("[Nodes] Table: ");
+    Serial.print(NODE_TABLE_MAX_NODES);
+    Serial.print(" nodes, history ");
+    if (node_table.history) {
+        Serial.print(NODE_HISTORY_LEN);
+        Serial.print(" readings/node in PSRAM (");
+        Serial.print(bytes / 1024);
+        Serial.println(" KB)");
+    } else {
+        Serial.println("disabled (no PSRAM)");
+    }
+    return node_table.history != NULL;
+}
+
+void node_table_clear() {
+    memset(node_table.keys, 0, sizeof(node_table.keys));
+    memset(node_table.hist_count, 0, sizeof(node_table.hist_count));
+    node_table.count = 0;
+}
+
+static inline uint32_t node_table_home(uint16_t key) {
+    return ((uint32_t)key * 0x9E3779B1u) >> (32 - NODE_TABLE_BITS);
+}
+
+/**
+ * Probe for a node
+ * @return slot holding it, or the empty slot where it would go
+ */
+static inline uint32_t node_table_probe(uint16_t key) {
+    uint32_t i = node_table_home(key);
+    while (node_table.keys[i] != 0 && node_table.keys[i] != key) {
+        i = (i + 1) & (NODE_TABLE_CAPACITY - 1);
+    }
+    return i;
+}
+
+/**
+ * Slot of a node
+ * @return slot index, or -1 if unknown
+ */
+int node_table_slot(int node_id) {
+    if (node_id < 0 || node_id >= 0xFFFF) return -1;
+    uint16_t key = node_id + 1;
+    uint32_t i = node_table_probe(key);
+    return (node_table.keys[i] == key) ? (int)i : -1;
+}
+
+/**
+ * Look up a node
+ * @return pointer into the table (valid until node_table_clear()), or NULL
+ */
+NodeInfo* node_table_find(int node_id) {
+    int slot = node_table_slot(node_id);
+    return (slot < 0) ? NULL : &node_table.info[slot];
+}
+
+/**
+ * Look up a node, adding a default record if it is new
+ * @return pointer into the table, or NULL if the table is full
+ */
+NodeInfo* node_table_upsert(int node_id) {
+    if (node_id < 0 || node_id >= 0xFFFF) return NULL;
+    uint16_t key = node_id + 1;
+    uint32_t i = node_table_probe(key);
+    if (node_table.keys[i] != key) {
+        if (node_table.count >= NODE_TABLE_MAX_NODES) {
+            node_table.full_drops++;
+            return NULL;
+        }
+        node_table.keys[i] = key;
+        node_table.info[i] = NodeInfo();
+        node_table.hist_head[i] = 0;
+        node_table.hist_count[i] = 0;
+        node_table.count++;
+    }
+    return &node_table.info[i];
+}
+
+/**
+ * Append a node's current readings to its history ring
+ */
+void node_history_push(int slot) {
+    if (node_table.history_len == 0) return;
+    const NodeInfo& n = node_table.info[slot];
+    NodeSample* s = &node_table.history[slot * node_table.history_len + node_table.hist_head[slot]];
+    s->ts_recv = n.ts_recv;
+    s->t = n.t;
+    s->h = n.h;
+    s->b = n.b;
+    s->w = n.w;
+    s->rssi = n.rssi;
+    s->seq = n.seq;
+    node_table.hist_head[slot] = (node_table.hist_head[slot] + 1) % node_table.history_len;
+    if (node_table.hist_count[slot] < node_table.history_len) node_table.hist_count[slot]++;
+}
+
+/**
+ * Parse the readings of a text payload into a NodeInfo
+ * Payload is "key=value" (or "key:value") pairs separated by ',', ';' or
+ * spaces, keys as in the uplink JSON: t h b v a w wh. Unknown keys and
+ * malformed values are skipped; fields not present are left untouched.
+ * @return number of readings parsed, 0 for binary payloads
+ */
+int node_info_parse_readings(NodeInfo* info, const uint8_t* data, size_t len) {
+    char text[128];
+    if (len >= sizeof(text)) len = sizeof(text) - 1;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] < 32 || data[i] > 126) return 0;
+    }
+    memcpy(text, data, len);
+    text[len] = '\0';
+
+    int parsed = 0;
+    char* p = text;
+    while (*p) {
+        while (*p == ',' || *p == ';' || *p == ' ') p++;
+        char* key = p;
+        while (*p && *p != '=' && *p != ':' && *p != ',' && *p != ';' && *p != ' ') p++;
+        if (*p != '=' && *p != ':') continue;
+        size_t key_len = p - key;
+        char* end;
+        float value = strtof(++p, &end);
+        if (end == p) continue;
+        p = end;
+
+        float* field = NULL;
+        if (key_len == 1) {
+            switch (key[0]) {
+                case 't': field = &info->t; break;
+                case 'h': field = &info->h; break;
+                case 'b': field = &info->b; break;
+                case 'v': field = &info->v; break;
+                case 'a': field = &info->a; break;
+                case 'w': field = &info->w; break;
+            }
+        } else if (key_len == 2 && key[0] == 'w' && key[1] == 'h') {
+            field = &info->wh;
+        }
+        if (field) {
+            *field = value;
+            parsed++;
+        }
+    }
+    return parsed;
+}
+
+/**
+ * Store a node's latest readings and add them to its history
+ * @return false if the node is new and the table is full
+ */
+bool node_table_record(int node_id, const NodeInfo& info) {
+    NodeInfo* n = node_table_upsert(node_id);
+    if (!n) return false;
+    *n = info;
+    node_history_push(n - node_table.info);
+    return true;
+}
+
+/**
+ * Number of readings held for a slot
+ */
+inline uint8_t node_history_count(int slot) {
+    return node_table.hist_count[slot];
+}
+
+/**
+ * A reading from a slot's history, 0 = newest
+ * @return pointer into the ring (overwritten by later updates), or NULL
+ */
+const NodeSample* node_history_get(int slot, uint8_t age) {
+    if (age >= node_table.hist_count[slot]) return NULL;
+    uint8_t len = node_table.history_len;
+    uint8_t pos = (node_table.hist_head[slot] + len - 1 - age) % len;
+    return &node_table.history[slot * len + pos];
+}
+
+/**
+ * Node id held by a slot (for iterating 0..NODE_TABLE_CAPACITY-1)
+ * @return node id, or -1 if the slot is empty
+ */
+inline int node_table_id(int slot) {
+    return node_table.keys[slot] ? (int)node_table.keys[slot] - 1 : -1;
+}
+
+void print_node_table() {
+    Serial.print("\n[Nodes] ");
+    Serial.print(node_table.count);
+    Serial.print("/");
+    Serial.print(NODE_TABLE_MAX_NODES);
+    Serial.print(" nodes, refused:");
+    Serial.println(node_table.full_drops);
+    for (int slot = 0; slot < (int)NODE_TABLE_CAPACITY; slot++) {
+        int id = node_table_id(slot);
+        if (id < 0) continue;
+        const NodeInfo& n = node_table.info[slot];
+        Serial.print("  Node ");
+        Serial.print(id);
+        Serial.print(": RSSI ");
+        Serial.print(n.rssi);
+        Serial.print(" ");
+        Serial.print(node_path_name(n.path));
+        if (n.path == NODE_PATH_RELAY) {
+            Serial.print(" via ");
+            Serial.print(n.via);
+        }
+        Serial.print(" seq ");
+        Serial.print(n.seq);
+        Serial.print(" history ");
+        Serial.print(node_history_count(slot));
+        Serial.print(" age ");
+        Serial.print((millis() - n.ts_recv) / 1000);
+        Serial.println(" s");
+    }
+}
+
+#endif // NODE_TABLE_H
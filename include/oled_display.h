@@ -10,7 +10,9 @@
 #include <Arduino.h>
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
+#include <Wire.h>
 #include "lora_config.h"
+#include "i2c_bus.h"
 
 // ==========================================
 // GLOBAL DISPLAY OBJECT
@@ -18,6 +20,157 @@
 
 extern Adafruit_SSD1306 display;
 
+// ==========================================
+// INCREMENTAL FLUSH (DIRTY REGIONS)
+// ==========================================
+// The panel contents are mirrored in oled_shadow[]. oled_flush() diffs
+// the Adafruit framebuffer against it and sends only the changed column
+// span of each changed page, instead of display()'s full 1 KB push.
+// Anything that calls display.display() directly must call
+// oled_invalidate() so the next flush resends the whole screen.
+// Flushes run at I2C_PRIO_DISPLAY and yield to sensor reads between chunks.
+
+#define OLED_PAGES       (SCREEN_HEIGHT / 8)
+#define OLED_I2C_CHUNK   32      // Data bytes per I2C transaction
+
+// Screens drawn by the helpers below vs. the live status layout
+#define OLED_SCREEN_NONE   0
+#define OLED_SCREEN_HELPER 1
+#define OLED_SCREEN_STATUS 2
+
+uint8_t oled_shadow[SCREEN_WIDTH * OLED_PAGES];
+bool oled_shadow_valid = false;
+uint8_t oled_active_screen = OLED_SCREEN_NONE;
+uint32_t oled_bytes_sent = 0;    // Framebuffer bytes pushed since boot
+
+/**
+ * Force the next oled_flush() to resend the full framebuffer
+ */
+void oled_invalidate() {
+    oled_shadow_valid = false;
+}
+
+/**
+ * Send one page's column span [col0, col1] from the framebuffer
+ * Caller holds the I2C bus at I2C_PRIO_DISPLAY.
+ * @return false if the bus was lost while yielding
+ */
+bool oled_send_region(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t* data) {
+    Wire.beginTransmission(OLED_I2C_ADDRESS);
+    Wire.write(0x00);                    // Control byte: command stream
+    Wire.write(SSD1306_COLUMNADDR);
+    Wire.write(col0);
+    Wire.write(col1);
+    Wire.write(SSD1306_PAGEADDR);
+    Wire.write(page);
+    Wire.write(page);
+    Wire.endTransmission();
+    
+    uint16_t remaining = col1 - col0 + 1;
+    while (remaining > 0) {
+        if (!i2c_bus_yield()) return false;  // Let a waiting sensor read in
+        uint8_t n = (remaining > OLED_I2C_CHUNK) ? OLED_I2C_CHUNK : remaining;
+        Wire.beginTransmission(OLED_I2C_ADDRESS);
+        Wire.write(0x40);                // Control byte: data stream
+        Wire.write(data, n);
+        Wire.endTransmission();
+        data += n;
+        remaining -= n;
+    }
+    oled_bytes_sent += col1 - col0 + 1;
+    return true;
+}
+
+/**
+ * Push only the parts of the framebuffer that differ from the panel
+ * @return number of framebuffer bytes sent
+ */
+uint16_t oled_flush() {
+    const uint8_t* fb = display.getBuffer();
+    uint16_t sent = 0;
+    
+    if (!i2c_bus_acquire(I2C_PRIO_DISPLAY)) return 0;
+    
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        const uint8_t* row = fb + page * SCREEN_WIDTH;
+        uint8_t* shadow = oled_shadow + page * SCREEN_WIDTH;
+        int16_t first = 0;
+        int16_t last = SCREEN_WIDTH - 1;
+        
+        if (oled_shadow_valid) {
+            while (first < SCREEN_WIDTH && row[first] == shadow[first]) first++;
+            if (first == SCREEN_WIDTH) continue;    // Page unchanged
+            while (row[last] == shadow[last]) last--;
+        }
+        
+        if (!oled_send_region(page, first, last, row + first)) {
+            oled_shadow_valid = false;   // Page half-sent - resend next time
+            return sent;                 // Bus already released by the failed yield
+        }
+        memcpy(shadow + first, row + first, last - first + 1);
+        sent += last - first + 1;
+    }
+    
+    i2c_bus_release();
+    oled_shadow_valid = true;
+    return sent;
+}
+
+/**
+ * Start a full-screen helper drawing: clear framebuffer, default text style
+ * @param screen OLED_SCREEN_* id (tells the status layout to redraw itself)
+ */
+void oled_begin_screen(uint8_t screen) {
+    oled_active_screen = screen;
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+}
+
+// ==========================================
+// FIELD-LEVEL RENDERING
+// ==========================================
+
+#define OLED_FIELD_MAX 10        // Max characters per field
+
+/**
+ * A fixed-position text field that is only re-rendered when its text changes
+ */
+struct OledField {
+    int16_t x;                   // Pixel position (6x8 font)
+    int16_t y;
+    uint8_t width;               // Field width in characters
+    char text[OLED_FIELD_MAX + 1];
+};
+
+/**
+ * Mark a field stale so the next oled_field_update() redraws it
+ */
+void oled_field_invalidate(OledField* f) {
+    f->text[0] = '\x01';         // Never produced by formatting
+    f->text[1] = '\0';
+}
+
+/**
+ * Render new text into a field if it differs from what is shown
+ * Only the field's own rectangle is cleared and redrawn.
+ * @return true if the framebuffer changed
+ */
+bool oled_field_update(OledField* f, const char* text) {
+    char clipped[OLED_FIELD_MAX + 1];
+    uint8_t width = (f->width > OLED_FIELD_MAX) ? OLED_FIELD_MAX : f->width;
+    strncpy(clipped, text, width);
+    clipped[width] = '\0';
+    
+    if (strcmp(clipped, f->text) == 0) return false;
+    
+    display.fillRect(f->x, f->y, width * 6, 8, SSD1306_BLACK);
+    display.setCursor(f->x, f->y);
+    display.print(clipped);
+    strcpy(f->text, clipped);
+    return true;
+}
+
 // ==========================================
 // DISPLAY INITIALIZATION
 // ==========================================
@@ -27,7 +180,12 @@ extern Adafruit_SSD1306 display;
  * @return true if display initialized successfully
  */
 bool init_oled_display() {
-    if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS)) {
+    bool ok = i2c_bus_acquire(I2C_PRIO_DISPLAY);  // Timed out: bus is not ours to release
+    if (ok) {
+        ok = display.begin(SSD1306_SWITCHCAPVCC, OLED_I2C_ADDRESS);
+        i2c_bus_release();
+    }
+    if (!ok) {
         Serial.println("[OLED] FAILED to initialize!");
         return false;
     }
@@ -37,7 +195,8 @@ bool init_oled_display() {
     display.clearDisplay();
     display.setCursor(0, 0);
     display.println("Initializing...");
-    display.display();
+    oled_invalidate();                   // Panel RAM is unknown after begin()
+    oled_flush();
     
     Serial.println("[OLED] Initialized (128x64, I2C Address: 0x3C)");
     return true;
@@ -52,12 +211,10 @@ bool init_oled_display() {
  * @param message Text to display
  */
 void oled_show_message(const char* message) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     display.setCursor(0, 0);
     display.println(message);
-    display.display();
+    oled_flush();
 }
 
 /**
@@ -66,9 +223,7 @@ void oled_show_message(const char* message) {
  * @param line2 Second line
  */
 void oled_show_message(const char* line1, const char* line2) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println(line1);
@@ -76,7 +231,7 @@ void oled_show_message(const char* line1, const char* line2) {
     display.setCursor(0, 16);
     display.println(line2);
     
-    display.display();
+    oled_flush();
 }
 
 /**
@@ -86,9 +241,7 @@ void oled_show_message(const char* line1, const char* line2) {
  * @param line3 Third line
  */
 void oled_show_message(const char* line1, const char* line2, const char* line3) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println(line1);
@@ -99,7 +252,7 @@ void oled_show_message(const char* line1, const char* line2, const char* line3)
     display.setCursor(0, 32);
     display.println(line3);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -125,13 +278,11 @@ void oled_boot_complete() {
  * @param error Error description
  */
 void oled_show_error(const char* error) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     display.setCursor(0, 0);
     display.println("!!! ERROR !!!");
     display.println(error);
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -144,9 +295,7 @@ void oled_show_error(const char* error) {
  * @param deviceId Device ID number
  */
 void oled_show_mode(int mode, int deviceId) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     if (mode == 0) {
@@ -159,7 +308,7 @@ void oled_show_mode(int mode, int deviceId) {
     display.print("Device ID: ");
     display.println(deviceId);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -171,9 +320,7 @@ void oled_show_mode(int mode, int deviceId) {
  * @param status true if LoRa OK
  */
 void oled_show_lora_status(bool status) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("LoRa Status");
@@ -185,7 +332,7 @@ void oled_show_lora_status(bool status) {
         display.println("Status: FAILED!");
     }
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -199,9 +346,7 @@ void oled_show_lora_status(bool status) {
  * @param seq Sequence number
  */
 void oled_show_packet_rx(int nodeId, int rssi, int seq) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.print("RX From Node ");
@@ -216,7 +361,7 @@ void oled_show_packet_rx(int nodeId, int rssi, int seq) {
     display.print("Seq: ");
     display.println(seq);
     
-    display.display();
+    oled_flush();
 }
 
 /**
@@ -226,9 +371,7 @@ void oled_show_packet_rx(int nodeId, int rssi, int seq) {
  * @param rssi Signal strength
  */
 void oled_show_sensor_data(int nodeId, float temperature, int rssi) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.print("Node ");
@@ -245,7 +388,7 @@ void oled_show_sensor_data(int nodeId, float temperature, int rssi) {
     display.print(rssi);
     display.println(" dBm");
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -259,9 +402,7 @@ void oled_show_sensor_data(int nodeId, float temperature, int rssi) {
  * @param nodeCount Active nodes
  */
 void oled_show_statistics(int rxCount, int txCount, int nodeCount) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("=== Statistics ===");
@@ -278,7 +419,7 @@ void oled_show_statistics(int rxCount, int txCount, int nodeCount) {
     display.print("Nodes: ");
     display.println(nodeCount);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -292,9 +433,7 @@ void oled_show_statistics(int rxCount, int txCount, int nodeCount) {
  * @param ip IP address
  */
 void oled_show_wifi_status(bool connected, const char* ssid, const char* ip) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("WiFi Status");
@@ -312,7 +451,7 @@ void oled_show_wifi_status(bool connected, const char* ssid, const char* ip) {
         display.println("Status: Disconnected");
     }
     
-    display.display();
+    oled_flush();
 }
 
 /**
@@ -321,9 +460,7 @@ void oled_show_wifi_status(bool connected, const char* ssid, const char* ip) {
  * @param apSsid AP SSID name
  */
 void oled_show_wifi_ap(const char* apIp, const char* apSsid) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("WiFi AP Mode");
@@ -336,7 +473,7 @@ void oled_show_wifi_ap(const char* apIp, const char* apSsid) {
     display.print("IP: ");
     display.println(apIp);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -349,9 +486,7 @@ void oled_show_wifi_ap(const char* apIp, const char* apSsid) {
  * @param broker MQTT broker address
  */
 void oled_show_mqtt_status(bool connected, const char* broker) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("MQTT Status");
@@ -367,7 +502,7 @@ void oled_show_mqtt_status(bool connected, const char* broker) {
     display.print("Broker: ");
     display.println(broker);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -381,9 +516,7 @@ void oled_show_mqtt_status(bool connected, const char* broker) {
  * @param deviceName BT device name
  */
 void oled_show_bluetooth_status(bool enabled, bool connected, const char* deviceName) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("Bluetooth Status");
@@ -400,7 +533,7 @@ void oled_show_bluetooth_status(bool enabled, bool connected, const char* device
     display.print("Name: ");
     display.println(deviceName);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -415,9 +548,7 @@ void oled_show_bluetooth_status(bool enabled, bool connected, const char* device
  * @param txCount Packets transmitted
  */
 void oled_show_system_info(int mode, int deviceId, int rxCount, int txCount) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     // Line 1: Mode and Device ID
     display.setCursor(0, 0);
@@ -439,7 +570,7 @@ void oled_show_system_info(int mode, int deviceId, int rxCount, int txCount) {
     display.setCursor(0, 25);
     display.println("Ready");
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -452,9 +583,7 @@ void oled_show_system_info(int mode, int deviceId, int rxCount, int txCount) {
  * @param message Status message
  */
 void oled_show_boot_progress(int step, const char* message) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("===== BOOT =====");
@@ -474,7 +603,7 @@ void oled_show_boot_progress(int step, const char* message) {
         display.fillRect(1, 57, barWidth - 2, 6, SSD1306_WHITE);
     }
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -487,9 +616,7 @@ void oled_show_boot_progress(int step, const char* message) {
  * @param message Alert message
  */
 void oled_show_alert(const char* title, const char* message) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.println("*** ALERT ***");
@@ -500,7 +627,7 @@ void oled_show_alert(const char* title, const char* message) {
     display.setCursor(0, 32);
     display.println(message);
     
-    display.display();
+    oled_flush();
 }
 
 /**
@@ -508,15 +635,13 @@ void oled_show_alert(const char* title, const char* message) {
  * @param message Notification message
  */
 void oled_show_notification(const char* message) {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    oled_begin_screen(OLED_SCREEN_HELPER);
     
     display.setCursor(0, 0);
     display.print(">>> ");
     display.println(message);
     
-    display.display();
+    oled_flush();
 }
 
 // ==========================================
@@ -536,12 +661,10 @@ void oled_scroll_text(const char* text, int speed = 100, int duration = 2000) {
     
     while (millis() - startTime < duration) {
         for (int x = maxX; x > -textLen * 6; x -= 2) {
-            display.clearDisplay();
-            display.setTextSize(1);
-            display.setTextColor(SSD1306_WHITE);
+            oled_begin_screen(OLED_SCREEN_HELPER);
             display.setCursor(x, 30);
             display.println(text);
-            display.display();
+            oled_flush();
             delay(speed);
         }
     }
@@ -551,14 +674,18 @@ void oled_scroll_text(const char* text, int speed = 100, int duration = 2000) {
  * Invert display colors
  */
 void oled_invert_display() {
+    if (!i2c_bus_acquire(I2C_PRIO_DISPLAY)) return;
     display.invertDisplay(true);
+    i2c_bus_release();
 }
 
 /**
  * Normal display colors
  */
 void oled_normal_display() {
+    if (!i2c_bus_acquire(I2C_PRIO_DISPLAY)) return;
     display.invertDisplay(false);
+    i2c_bus_release();
 }
 
 /**
@@ -569,7 +696,7 @@ void oled_normal_display() {
 void oled_blink_display(int count = 3, int speed = 100) {
     for (int i = 0; i < count; i++) {
         display.clearDisplay();
-        display.display();
+        oled_flush();
         delay(speed);
         
         // Redraw current content
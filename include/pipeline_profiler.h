@@ -0,0 +1,464 @@
+/**
+ * Pipeline Profiler
+ * Cycle-counter timings of every loop() stage, loop jitter, missed
+ * deadlines, heap fragmentation and task stack high-water marks
+ *
+ * Stages are timed with ESP.getCycleCount() laps:
+ *   uint32_t t = prof_now();
+ *   read_as7343();           t = prof_lap(PROF_READ, t);
+ *   as7343_agc_update();     t = prof_lap(PROF_AGC, t);
+ * Each lap costs a few dozen cycles (one CCOUNT read, a CLZ and a few
+ * adds into a fixed log-linear histogram), so profiling stays on in
+ * production builds. PROFILER_ENABLED=0 compiles every call away.
+ *
+ * Statistics cover a window: since the last 'P' print or stats packet.
+ * The all-time max per stage is kept separately. Send 'P' for the table.
+ * With PROF_REPORT_LORA=1 a compact stats packet goes out every
+ * PROF_REPORT_INTERVAL_MS; gateways print received ones. prof_build_json()
+ * gives the same data for MQTT.
+ */
+
+#ifndef PIPELINE_PROFILER_H
+#define PIPELINE_PROFILER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "lora_config.h"
+#include "lora_functions.h"
+#include "lora_rx_queue.h"
+
+// ==========================================
+// PROFILER CONFIGURATION
+// ==========================================
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#ifndef PROF_REPORT_LORA
+#define PROF_REPORT_LORA 0            // 1 = periodic stats packet to PROF_REPORT_DEST
+#endif
+
+#define PROF_REPORT_INTERVAL_MS 60000
+#define PROF_REPORT_DEST        GATEWAY_ADDRESS
+#define PROF_LOOP_DEADLINE_US   20000     // A loop() pass longer than this is a missed deadline
+#define PROF_MAX_TASKS          8         // Tasks whose stack high-water mark is tracked
+
+#define PROF_PACKET_TYPE        0xF1      // First byte; spectral reports start with their version
+#define PROF_PACKET_VERSION     2         // 2: PROF_SPECTRUM appended
+
+// Histogram: 4 sub-buckets per power of two from 128 cycles up (~25%
+// resolution, 0.5 us .. 17 s at 240 MHz); bucket 0 holds anything shorter
+#define PROF_HIST_MIN_BITS      7
+#define PROF_HIST_SUB_BITS      2
+#define PROF_HIST_BUCKETS       (1 + (32 - PROF_HIST_MIN_BITS) * (1 << PROF_HIST_SUB_BITS))
+
+// ==========================================
+// PROFILE STATE
+// ==========================================
+
+enum ProfStage : uint8_t {
+  PROF_LORA_RX = 0,     // check_lora_rx()
+  PROF_READ,            // read_as7343()
+  PROF_AGC,             // AGC + flicker
+  PROF_CALIBRATE,       // apply_spectral_calibration() + channel stats
+  PROF_INDICES,
+  PROF_HEALTH,
+  PROF_STATS,           // Index stats + frame log
+  PROF_OUTPUT,          // Telemetry frame / text report
+  PROF_DISPLAY,
+  PROF_IDLE,            // delay() at the end of loop()
+  PROF_LOOP,            // Whole loop() pass
+  PROF_FRAME,           // Data-ready -> frame fully processed
+  PROF_SPECTRUM,        // spectral_reconstruct_frame(); last so packet indices stay put
+  PROF_NUM_STAGES
+};
+
+const char* const prof_stage_names[PROF_NUM_STAGES] = {
+  "lora_rx", "read", "agc", "calibrate", "indices", "health",
+  "stats", "output", "display", "idle", "loop", "frame", "spectrum"
+};
+
+struct ProfStat {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint32_t max_all;                 // Since boot (never reset)
+  uint64_t sum;
+  uint32_t hist[PROF_HIST_BUCKETS];
+};
+
+struct ProfTask {
+  const char*  name;
+  TaskHandle_t handle;              // NULL = the task registering (loopTask)
+};
+
+struct PipelineProfile {
+  ProfStat stages[PROF_NUM_STAGES];
+  ProfTask tasks[PROF_MAX_TASKS];
+  uint8_t  num_tasks;
+  uint32_t cycles_per_us;
+  uint32_t window_start_ms;
+  uint32_t last_loop_start;         // Cycles at the previous loop() start
+  uint32_t period_max;              // Longest gap between loop() starts (cycles)
+  uint32_t missed_deadlines;        // loop() passes over PROF_LOOP_DEADLINE_US
+  uint32_t frame_overruns;          // Frames processed slower than the frame interval
+  uint32_t last_report_ms;
+  uint16_t report_seq;
+};
+
+PipelineProfile prof;
+
+// ==========================================
+// TIMING PRIMITIVES
+// ==========================================
+
+static inline uint32_t prof_now() {
+#if PROFILER_ENABLED
+  return ESP.getCycleCount();
+#else
+  return 0;
+#endif
+}
+
+static inline uint8_t prof_bucket(uint32_t cycles) {
+  if (cycles < (1UL << PROF_HIST_MIN_BITS)) return 0;
+  uint8_t msb = 31 - __builtin_clz(cycles);
+  uint8_t sub = (cycles >> (msb - PROF_HIST_SUB_BITS)) & ((1 << PROF_HIST_SUB_BITS) - 1);
+  return 1 + ((msb - PROF_HIST_MIN_BITS) << PROF_HIST_SUB_BITS) + sub;
+}
+
+/**
+ * Upper bound (cycles) of a histogram bucket
+ */
+static inline uint32_t prof_bucket_limit(uint8_t b) {
+  if (b == 0) return (1UL << PROF_HIST_MIN_BITS) - 1;
+  uint8_t msb = PROF_HIST_MIN_BITS + ((b - 1) >> PROF_HIST_SUB_BITS);
+  uint32_t sub = (b - 1) & ((1 << PROF_HIST_SUB_BITS) - 1);
+  uint32_t step = 1UL << (msb - PROF_HIST_SUB_BITS);
+  return (uint32_t)(((1ULL << PROF_HIST_SUB_BITS) + sub + 1) * step - 1);
+}
+
+static inline void prof_record(uint8_t stage, uint32_t cycles) {
+#if PROFILER_ENABLED
+  ProfStat* s = &prof.stages[stage];
+  if (s->count == 0 || cycles < s->min) s->min = cycles;
+  if (cycles > s->max) s->max = cycles;
+  if (cycles > s->max_all) s->max_all = cycles;
+  s->count++;
+  s->sum += cycles;
+  s->hist[prof_bucket(cycles)]++;
+#endif
+}
+
+/**
+ * Close a stage started at t
+ * @return the current time, so consecutive stages chain
+ */
+static inline uint32_t prof_lap(uint8_t stage, uint32_t t) {
+#if PROFILER_ENABLED
+  uint32_t now = ESP.getCycleCount();
+  prof_record(stage, now - t);
+  return now;
+#else
+  (void)stage;
+  return t;
+#endif
+}
+
+// ==========================================
+// LOOP / FRAME DEADLINES
+// ==========================================
+
+/**
+ * Call first thing in loop() - tracks the gap between passes
+ * @return start time for prof_loop_end()
+ */
+static inline uint32_t prof_loop_begin() {
+#if PROFILER_ENABLED
+  uint32_t now = ESP.getCycleCount();
+  if (prof.last_loop_start) {
+    uint32_t period = now - prof.last_loop_start;
+    if (period > prof.period_max) prof.period_max = period;
+  }
+  prof.last_loop_start = now;
+  return now;
+#else
+  return 0;
+#endif
+}
+
+static inline void prof_loop_end(uint32_t start) {
+#if PROFILER_ENABLED
+  uint32_t cycles = ESP.getCycleCount() - start;
+  prof_record(PROF_LOOP, cycles);
+  if (cycles > PROF_LOOP_DEADLINE_US * prof.cycles_per_us) prof.missed_deadlines++;
+#endif
+}
+
+/**
+ * Call when a frame is fully processed
+ * @param start       prof_now() when data-ready was seen
+ * @param interval_ms sensor frame interval (processing must fit in it)
+ */
+static inline void prof_frame_end(uint32_t start, uint32_t interval_ms) {
+#if PROFILER_ENABLED
+  uint32_t cycles = ESP.getCycleCount() - start;
+  prof_record(PROF_FRAME, cycles);
+  if (interval_ms > 0 && cycles > interval_ms * 1000UL * prof.cycles_per_us) prof.frame_overruns++;
+#endif
+}
+
+// ==========================================
+// PROFILER API
+// ==========================================
+
+void prof_reset_window() {
+  for (uint8_t i = 0; i < PROF_NUM_STAGES; i++) {
+    ProfStat* s = &prof.stages[i];
+    uint32_t keep = s->max_all;
+    memset(s, 0, sizeof(*s));
+    s->max_all = keep;
+  }
+  prof.period_max = 0;
+  prof.missed_deadlines = 0;
+  prof.frame_overruns = 0;
+  prof.window_start_ms = millis();
+}
+
+void prof_init() {
+  memset(&prof, 0, sizeof(prof));
+  prof.cycles_per_us = ESP.getCpuFreqMHz();
+  if (prof.cycles_per_us == 0) prof.cycles_per_us = 240;
+  prof.window_start_ms = millis();
+  prof.last_report_ms = millis();
+}
+
+/**
+ * Track a task's stack high-water mark (NULL = the calling task)
+ */
+void prof_register_task(const char* name, TaskHandle_t handle) {
+  if (prof.num_tasks >= PROF_MAX_TASKS) return;
+  prof.tasks[prof.num_tasks].name = name;
+  prof.tasks[prof.num_tasks].handle = handle ? handle : xTaskGetCurrentTaskHandle();
+  prof.num_tasks++;
+}
+
+/**
+ * Window percentile of a stage from its histogram (bucket upper bound)
+ * @return cycles
+ */
+uint32_t prof_percentile(const ProfStat* s, uint8_t pct) {
+  if (s->count == 0) return 0;
+  uint32_t target = (uint32_t)(((uint64_t)s->count * pct + 99) / 100);
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < PROF_HIST_BUCKETS; b++) {
+    seen += s->hist[b];
+    if (seen >= target) return min(prof_bucket_limit(b), s->max);
+  }
+  return s->max;
+}
+
+static inline uint32_t prof_us(uint32_t cycles) {
+  return cycles / prof.cycles_per_us;
+}
+
+/**
+ * Current heap / stack figures
+ */
+struct ProfMemory {
+  uint32_t free_heap;
+  uint32_t min_free_heap;
+  uint32_t largest_block;
+  uint8_t  fragmentation;           // 100 - largest * 100 / free (%)
+  uint32_t free_psram;
+};
+
+ProfMemory prof_memory() {
+  ProfMemory m;
+  m.free_heap = ESP.getFreeHeap();
+  m.min_free_heap = ESP.getMinFreeHeap();
+  m.largest_block = ESP.getMaxAllocHeap();
+  m.fragmentation = m.free_heap ? 100 - (uint8_t)((uint64_t)m.largest_block * 100 / m.free_heap) : 0;
+  m.free_psram = ESP.getFreePsram();
+  return m;
+}
+
+static inline uint32_t prof_stack_hwm(uint8_t task) {
+  return uxTaskGetStackHighWaterMark(prof.tasks[task].handle);   // Bytes on ESP-IDF
+}
+
+void print_pipeline_profile() {
+  uint32_t window_ms = millis() - prof.window_start_ms;
+  Serial.print("\n[PROF] Window ");
+  Serial.print(window_ms / 1000.0f, 1);
+  Serial.print(" s @ ");
+  Serial.print(prof.cycles_per_us);
+  Serial.println(" MHz   (us)      count     min    mean     p99     max  max_all");
+  for (uint8_t i = 0; i < PROF_NUM_STAGES; i++) {
+    const ProfStat* s = &prof.stages[i];
+    if (s->count == 0 && s->max_all == 0) continue;
+    Serial.printf("  %-10s %20lu %7lu %7lu %7lu %7lu %8lu\n", prof_stage_names[i],
+                  (unsigned long)s->count,
+                  (unsigned long)prof_us(s->min),
+                  (unsigned long)(s->count ? prof_us((uint32_t)(s->sum / s->count)) : 0),
+                  (unsigned long)prof_us(prof_percentile(s, 99)),
+                  (unsigned long)prof_us(s->max),
+                  (unsigned long)prof_us(s->max_all));
+  }
+  Serial.print("  Loop period max ");
+  Serial.print(prof_us(prof.period_max));
+  Serial.print(" us, missed deadlines (>");
+  Serial.print(PROF_LOOP_DEADLINE_US);
+  Serial.print(" us): ");
+  Serial.print(prof.missed_deadlines);
+  Serial.print(", frame overruns: ");
+  Serial.println(prof.frame_overruns);
+
+  ProfMemory m = prof_memory();
+  Serial.print("  Heap free ");
+  Serial.print(m.free_heap);
+  Serial.print(" (min ");
+  Serial.print(m.min_free_heap);
+  Serial.print(") largest block ");
+  Serial.print(m.largest_block);
+  Serial.print(" frag ");
+  Serial.print(m.fragmentation);
+  Serial.print("% PSRAM free ");
+  Serial.println(m.free_psram);
+
+  Serial.print("  Stack HWM (bytes):");
+  for (uint8_t i = 0; i < prof.num_tasks; i++) {
+    Serial.print(" ");
+    Serial.print(prof.tasks[i].name);
+    Serial.print("=");
+    Serial.print(prof_stack_hwm(i));
+  }
+  Serial.println();
+}
+
+// ==========================================
+// STATS PACKET
+// ==========================================
+
+/**
+ * Packet layout (little-endian), sealed like every LoRa packet:
+ *   [0] PROF_PACKET_TYPE  [1] version  [2] node id  [3-4] report seq
+ *   [5-8] uptime s  [9-10] window s
+ *   [11-12] free heap KB  [13-14] largest block KB  [15-16] min free KB
+ *   [17-18] missed deadlines  [19-20] frame overruns  [21-22] loop period max (100 us)
+ *   [23] stage count, then per stage: mean, p99, max (uint16 each, 10 us units, saturating)
+ *   then task count, per task: stack HWM (uint16 bytes)
+ */
+static inline void prof_put16(uint8_t* buf, size_t* pos, uint32_t v) {
+  if (v > 0xFFFF) v = 0xFFFF;
+  buf[(*pos)++] = v & 0xFF;
+  buf[(*pos)++] = v >> 8;
+}
+
+/**
+ * Serialise and seal the current window
+ * @return packet length, or 0 if it does not fit
+ */
+size_t prof_build_packet(uint8_t* buf, size_t cap) {
+  size_t need = 24 + PROF_NUM_STAGES * 6 + 1 + prof.num_tasks * 2 + 2;
+  if (cap < need) return 0;
+
+  ProfMemory m = prof_memory();
+  uint32_t up = millis() / 1000;
+  size_t pos = 0;
+  buf[pos++] = PROF_PACKET_TYPE;
+  buf[pos++] = PROF_PACKET_VERSION;
+  buf[pos++] = DEFAULT_DEVICE_ID;
+  prof_put16(buf, &pos, prof.report_seq++);
+  memcpy(buf + pos, &up, 4);
+  pos += 4;
+  prof_put16(buf, &pos, (millis() - prof.window_start_ms) / 1000);
+  prof_put16(buf, &pos, m.free_heap / 1024);
+  prof_put16(buf, &pos, m.largest_block / 1024);
+  prof_put16(buf, &pos, m.min_free_heap / 1024);
+  prof_put16(buf, &pos, prof.missed_deadlines);
+  prof_put16(buf, &pos, prof.frame_overruns);
+  prof_put16(buf, &pos, prof_us(prof.period_max) / 100);
+  buf[pos++] = PROF_NUM_STAGES;
+  for (uint8_t i = 0; i < PROF_NUM_STAGES; i++) {
+    const ProfStat* s = &prof.stages[i];
+    prof_put16(buf, &pos, s->count ? prof_us((uint32_t)(s->sum / s->count)) / 10 : 0);
+    prof_put16(buf, &pos, prof_us(prof_percentile(s, 99)) / 10);
+    prof_put16(buf, &pos, prof_us(s->max) / 10);
+  }
+  buf[pos++] = prof.num_tasks;
+  for (uint8_t i = 0; i < prof.num_tasks; i++) {
+    prof_put16(buf, &pos, prof_stack_hwm(i));
+  }
+  return lora_packet_seal(buf, pos, cap);
+}
+
+/**
+ * Print a received stats packet (already decrypted, CRC stripped)
+ * @return false if it is not a stats packet
+ */
+bool prof_print_packet(const uint8_t* buf, size_t len) {
+  if (len < 24 || buf[0] != PROF_PACKET_TYPE || buf[1] != PROF_PACKET_VERSION) return false;
+  uint8_t stages = buf[23];
+  if (len < 24 + (size_t)stages * 6 + 1) return false;
+
+  uint32_t up;
+  memcpy(&up, buf + 5, 4);
+  Serial.printf("[PROF] Node %u #%u up %lus window %us: heap %uK (block %uK, min %uK) "
+                "missed %u overruns %u period max %u00us\n",
+                buf[2], buf[3] | (buf[4] << 8), (unsigned long)up, buf[9] | (buf[10] << 8),
+                buf[11] | (buf[12] << 8), buf[13] | (buf[14] << 8), buf[15] | (buf[16] << 8),
+                buf[17] | (buf[18] << 8), buf[19] | (buf[20] << 8), buf[21] | (buf[22] << 8));
+  const uint8_t* p = buf + 24;
+  for (uint8_t i = 0; i < stages; i++, p += 6) {
+    Serial.printf("  %-10s mean %u0 p99 %u0 max %u0 us\n",
+                  i < PROF_NUM_STAGES ? prof_stage_names[i] : "?",
+                  p[0] | (p[1] << 8), p[2] | (p[3] << 8), p[4] | (p[5] << 8));
+  }
+  uint8_t tasks = *p++;
+  for (uint8_t i = 0; i < tasks && p + 2 <= buf + len; i++, p += 2) {
+    Serial.printf("  stack[%u] HWM %u bytes\n", i, p[0] | (p[1] << 8));
+  }
+  return true;
+}
+
+/**
+ * Window summary as JSON (for MQTT publishing)
+ * @return JSON length, or 0 if it did not fit
+ */
+size_t prof_build_json(char* out, size_t cap) {
+  ProfMemory m = prof_memory();
+  int n = snprintf(out, cap, "{\"node\":%d,\"window_s\":%lu,\"heap\":%lu,\"block\":%lu,\"frag\":%u,"
+                   "\"missed\":%lu,\"overruns\":%lu,\"stages\":{",
+                   DEFAULT_DEVICE_ID, (unsigned long)((millis() - prof.window_start_ms) / 1000),
+                   (unsigned long)m.free_heap, (unsigned long)m.largest_block, m.fragmentation,
+                   (unsigned long)prof.missed_deadlines, (unsigned long)prof.frame_overruns);
+  for (uint8_t i = 0; i < PROF_NUM_STAGES && n > 0 && (size_t)n < cap; i++) {
+    const ProfStat* s = &prof.stages[i];
+    n += snprintf(out + n, cap - n, "%s\"%s\":[%lu,%lu,%lu]", i ? "," : "", prof_stage_names[i],
+                  (unsigned long)(s->count ? prof_us((uint32_t)(s->sum / s->count)) : 0),
+                  (unsigned long)prof_us(prof_percentile(s, 99)),
+                  (unsigned long)prof_us(s->max));
+  }
+  if (n > 0 && (size_t)n < cap) n += snprintf(out + n, cap - n, "}}");
+  return (n > 0 && (size_t)n < cap) ? (size_t)n : 0;
+}
+
+/**
+ * Call from loop(): sends the stats packet and starts a new window every
+ * PROF_REPORT_INTERVAL_MS (when PROF_REPORT_LORA is set)
+ */
+void prof_poll() {
+#if PROFILER_ENABLED && PROF_REPORT_LORA
+  if (millis() - prof.last_report_ms < PROF_REPORT_INTERVAL_MS) return;
+  prof.last_report_ms = millis();
+  uint8_t buf[MAX_PACKET_LEN];
+  size_t len = prof_build_packet(buf, sizeof(buf));
+  if (len > 0) lora_radio_send(buf, len, PROF_REPORT_DEST);
+  prof_reset_window();
+#endif
+}
+
+#endif // PIPELINE_PROFILER_H
@@ -0,0 +1,404 @@
+/**
+ * Dual-Core Staged Pipeline
+ * Acquisition and DSP on core 1; output, radio and display on core 0
+ *
+ *   core 1  acq_dsp  AS7343 INT -> read -> AGC / flicker -> calibration ->
+ *                    indices -> health -> stats, frame log, binary
+ *                    telemetry -> pooled PipelineFrame
+ *   core 0  output   frame -> text report, report policy -> LoRa; then the
+ *                    network hook (LoRa RX drain, profiler packet)
+ *   core 0  display  latest snapshot -> OLED every PIPE_DISPLAY_MS
+ *
+ * Frames travel through a preallocated pool with free / ready SPSC queues
+ * (the lora_rx_queue.h pattern); the display gets its own by-value
+ * snapshot queue. The acquisition stage never waits: with no free frame
+ * or a full snapshot queue the result is dropped for that stage and
+ * counted, while AGC, stats and the frame log still see every frame.
+ *
+ * Consumers read only their frame copy - the globals belong to core 1.
+ * Console commands that touch them are posted to the acquisition task
+ * (pipeline_post_command()) and run there between frames; commands on
+ * output-side state (node table, report policy) go to the output task.
+ * pipeline_acquire() / pipeline_output() are the same steps loop() runs
+ * when the pipeline is off (duty-cycle and sensor-array builds).
+ */
+
+#ifndef PIPELINE_STAGES_H
+#define PIPELINE_STAGES_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "lora_config.h"
+#include "as7343_sensor.h"
+#include "as7343_agc.h"
+#include "as7343_flicker.h"
+#include "spectral_analysis.h"
+#include "spectral_reconstruct.h"
+#include "spectral_stats.h"
+#include "spectral_codec.h"
+#include "telemetry.h"
+#include "framelog.h"
+#include "boot_profiler.h"
+#include "duty_cycle.h"
+#include "report_policy.h"
+#include "pipeline_profiler.h"
+#include "spsc_queue.h"
+
+// ==========================================
+// PIPELINE CONFIGURATION
+// ==========================================
+
+#ifndef PIPELINE_ENABLED
+#define PIPELINE_ENABLED 1
+#endif
+
+// Duty-cycle wakes and the mux array keep the single loop()
+#define PIPELINE_ACTIVE (PIPELINE_ENABLED && !DUTY_CYCLE_ENABLED && !AS7343_ARRAY_ENABLED)
+
+#define PIPE_POOL_SIZE        8       // Frames in flight to the output stage (power of two)
+#define PIPE_DISPLAY_QUEUE    4       // Snapshots waiting for the display (power of two)
+#define PIPE_PRINT_INTERVAL   500     // Text report throttle, as SENSOR_PRINT_INTERVAL
+#define PIPE_DISPLAY_MS       250     // OLED refresh period
+#define PIPE_ACQ_POLL_MS      2       // Data-ready poll without the INT pin
+#define PIPE_OUTPUT_POLL_MS   10      // Network hook period when no frames arrive
+#define PIPE_CMD_QUEUE        8       // Console commands waiting for a stage task
+
+#define PIPE_ACQ_STACK        6144
+#define PIPE_ACQ_PRIO         10      // Core 1 - above loop(), nothing else competes
+#define PIPE_ACQ_CORE         1
+#define PIPE_OUTPUT_STACK     6144
+#define PIPE_OUTPUT_PRIO      3
+#define PIPE_OUTPUT_CORE      0
+#define PIPE_DISPLAY_STACK    4096
+#define PIPE_DISPLAY_PRIO     2
+#define PIPE_DISPLAY_CORE     0
+
+// ==========================================
+// FRAME OBJECTS
+// ==========================================
+
+/**
+ * Everything the output stage needs from one processed frame
+ */
+struct PipelineFrame {
+  AS7343Frame    frame;
+  AS7343Exposure exposure;
+  uint16_t       ch[AS7343_NUM_CHANNELS];       // Raw counts
+  float          cal[SPECTRAL_NUM_BANDS];       // Calibrated channels
+  float          clear;                         // Calibrated clear channel
+  float          indices[SPECTRAL_NUM_INDICES];
+  SpectralFeatures features;                    // Reconstructed-spectrum features
+  HealthLevels   health;
+  AS7343AgcState agc;                           // State behind the text report
+  AS7343FlickerState flicker;
+  I2cBusStats    bus;
+  bool           summary;                       // A stats window closed on this frame
+  SpectralSummary stats;                        // That window (valid when summary is set)
+  uint32_t       start_cycles;                  // Data-ready seen (prof_now())
+  uint32_t       ready_us;                      // DSP finished (micros())
+};
+
+/**
+ * What the OLED shows
+ */
+struct PipelineDisplay {
+  float        indices[SPECTRAL_NUM_INDICES];
+  float        clear;
+  HealthLevels health;
+};
+
+struct PipelineStats {
+  uint32_t frames;              // Valid frames processed on core 1
+  uint32_t output_drops;        // No free frame - output stage behind
+  uint32_t display_drops;       // Snapshot queue full - display behind
+  uint32_t max_ready;           // High-water mark of the output queue
+  uint32_t output_lag_us;       // DSP done -> output stage picked it up (last)
+  uint32_t max_output_lag_us;
+  uint32_t max_output_us;       // Longest output pass on one frame
+};
+
+typedef void (*pipe_display_fn)(const PipelineDisplay* d);
+typedef void (*pipe_hook_fn)();
+typedef void (*pipe_cmd_fn)(char cmd);
+typedef void (*pipe_frame_fn)(const PipelineFrame& f);
+
+PipelineFrame pipe_pool[PIPE_POOL_SIZE];
+PipelineFrame pipe_scratch;                              // Used while the pool is exhausted
+SpscQueue<uint8_t, PIPE_POOL_SIZE> pipe_free;            // Output -> acquisition
+SpscQueue<uint8_t, PIPE_POOL_SIZE> pipe_ready;           // Acquisition -> output
+SpscQueue<PipelineDisplay, PIPE_DISPLAY_QUEUE> pipe_display_q;
+SpscQueue<char, PIPE_CMD_QUEUE> pipe_cmd_q;              // loop() -> acquisition
+SpscQueue<char, PIPE_CMD_QUEUE> pipe_out_cmd_q;          // loop() -> output
+PipelineStats pipe_stats;
+TaskHandle_t pipe_acq_handle = NULL;
+TaskHandle_t pipe_output_handle = NULL;
+TaskHandle_t pipe_display_handle = NULL;
+pipe_display_fn pipe_display_hook = NULL;
+pipe_hook_fn pipe_net_hook = NULL;
+pipe_cmd_fn pipe_cmd_hook = NULL;
+pipe_frame_fn pipe_frame_hook = NULL;                    // Extra consumer of each output frame
+
+// ==========================================
+// STAGE WORK
+// ==========================================
+
+/**
+ * Acquisition + DSP for one data-ready frame (profiled per stage)
+ * @param f filled with the processed frame
+ * @return true if a valid frame was processed
+ */
+bool pipeline_acquire(PipelineFrame* f) {
+  uint32_t start = prof_now();
+  if (!as7343_data_ready() || !read_as7343()) return false;
+  uint32_t t = prof_lap(PROF_READ, start);
+  bool valid = as7343_agc_update();        // Drops frames taken during an exposure change
+  as7343_flicker_update();                 // May realign ASTEP for the next frames
+  t = prof_lap(PROF_AGC, t);
+  if (!valid) return false;
+
+  boot_first_frame();                      // Power-on -> first frame budget
+  apply_spectral_calibration();            // Build calibrated frame (and feed any capture)
+  spectral_stats_update_channels(spectral_ch);  // Running stats, optional filter
+  t = prof_lap(PROF_CALIBRATE, t);
+  calculate_all_indices();
+  t = prof_lap(PROF_INDICES, t);
+  spectral_reconstruct_frame();            // Full spectrum + red-edge features
+  t = prof_lap(PROF_SPECTRUM, t);
+  calculate_health_levels();
+  t = prof_lap(PROF_HEALTH, t);
+  f->summary = spectral_stats_update_indices(spectral_indices, as7343_frame.timestamp_ms);
+  framelog_append();                       // Batched into flash, one page write per 16 frames
+  if (telemetry_mode == TELEMETRY_BINARY) {
+    telemetry_send_frame();                // Non-blocking UART ring
+  }
+  prof_lap(PROF_STATS, t);
+
+  f->frame = as7343_frame;
+  f->exposure = as7343_exposure;
+  memcpy(f->ch, as7343_ch, sizeof(f->ch));
+  memcpy(f->cal, spectral_ch, sizeof(f->cal));
+  f->clear = spectral_ch[CH_CLEAR];
+  memcpy(f->indices, spectral_indices, sizeof(f->indices));
+  f->features = spectral_features;
+  f->health = health_levels;
+  f->agc = as7343_agc;
+  f->flicker = as7343_flicker;
+  f->bus = i2c_bus_stats;
+  if (f->summary) f->stats = spectral_summary;
+  f->start_cycles = start;
+  f->ready_us = micros();
+  return true;
+}
+
+/**
+ * Output for one frame: throttled text report, window summary and the
+ * report-policy uplink (duty-cycle builds send from duty_cycle_after_frame())
+ */
+void pipeline_output(PipelineFrame* f) {
+  static uint32_t last_print = 0;
+  uint32_t t = prof_now();
+
+  if (telemetry_mode == TELEMETRY_TEXT) {
+    uint32_t now = millis();
+    if (now - last_print >= PIPE_PRINT_INTERVAL) {
+      // Text report is throttled - 115200 baud cannot keep up with every frame
+      print_index_inputs(f->ch);
+      print_as7343_data(f->frame, f->ch, f->exposure);
+      print_as7343_agc(f->agc, f->exposure);
+      print_as7343_flicker(f->flicker);
+      print_i2c_bus_stats(f->bus);
+      print_vegetation_indices(f->indices, f->clear);
+      print_spectral_features(f->features);
+      print_health_description(f->health);
+      last_print = now;
+    }
+    if (f->summary) {
+      print_spectral_summary(f->stats);    // Next window closes STATS_WINDOW_FRAMES frames later
+    }
+  }
+#if !DUTY_CYCLE_ENABLED
+  SpectralReport report;
+  spectral_report_fill(&report, DEFAULT_DEVICE_ID, 0, f->frame.astatus, f->exposure.atime,
+                       f->ch, f->indices, f->health);
+  report_policy_send(&report);             // LoRa report only when something changed
+#endif
+  if (pipe_frame_hook) pipe_frame_hook(*f);  // e.g. web_stream_frame()
+  prof_lap(PROF_OUTPUT, t);
+}
+
+// ==========================================
+// STAGE TASKS
+// ==========================================
+
+void pipe_acq_task(void* arg) {
+  (void)arg;
+  int16_t held = -1;                       // Pool slot being filled
+  as7343_notify_task = xTaskGetCurrentTaskHandle();
+
+  for (;;) {
+    char cmd;
+    while (pipe_cmd_q.pop(&cmd)) {
+      if (pipe_cmd_hook) pipe_cmd_hook(cmd);   // Between frames, outside the loop timing
+    }
+    uint32_t idle = prof_now();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPE_ACQ_POLL_MS));
+    uint32_t loop_start = prof_lap(PROF_IDLE, idle);
+    prof_loop_begin();
+
+    uint8_t idx;
+    if (held < 0 && pipe_free.pop(&idx)) held = idx;
+    PipelineFrame* f = held >= 0 ? &pipe_pool[held] : &pipe_scratch;
+    if (!pipeline_acquire(f)) continue;
+    pipe_stats.frames++;
+
+    PipelineDisplay d;
+    memcpy(d.indices, f->indices, sizeof(d.indices));
+    d.clear = f->clear;
+    d.health = f->health;
+    if (!pipe_display_q.push(d)) pipe_stats.display_drops++;
+
+    if (held >= 0) {
+      pipe_ready.push((uint8_t)held);      // Cannot fail - at most POOL_SIZE slots exist
+      held = -1;
+      uint32_t queued = pipe_ready.size();
+      if (queued > pipe_stats.max_ready) pipe_stats.max_ready = queued;
+      xTaskNotifyGive(pipe_output_handle);
+    } else {
+      pipe_stats.output_drops++;
+    }
+    prof_frame_end(f->start_cycles, f->frame.interval_ms);
+    prof_loop_end(loop_start);
+  }
+}
+
+void pipe_output_task(void* arg) {
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPE_OUTPUT_POLL_MS));
+    char cmd;
+    while (pipe_out_cmd_q.pop(&cmd)) {
+      if (pipe_cmd_hook) pipe_cmd_hook(cmd);
+    }
+    uint8_t idx;
+    while (pipe_ready.pop(&idx)) {
+      PipelineFrame* f = &pipe_pool[idx];
+      uint32_t start = micros();
+      pipe_stats.output_lag_us = start - f->ready_us;
+      if (pipe_stats.output_lag_us > pipe_stats.max_output_lag_us) {
+        pipe_stats.max_output_lag_us = pipe_stats.output_lag_us;
+      }
+      pipeline_output(f);
+      pipe_free.push(idx);
+      uint32_t dt = micros() - start;
+      if (dt > pipe_stats.max_output_us) pipe_stats.max_output_us = dt;
+    }
+    if (pipe_net_hook) pipe_net_hook();
+  }
+}
+
+void pipe_display_task(void* arg) {
+  (void)arg;
+  PipelineDisplay latest;
+  bool have = false;
+  TickType_t wake = xTaskGetTickCount();
+
+  for (;;) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(PIPE_DISPLAY_MS));
+    PipelineDisplay d;
+    while (pipe_display_q.pop(&d)) {
+      latest = d;
+      have = true;
+    }
+    if (!have || !pipe_display_hook) continue;
+    uint32_t t = prof_now();
+    pipe_display_hook(&latest);
+    prof_lap(PROF_DISPLAY, t);
+  }
+}
+
+// ==========================================
+// PIPELINE API
+// ==========================================
+
+/**
+ * Start the three stage tasks (call at the end of setup())
+ * @param display draws one snapshot on the OLED (display task, core 0)
+ * @param net runs after each output pass (output task, core 0)
+ * @param cmd runs a posted console command (on the task it was posted to)
+ * @return true if successful
+ */
+bool pipeline_start(pipe_display_fn display, pipe_hook_fn net, pipe_cmd_fn cmd) {
+  pipe_display_hook = display;
+  pipe_net_hook = net;
+  pipe_cmd_hook = cmd;
+  for (uint8_t i = 0; i < PIPE_POOL_SIZE; i++) {
+    pipe_free.push(i);
+  }
+
+  if (xTaskCreatePinnedToCore(pipe_output_task, "output", PIPE_OUTPUT_STACK, NULL,
+                              PIPE_OUTPUT_PRIO, &pipe_output_handle, PIPE_OUTPUT_CORE) != pdPASS ||
+      xTaskCreatePinnedToCore(pipe_display_task, "display", PIPE_DISPLAY_STACK, NULL,
+                              PIPE_DISPLAY_PRIO, &pipe_display_handle, PIPE_DISPLAY_CORE) != pdPASS ||
+      xTaskCreatePinnedToCore(pipe_acq_task, "acq_dsp", PIPE_ACQ_STACK, NULL,
+                              PIPE_ACQ_PRIO, &pipe_acq_handle, PIPE_ACQ_CORE) != pdPASS) {
+    Serial.println("[PIPE] Task creation FAILED");
+    return false;
+  }
+  prof_register_task("acq_dsp", pipe_acq_handle);
+  prof_register_task("output", pipe_output_handle);
+  prof_register_task("display", pipe_display_handle);
+
+  Serial.print("[PIPE] Acquisition + DSP on core ");
+  Serial.print(PIPE_ACQ_CORE);
+  Serial.print(", output + display on core ");
+  Serial.print(PIPE_OUTPUT_CORE);
+  Serial.print(" (");
+  Serial.print(PIPE_POOL_SIZE);
+  Serial.println(" frames)");
+  return true;
+}
+
+/**
+ * Run a console command on the acquisition task (call from loop() only -
+ * the queue has a single producer)
+ * @return false if the queue is full
+ */
+bool pipeline_post_command(char cmd) {
+  if (!pipe_cmd_q.push(cmd)) return false;
+  if (pipe_acq_handle) xTaskNotifyGive(pipe_acq_handle);
+  return true;
+}
+
+/**
+ * Run a console command on the output task, next to the RX drain and the
+ * report policy (call from loop() only)
+ * @return false if the queue is full
+ */
+bool pipeline_post_output_command(char cmd) {
+  if (!pipe_out_cmd_q.push(cmd)) return false;
+  if (pipe_output_handle) xTaskNotifyGive(pipe_output_handle);
+  return true;
+}
+
+void print_pipeline_stats() {
+  Serial.print("[PIPE] Frames:");
+  Serial.print(pipe_stats.frames);
+  Serial.print(" OutDrop:");
+  Serial.print(pipe_stats.output_drops);
+  Serial.print(" DispDrop:");
+  Serial.print(pipe_stats.display_drops);
+  Serial.print(" MaxQ:");
+  Serial.print(pipe_stats.max_ready);
+  Serial.print("/");
+  Serial.print(PIPE_POOL_SIZE);
+  Serial.print(" Lag:");
+  Serial.print(pipe_stats.output_lag_us);
+  Serial.print("us (max ");
+  Serial.print(pipe_stats.max_output_lag_us);
+  Serial.print(") MaxOut:");
+  Serial.print(pipe_stats.max_output_us);
+  Serial.println("us");
+}
+
+#endif // PIPELINE_STAGES_H
@@ -0,0 +1,237 @@
+/**
+ * Change-Driven Report Policy
+ * Decides per frame whether a spectral report is worth sending
+ *
+ * A report goes out when:
+ *   - any health level (vigor / chlorophyll / stress / water) changed
+ *   - an index moved beyond its deadband since the last report
+ *   - REPORT_HEARTBEAT_MS passed without one (keepalive)
+ *   - REPORT_MAX_SUPPRESSED frames in a row were suppressed
+ * Otherwise the frame is counted and dropped. Comparisons are against the
+ * last report sent, not the previous frame, so slow drift still crosses
+ * the deadband eventually. Reports are always full (spectral_codec.h is
+ * stateless), so a suppressed frame never leaves the gateway with a gap.
+ *
+ * The state is plain data, carried through deep sleep in the duty-cycle
+ * RTC block; report_clock_ms() keeps counting across sleep.
+ */
+
+#ifndef REPORT_POLICY_H
+#define REPORT_POLICY_H
+
+#include <Arduino.h>
+#include <sys/time.h>
+#include "spectral_analysis.h"
+#include "spectral_codec.h"
+#include "lora_functions.h"
+#include "lora_rx_queue.h"
+
+// ==========================================
+// POLICY CONFIGURATION
+// ==========================================
+
+#ifndef REPORT_POLICY_ENABLED
+#define REPORT_POLICY_ENABLED 1           // 0 = report every frame
+#endif
+
+#ifndef REPORT_UPLINK_ENABLED
+#define REPORT_UPLINK_ENABLED 0           // Send reports from loop() (duty cycle always sends)
+#endif
+
+#define REPORT_HEARTBEAT_MS       300000  // Keepalive - gateway sees the node at least this often
+#define REPORT_MAX_SUPPRESSED     60      // Forced report after this many quiet frames
+
+// Default deadbands by index formula (absolute, in index units)
+#ifndef REPORT_DEADBAND_NORM_DIFF
+#define REPORT_DEADBAND_NORM_DIFF 0.02f   // -1..1 indices
+#endif
+#ifndef REPORT_DEADBAND_RATIO
+#define REPORT_DEADBAND_RATIO     0.05f
+#endif
+#ifndef REPORT_DEADBAND_INV_DIFF
+#define REPORT_DEADBAND_INV_DIFF  0.002f  // 1/a - 1/b stays small in calibrated units
+#endif
+
+enum ReportReason : uint8_t {
+  REPORT_SUPPRESS = 0,
+  REPORT_FIRST,
+  REPORT_HEALTH,                          // A health level changed
+  REPORT_DEADBAND,                        // An index left its deadband
+  REPORT_HEARTBEAT,
+  REPORT_FORCED,                          // REPORT_MAX_SUPPRESSED reached
+  REPORT_REASON_COUNT
+};
+
+// ==========================================
+// POLICY STATE
+// ==========================================
+
+struct ReportPolicyState {
+  bool     have_baseline;
+  float    sent_indices[SPECTRAL_NUM_INDICES];   // Values in the last report
+  uint8_t  sent_levels[4];
+  uint32_t sent_ms;                       // report_clock_ms() of the last report
+  uint16_t suppressed;                    // Frames since the last report
+  uint32_t frames;
+  uint32_t reasons[REPORT_REASON_COUNT];  // [REPORT_SUPPRESS] = suppressed total
+};
+
+ReportPolicyState report_policy;
+float report_deadband[SPECTRAL_NUM_INDICES];   // <= 0: slot not compared
+
+// ==========================================
+// POLICY FUNCTIONS
+// ==========================================
+
+/**
+ * Milliseconds on the system clock, which (unlike millis()) keeps running
+ * through deep sleep
+ */
+uint32_t report_clock_ms() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (uint32_t)tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+}
+
+/**
+ * Deadbands from the index table formulas (keeps report_policy state)
+ */
+void report_policy_init() {
+  for (uint8_t i = 0; i < SPECTRAL_NUM_INDICES; i++) {
+    report_deadband[i] = 0.0f;            // Not in the table (flicker travels in the header)
+  }
+  for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+    switch (spectral_index_table[i].formula) {
+      case FORMULA_NORM_DIFF: report_deadband[spectral_index_table[i].slot] = REPORT_DEADBAND_NORM_DIFF; break;
+      case FORMULA_INV_DIFF:  report_deadband[spectral_index_table[i].slot] = REPORT_DEADBAND_INV_DIFF; break;
+      default:                report_deadband[spectral_index_table[i].slot] = REPORT_DEADBAND_RATIO; break;
+    }
+  }
+}
+
+void report_policy_set_deadband(uint8_t slot, float deadband) {
+  if (slot < SPECTRAL_NUM_INDICES) report_deadband[slot] = deadband;
+}
+
+/**
+ * Judge one frame's indices and health levels (vigor, chlorophyll,
+ * stress, water). A non-zero reason makes the frame the new baseline -
+ * the caller sends it.
+ * @return ReportReason, REPORT_SUPPRESS to skip the frame
+ */
+uint8_t report_policy_judge(uint32_t now_ms, const float* indices, const uint8_t* levels) {
+  ReportPolicyState* p = &report_policy;
+  uint8_t reason = REPORT_SUPPRESS;
+  p->frames++;
+
+  if (!REPORT_POLICY_ENABLED || !p->have_baseline) {
+    reason = REPORT_FIRST;
+  } else if (memcmp(levels, p->sent_levels, sizeof(p->sent_levels)) != 0) {
+    reason = REPORT_HEALTH;
+  } else {
+    for (uint8_t i = 0; i < SPECTRAL_NUM_INDICES; i++) {
+      if (report_deadband[i] > 0 && fabsf(indices[i] - p->sent_indices[i]) > report_deadband[i]) {
+        reason = REPORT_DEADBAND;
+        break;
+      }
+    }
+    if (reason == REPORT_SUPPRESS) {
+      if (now_ms - p->sent_ms >= REPORT_HEARTBEAT_MS) reason = REPORT_HEARTBEAT;
+      else if (p->suppressed + 1 >= REPORT_MAX_SUPPRESSED) reason = REPORT_FORCED;
+    }
+  }
+
+  p->reasons[reason]++;
+  if (reason == REPORT_SUPPRESS) {
+    p->suppressed++;
+    return reason;
+  }
+
+  memcpy(p->sent_indices, indices, sizeof(p->sent_indices));
+  memcpy(p->sent_levels, levels, sizeof(p->sent_levels));
+  p->sent_ms = now_ms;
+  p->suppressed = 0;
+  p->have_baseline = true;
+  return reason;
+}
+
+/**
+ * Judge the current frame (spectral_indices + health_levels)
+ * @return ReportReason, REPORT_SUPPRESS to skip the frame
+ */
+uint8_t report_policy_evaluate(uint32_t now_ms) {
+  const uint8_t levels[4] = {health_levels.vigor, health_levels.chlorophyll,
+                             health_levels.stress, health_levels.water};
+  return report_policy_judge(now_ms, spectral_indices, levels);
+}
+
+/**
+ * Uplink: send a filled report unacknowledged if the policy asks for it
+ * (REPORT_UPLINK_ENABLED, not used in duty-cycle mode). The sequence
+ * number is assigned here, so suppressed frames leave no gaps.
+ * @return true if a report was sent
+ */
+bool report_policy_send(SpectralReport* r) {
+#if REPORT_UPLINK_ENABLED
+  if (report_policy_judge(report_clock_ms(), r->indices, r->health) == REPORT_SUPPRESS) return false;
+  uint8_t buf[MAX_PACKET_LEN];
+  r->seq = spectral_report_seq++;
+  size_t len = spectral_seal_report(r, buf, sizeof(buf));
+  if (len == 0) return false;
+  return lora_radio_send(buf, len, GATEWAY_ADDRESS);
+#else
+  (void)r;
+  return false;
+#endif
+}
+
+/**
+ * loop() uplink for the current frame
+ * @return true if a report was sent
+ */
+bool report_policy_poll() {
+#if REPORT_UPLINK_ENABLED
+  SpectralReport r;
+  spectral_report_from_frame(&r, DEFAULT_DEVICE_ID, 0);
+  return report_policy_send(&r);
+#else
+  return false;
+#endif
+}
+
+const char* report_reason_name(uint8_t reason) {
+  switch (reason) {
+    case REPORT_SUPPRESS:  return "suppressed";
+    case REPORT_FIRST:     return "first";
+    case REPORT_HEALTH:    return "health";
+    case REPORT_DEADBAND:  return "deadband";
+    case REPORT_HEARTBEAT: return "heartbeat";
+    case REPORT_FORCED:    return "forced";
+    default:               return "?";
+  }
+}
+
+void print_report_policy_stats() {
+  const ReportPolicyState* p = &report_policy;
+  uint32_t sent = p->frames - p->reasons[REPORT_SUPPRESS];
+  Serial.print("\n[REPORT] Frames: ");
+  Serial.print(p->frames);
+  Serial.print(" | Sent: ");
+  Serial.print(sent);
+  if (p->frames > 0) {
+    Serial.print(" (");
+    Serial.print(100.0f * sent / p->frames, 1);
+    Serial.print("%)");
+  }
+  Serial.print(" | Quiet run: ");
+  Serial.println(p->suppressed);
+  Serial.print("  ");
+  for (uint8_t r = 0; r < REPORT_REASON_COUNT; r++) {
+    Serial.print(report_reason_name(r));
+    Serial.print(":");
+    Serial.print(p->reasons[r]);
+    Serial.print(r + 1 < REPORT_REASON_COUNT ? "  " : "\n");
+  }
+}
+
+#endif // REPORT_POLICY_H
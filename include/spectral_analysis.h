@@ -16,25 +16,28 @@
 #define SPECTRAL_ANALYSIS_H
 
 #include <Arduino.h>
+#include <Preferences.h>
 
 // ==========================================
 // CHANNEL MAPPING - AS7343 to Plant Indices
 // ==========================================
-// AS7343 has: 415, 445, 480, 510, 545, 580, 610, 645, 680, 705, 940nm + CLR
-// Mapping to plant phenotyping wavelengths:
+// AS7343 has: 405, 425, 450, 475, 515, 550, 555, 600, 640, 690, 745, 855nm + CLR
+// (as7343_ch[] order, see AS7343Channel in as7343_sensor.h)
+// Mapping to plant phenotyping wavelengths - each name points at the
+// nearest physical band:
 enum SpectralChannel {
-  CH_VIOLET_410   = 0,   // 415nm (NDVI, chlorophyll)
-  CH_BLUE_440     = 1,   // 445nm (anthocyanin)
-  CH_BLUE_470     = 2,   // 480nm (chlorophyll a)
-  CH_GREEN_510    = 3,   // 510nm (greenness)
-  CH_GREEN_550    = 4,   // 545nm (vegetation)
-  CH_YELLOW_590   = 5,   // 580nm (carotenoid, xanthophyll)
-  CH_RED_630      = 6,   // 610nm (photosynthesis, water stress)
-  CH_RED_680      = 7,   // 645nm (chlorophyll absorption peak)
-  CH_NIR_RED_700  = 8,   // 680nm (red edge - NDVI critical)
-  CH_NIR_730      = 9,   // 705nm (NIR shoulder - water stress)
-  CH_NIR_810      = 10,  // 940nm (far NIR - water, morphology) - REUSED FOR 810
-  CH_NIR_860      = 11,  // 940nm (far NIR - water, morphology) - REUSED FOR 860
+  CH_VIOLET_410   = 0,   // 405nm F1 (NDVI, chlorophyll)
+  CH_BLUE_440     = 2,   // 450nm FZ (anthocyanin)
+  CH_BLUE_470     = 3,   // 475nm F3 (chlorophyll a)
+  CH_GREEN_510    = 4,   // 515nm F4 (greenness)
+  CH_GREEN_550    = 5,   // 550nm F5 (vegetation)
+  CH_YELLOW_590   = 7,   // 600nm FXL (carotenoid, xanthophyll)
+  CH_RED_630      = 8,   // 640nm F6 (photosynthesis, water stress)
+  CH_RED_680      = 9,   // 690nm F7 (chlorophyll absorption peak)
+  CH_NIR_RED_700  = 9,   // 690nm F7 (red edge - NDVI critical) - shares F7
+  CH_NIR_730      = 10,  // 745nm F8 (NIR shoulder - water stress)
+  CH_NIR_810      = 11,  // 855nm NIR (far NIR - water, morphology) - REUSED FOR 810
+  CH_NIR_860      = 11,  // 855nm NIR (far NIR - water, morphology)
   CH_CLEAR        = 12,  // Clear channel (total light)
   CH_FLICKER      = 13   // Flicker detection (AC ripple)
 };
@@ -43,9 +46,17 @@ enum SpectralChannel {
 // GLOBAL SPECTRAL DATA
 // ==========================================
 extern uint16_t as7343_ch[];         // Reference AS7343 channel data from as7343_sensor.h
+extern float as7343_norm[];          // Counts/ms/gain from as7343_agc.h
+extern uint8_t as7343_mains_hz;      // Detected mains frequency from as7343_flicker.h
 
-uint16_t spectral_ch[14];            // Local mapping (same data)
-float spectral_indices[8];           // Calculated vegetation indices
+#define SPECTRAL_NUM_BANDS   (CH_CLEAR + 1)  // Bands + clear in a sensor frame
+#define SPECTRAL_NUM_INDICES 8
+
+// Calibrated frame consumed by the index engine: as7343_norm[] with the
+// dark reference removed and white-balanced (white reference = SPECTRAL_WHITE_SCALE).
+// Uncalibrated channels pass through as counts/ms/gain.
+float spectral_ch[CH_FLICKER + 1];
+float spectral_indices[SPECTRAL_NUM_INDICES];  // Calculated vegetation indices
 
 // Indices in spectral_indices array:
 #define IDX_NDVI          0     // Normalized Difference Vegetation Index
@@ -57,112 +68,181 @@ float spectral_indices[8];           // Calculated vegetation indices
 #define IDX_CAROTENOID    6     // Carotenoid/xanthophyll pigments
 #define IDX_FLICKER_60HZ  7     // Flicker detection (AC mains)
 
-// Calibration data
+// Calibration data (references in counts/ms/gain, so they stay valid
+// across AGC exposure changes)
+#define SPECTRAL_WHITE_SCALE     1000.0f  // Calibrated value of the white reference
+#define SPECTRAL_CAL_FRAMES      32       // Frames averaged per reference
+#define SPECTRAL_CAL_NVS_NS      "spectral"
+#define SPECTRAL_CAL_NVS_KEY     "cal"
+#define SPECTRAL_CAL_VERSION     1
+
 struct {
-  uint16_t dark_ref[14];        // Dark/black reference
-  uint16_t white_ref[14];       // White balance reference
-  float    gain_correction[14]; // Per-channel gain
-  bool     calibrated;
+  float    dark_ref[SPECTRAL_NUM_BANDS];        // Dark/black reference
+  float    white_ref[SPECTRAL_NUM_BANDS];       // White balance reference
+  float    gain_correction[SPECTRAL_NUM_BANDS]; // Per-channel gain
+  bool     has_dark;
+  bool     calibrated;                          // White reference taken
   uint32_t calibration_time;
 } spectral_calibration = {
+  .has_dark = false,
   .calibrated = false,
   .calibration_time = 0
 };
 
+// Background reference capture - frames keep flowing while it averages
+enum SpectralCaptureMode : uint8_t {
+  CAL_CAPTURE_IDLE,
+  CAL_CAPTURE_DARK,
+  CAL_CAPTURE_WHITE
+};
+
+struct {
+  uint8_t  mode;                         // SpectralCaptureMode
+  uint16_t frames;                       // Frames accumulated so far
+  float    sum[SPECTRAL_NUM_BANDS];
+} spectral_capture = {CAL_CAPTURE_IDLE, 0, {0}};
+
+// NVS record - gains are re-derived on load
+struct SpectralCalRecord {
+  uint8_t version;
+  uint8_t bands;
+  uint8_t has_dark;
+  uint8_t calibrated;
+  float   dark_ref[SPECTRAL_NUM_BANDS];
+  float   white_ref[SPECTRAL_NUM_BANDS];
+};
+
 // ==========================================
-// SPECTRAL INDEX CALCULATIONS
+// SPECTRAL INDEX TABLE
 // ==========================================
 
-float calculate_ndvi() {
-  // Use YELLOW (580nm) vs BLUE (445nm) as proxy
-  float yellow = as7343_ch[CH_YELLOW_590];      // 580nm
-  float blue = as7343_ch[CH_BLUE_440];           // 445nm
-  
-  if ((yellow + blue) == 0) return 0.0;
-  return (yellow - blue) / (yellow + blue);
-}
+/**
+ * Index formula types (a, b, c, d are band values from the frame)
+ */
+enum SpectralFormula : uint8_t {
+  FORMULA_NORM_DIFF,   // (a - b) / (a + b)
+  FORMULA_RATIO,       // a / b
+  FORMULA_INV_DIFF,    // 1/a - 1/b
+  FORMULA_SUM_RATIO    // (a + b) / (c + d)
+};
 
-float calculate_chlorophyll_index() {
-  float green = as7343_ch[CH_GREEN_550];
-  float blue = as7343_ch[CH_BLUE_440];
-  
-  if (blue == 0) return 0.0;
-  return green / blue;
-}
+/**
+ * One vegetation index: formula, bands and output slot in spectral_indices[]
+ */
+struct SpectralIndexDesc {
+  uint8_t formula;     // SpectralFormula
+  uint8_t a, b, c, d;  // SpectralChannel operands (c, d only for FORMULA_SUM_RATIO)
+  uint8_t slot;        // IDX_* output slot
+};
 
-float calculate_anthocyanin_index() {
-  float blue = as7343_ch[CH_BLUE_440];
-  float red = as7343_ch[CH_RED_630];
-  
-  if (blue == 0 || red == 0) return 0.0;
-  
-  float inv_blue = 1.0 / blue;
-  float inv_red = 1.0 / red;
-  return inv_blue - inv_red;
-}
+/**
+ * All indices evaluated per frame - add research indices here
+ * (a new slot also needs an IDX_* define and SPECTRAL_NUM_INDICES bump).
+ * A zero denominator yields 0.0, as the old per-index functions did.
+ */
+constexpr SpectralIndexDesc spectral_index_table[] = {
+  // NDVI proxy: YELLOW vs BLUE
+  {FORMULA_NORM_DIFF, CH_YELLOW_590, CH_BLUE_440,   0, 0, IDX_NDVI},
+  {FORMULA_RATIO,     CH_GREEN_550,  CH_BLUE_440,   0, 0, IDX_CHLOROPHYLL},
+  {FORMULA_INV_DIFF,  CH_BLUE_440,   CH_RED_630,    0, 0, IDX_ANTHOCYANIN},
+  {FORMULA_RATIO,     CH_YELLOW_590, CH_GREEN_550,  0, 0, IDX_WATER_STRESS},
+  {FORMULA_RATIO,     CH_RED_630,    CH_YELLOW_590, 0, 0, IDX_RED_FAR_RED},
+  // (Blue + Green) / (Orange + Red)
+  {FORMULA_SUM_RATIO, CH_BLUE_440,   CH_GREEN_550,  CH_YELLOW_590, CH_RED_680,    IDX_PHOTOSYN},
+  {FORMULA_INV_DIFF,  CH_YELLOW_590, CH_BLUE_440,   0, 0, IDX_CAROTENOID},
+};
 
-float calculate_water_stress_index() {
-  float yellow_nir = as7343_ch[CH_YELLOW_590];
-  float green = as7343_ch[CH_GREEN_550];
-  
-  if (green == 0) return 0.0;
-  return yellow_nir / green;
-}
+#define SPECTRAL_TABLE_SIZE (sizeof(spectral_index_table) / sizeof(spectral_index_table[0]))
 
-float calculate_red_far_red_ratio() {
-  float red = as7343_ch[CH_RED_630];
-  float yellow = as7343_ch[CH_YELLOW_590];
-  
-  if (yellow == 0) return 0.0;
-  return red / yellow;
+/**
+ * Compile-time mask of bands whose reciprocal is needed (RATIO and
+ * INV_DIFF denominators) - each is computed once per frame and shared
+ */
+constexpr uint32_t spectral_recip_mask(size_t i = 0) {
+  return (i >= SPECTRAL_TABLE_SIZE) ? 0 :
+    (((spectral_index_table[i].formula == FORMULA_RATIO) ?
+        (1UL << spectral_index_table[i].b) : 0) |
+     ((spectral_index_table[i].formula == FORMULA_INV_DIFF) ?
+        ((1UL << spectral_index_table[i].a) | (1UL << spectral_index_table[i].b)) : 0) |
+     spectral_recip_mask(i + 1));
 }
 
-float calculate_photosynthetic_activity() {
-  float chlorophyll_bands = as7343_ch[CH_BLUE_440] + as7343_ch[CH_GREEN_550];
-  float carotenoid_bands = as7343_ch[CH_YELLOW_590] + as7343_ch[CH_YELLOW_590];
-  
-  if (carotenoid_bands == 0) return 0.0;
-  return chlorophyll_bands / carotenoid_bands;
+constexpr bool spectral_table_valid(size_t i = 0) {
+  return (i >= SPECTRAL_TABLE_SIZE) ||
+    (spectral_index_table[i].slot < SPECTRAL_NUM_INDICES &&
+     spectral_index_table[i].a < SPECTRAL_NUM_BANDS &&
+     spectral_index_table[i].b < SPECTRAL_NUM_BANDS &&
+     spectral_index_table[i].c < SPECTRAL_NUM_BANDS &&
+     spectral_index_table[i].d < SPECTRAL_NUM_BANDS &&
+     spectral_table_valid(i + 1));
 }
 
-float calculate_carotenoid_index() {
-  float blue = as7343_ch[CH_BLUE_440];
-  float yellow = as7343_ch[CH_YELLOW_590];
+static_assert(spectral_table_valid(), "spectral_index_table: band or slot out of range");
+
+// ==========================================
+// SPECTRAL INDEX CALCULATIONS
+// ==========================================
+
+/**
+ * Evaluate every entry of spectral_index_table in one pass over a frame
+ * @param frame SPECTRAL_NUM_BANDS band values
+ * @param out   spectral_indices-style output (only table slots are written)
+ */
+void evaluate_spectral_indices(const float* frame, float* out) {
+  constexpr uint32_t recip_mask = spectral_recip_mask();
+  float recip[SPECTRAL_NUM_BANDS];
   
-  if (blue == 0 || yellow == 0) return 0.0;
+  for (int ch = 0; ch < SPECTRAL_NUM_BANDS; ch++) {
+    if (recip_mask & (1UL << ch)) {
+      recip[ch] = (frame[ch] != 0.0f) ? 1.0f / frame[ch] : 0.0f;
+    }
+  }
   
-  float inv_blue = 1.0 / blue;
-  float inv_yellow = 1.0 / yellow;
-  return inv_yellow - inv_blue;
+  for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+    const SpectralIndexDesc& idx = spectral_index_table[i];
+    float a = frame[idx.a];
+    float b = frame[idx.b];
+    float value = 0.0f;
+    
+    switch (idx.formula) {
+      case FORMULA_NORM_DIFF: {
+        float sum = a + b;
+        if (sum != 0.0f) value = (a - b) / sum;
+        break;
+      }
+      case FORMULA_RATIO:
+        value = a * recip[idx.b];
+        break;
+      case FORMULA_INV_DIFF:
+        if (a != 0.0f && b != 0.0f) value = recip[idx.a] - recip[idx.b];
+        break;
+      case FORMULA_SUM_RATIO: {
+        float den = frame[idx.c] + frame[idx.d];
+        if (den != 0.0f) value = (a + b) / den;
+        break;
+      }
+    }
+    out[idx.slot] = value;
+  }
 }
 
+/**
+ * Mains flicker reported by the AS7343 flicker engine
+ * @return 0 (no ripple), 50 or 60 Hz
+ */
 float calculate_flicker_level() {
-  return (float)as7343_ch[CH_CLEAR];
+  return (float)as7343_mains_hz;
 }
 
 /**
  * Calculate all vegetation indices at once
- * Uses as7343_ch[] directly from as7343_sensor.h
+ * Uses the calibrated frame (spectral_ch[], built from the AGC-normalised
+ * as7343_norm[]) so indices do not shift when gain or integration time change
  */
 void calculate_all_indices() {
-  // Debug: show raw channel values being used
-  Serial.print("[DEBUG] Ch - 415:");
-  Serial.print(as7343_ch[0]);
-  Serial.print(" 445:");
-  Serial.print(as7343_ch[1]);
-  Serial.print(" 545:");
-  Serial.print(as7343_ch[4]);
-  Serial.print(" 580:");
-  Serial.println(as7343_ch[5]);
-  
-  spectral_indices[IDX_NDVI]         = calculate_ndvi();
-  spectral_indices[IDX_CHLOROPHYLL]  = calculate_chlorophyll_index();
-  spectral_indices[IDX_ANTHOCYANIN]  = calculate_anthocyanin_index();
-  spectral_indices[IDX_WATER_STRESS] = calculate_water_stress_index();
-  spectral_indices[IDX_RED_FAR_RED]  = calculate_red_far_red_ratio();
-  spectral_indices[IDX_PHOTOSYN]     = calculate_photosynthetic_activity();
-  spectral_indices[IDX_CAROTENOID]   = calculate_carotenoid_index();
-  spectral_indices[IDX_FLICKER_60HZ] = calculate_flicker_level();
+  evaluate_spectral_indices(spectral_ch, spectral_indices);
+  spectral_ch[CH_FLICKER] = calculate_flicker_level();
+  spectral_indices[IDX_FLICKER_60HZ] = spectral_ch[CH_FLICKER];
 }
 
 // ==========================================
@@ -170,63 +250,172 @@ void calculate_all_indices() {
 // ==========================================
 
 /**
- * Dark Calibration - measure zero-light reference
- * Should be done with lens covered or in dark
+ * Derive per-channel gains from the current references
  */
-void spectral_dark_calibration() {
-  Serial.println("\n[SPECTRAL] Dark Calibration - Cover sensor for 3 seconds...");
-  delay(3000);
+void spectral_update_gains() {
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    float span = spectral_calibration.white_ref[i] - spectral_calibration.dark_ref[i];
+    spectral_calibration.gain_correction[i] = (span > 0.0f) ? SPECTRAL_WHITE_SCALE / span : 1.0f;
+  }
+}
+
+/**
+ * Store the references in NVS so the next boot reuses them
+ */
+bool spectral_calibration_save() {
+  SpectralCalRecord rec;
+  rec.version = SPECTRAL_CAL_VERSION;
+  rec.bands = SPECTRAL_NUM_BANDS;
+  rec.has_dark = spectral_calibration.has_dark;
+  rec.calibrated = spectral_calibration.calibrated;
+  memcpy(rec.dark_ref, spectral_calibration.dark_ref, sizeof(rec.dark_ref));
+  memcpy(rec.white_ref, spectral_calibration.white_ref, sizeof(rec.white_ref));
+  
+  Preferences prefs;
+  if (!prefs.begin(SPECTRAL_CAL_NVS_NS, false)) return false;
+  bool ok = prefs.putBytes(SPECTRAL_CAL_NVS_KEY, &rec, sizeof(rec)) == sizeof(rec);
+  prefs.end();
   
-  // Copy current AS7343 readings as dark reference
-  for (int i = 0; i < 12; i++) {
-    spectral_calibration.dark_ref[i] = spectral_ch[i];
+  Serial.println(ok ? "[SPECTRAL] Calibration saved to NVS" : "[SPECTRAL] Calibration save FAILED");
+  return ok;
+}
+
+/**
+ * Restore references from NVS (call once at boot)
+ * @return true if a valid record was found
+ */
+bool spectral_calibration_load() {
+  SpectralCalRecord rec;
+  Preferences prefs;
+  if (!prefs.begin(SPECTRAL_CAL_NVS_NS, true)) return false;
+  size_t len = prefs.getBytes(SPECTRAL_CAL_NVS_KEY, &rec, sizeof(rec));
+  prefs.end();
+  
+  if (len != sizeof(rec) || rec.version != SPECTRAL_CAL_VERSION || rec.bands != SPECTRAL_NUM_BANDS) {
+    Serial.println("[SPECTRAL] No stored calibration - send 'D' (dark) / 'W' (white) to calibrate");
+    return false;
   }
   
-  Serial.println("[SPECTRAL] Dark calibration complete");
+  memcpy(spectral_calibration.dark_ref, rec.dark_ref, sizeof(rec.dark_ref));
+  memcpy(spectral_calibration.white_ref, rec.white_ref, sizeof(rec.white_ref));
+  spectral_calibration.has_dark = rec.has_dark;
+  spectral_calibration.calibrated = rec.calibrated;
+  spectral_update_gains();
+  
+  Serial.print("[SPECTRAL] Calibration loaded from NVS (dark:");
+  Serial.print(rec.has_dark ? "yes" : "no");
+  Serial.print(" white:");
+  Serial.print(rec.calibrated ? "yes" : "no");
+  Serial.println(")");
+  return true;
+}
+
+/**
+ * Forget the references (RAM and NVS)
+ */
+void spectral_calibration_clear() {
+  spectral_calibration.has_dark = false;
+  spectral_calibration.calibrated = false;
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    spectral_calibration.dark_ref[i] = 0.0f;
+    spectral_calibration.white_ref[i] = 0.0f;
+    spectral_calibration.gain_correction[i] = 1.0f;
+  }
+  
+  Preferences prefs;
+  if (prefs.begin(SPECTRAL_CAL_NVS_NS, false)) {
+    prefs.remove(SPECTRAL_CAL_NVS_KEY);
+    prefs.end();
+  }
+  Serial.println("[SPECTRAL] Calibration cleared");
+}
+
+void spectral_start_capture(uint8_t mode) {
+  spectral_capture.mode = mode;
+  spectral_capture.frames = 0;
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    spectral_capture.sum[i] = 0.0f;
+  }
+}
+
+/**
+ * Dark Calibration - measure zero-light reference
+ * Should be done with lens covered or in dark. Non-blocking: averages
+ * the next SPECTRAL_CAL_FRAMES valid frames while acquisition continues.
+ */
+void spectral_dark_calibration() {
+  Serial.print("\n[SPECTRAL] Dark Calibration - keep sensor covered for ");
+  Serial.print(SPECTRAL_CAL_FRAMES);
+  Serial.println(" frames...");
+  spectral_start_capture(CAL_CAPTURE_DARK);
 }
 
 /**
  * White Balance Calibration - measure white reference
- * Use Spectralon or white paper under neutral illumination
+ * Use Spectralon or white paper under neutral illumination. Non-blocking,
+ * like spectral_dark_calibration().
  */
 void spectral_white_balance_calibration() {
-  Serial.println("\n[SPECTRAL] White Balance - Point at diffuse white reference for 3 seconds...");
-  delay(3000);
+  Serial.print("\n[SPECTRAL] White Balance - point at diffuse white reference for ");
+  Serial.print(SPECTRAL_CAL_FRAMES);
+  Serial.println(" frames...");
+  spectral_start_capture(CAL_CAPTURE_WHITE);
+}
+
+/**
+ * Feed one normalised frame to a running reference capture
+ * Finishes the capture, updates gains and saves to NVS after
+ * SPECTRAL_CAL_FRAMES frames.
+ */
+void spectral_calibration_update(const float* frame) {
+  if (spectral_capture.mode == CAL_CAPTURE_IDLE) return;
   
-  // Copy current readings as white reference
-  for (int i = 0; i < 12; i++) {
-    spectral_calibration.white_ref[i] = spectral_ch[i];
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    spectral_capture.sum[i] += frame[i];
   }
+  if (++spectral_capture.frames < SPECTRAL_CAL_FRAMES) return;
   
-  // Calculate per-channel gain correction (normalize to unity)
-  for (int i = 0; i < 12; i++) {
-    if (spectral_calibration.white_ref[i] > 0) {
-      spectral_calibration.gain_correction[i] = 1000.0 / spectral_calibration.white_ref[i];
-    } else {
-      spectral_calibration.gain_correction[i] = 1.0;
-    }
+  float* ref = (spectral_capture.mode == CAL_CAPTURE_DARK) ?
+               spectral_calibration.dark_ref : spectral_calibration.white_ref;
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    ref[i] = spectral_capture.sum[i] / SPECTRAL_CAL_FRAMES;
   }
   
-  spectral_calibration.calibrated = true;
-  spectral_calibration.calibration_time = millis();
+  if (spectral_capture.mode == CAL_CAPTURE_DARK) {
+    spectral_calibration.has_dark = true;
+    Serial.println("[SPECTRAL] Dark calibration complete");
+  } else {
+    spectral_calibration.calibrated = true;
+    Serial.println("[SPECTRAL] White balance calibration complete");
+  }
   
-  Serial.println("[SPECTRAL] White balance calibration complete");
+  spectral_capture.mode = CAL_CAPTURE_IDLE;
+  spectral_calibration.calibration_time = millis();
+  spectral_update_gains();
+  spectral_calibration_save();
 }
 
 /**
- * Apply calibration to raw readings
+ * Build the calibrated frame spectral_ch[] from as7343_norm[]
+ * Dark is subtracted once a dark reference exists; white balance once a
+ * white reference exists. Also feeds any running reference capture.
  */
 void apply_spectral_calibration() {
-  if (!spectral_calibration.calibrated) return;
+  spectral_calibration_update(as7343_norm);
   
-  for (int i = 0; i < 12; i++) {
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    float corrected = as7343_norm[i];
+    
     // Subtract dark reference
-    int corrected = spectral_ch[i] - spectral_calibration.dark_ref[i];
-    if (corrected < 0) corrected = 0;
+    if (spectral_calibration.has_dark) {
+      corrected -= spectral_calibration.dark_ref[i];
+      if (corrected < 0.0f) corrected = 0.0f;
+    }
     
     // Apply white balance gain
-    corrected = (float)corrected * spectral_calibration.gain_correction[i];
-    if (corrected > 65535) corrected = 65535;
+    if (spectral_calibration.calibrated) {
+      corrected *= spectral_calibration.gain_correction[i];
+    }
     
     spectral_ch[i] = corrected;
   }
@@ -236,14 +425,28 @@ void apply_spectral_calibration() {
 // DISPLAY & ANALYSIS FUNCTIONS
 // ==========================================
 
+/**
+ * Debug: show raw channel values feeding the indices
+ */
+void print_index_inputs(const uint16_t* ch = as7343_ch) {
+  Serial.print("[DEBUG] Ch - 450:");
+  Serial.print(ch[CH_BLUE_440]);
+  Serial.print(" 550:");
+  Serial.print(ch[CH_GREEN_550]);
+  Serial.print(" 600:");
+  Serial.print(ch[CH_YELLOW_590]);
+  Serial.print(" 640:");
+  Serial.println(ch[CH_RED_630]);
+}
+
 /**
  * Print spectral channels formatted
  */
 void print_spectral_channels() {
   Serial.print("[SPECTRAL] ");
-  for (int i = 0; i < 12; i++) {
-    Serial.print(spectral_ch[i]);
-    if (i < 11) Serial.print(" ");
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    Serial.print(spectral_ch[i], 1);
+    if (i < SPECTRAL_NUM_BANDS - 1) Serial.print(" ");
   }
   Serial.println();
 }
@@ -251,31 +454,31 @@ void print_spectral_channels() {
 /**
  * Print all vegetation indices
  */
-void print_vegetation_indices() {
+void print_vegetation_indices(const float* indices = spectral_indices, float clear = spectral_ch[CH_CLEAR]) {
   Serial.println("\n[VEGETATION INDICES]");
   Serial.print("  NDVI: ");
-  Serial.println(spectral_indices[IDX_NDVI], 3);
+  Serial.println(indices[IDX_NDVI], 3);
   
   Serial.print("  Chlorophyll Index: ");
-  Serial.println(spectral_indices[IDX_CHLOROPHYLL], 2);
+  Serial.println(indices[IDX_CHLOROPHYLL], 2);
   
   Serial.print("  Anthocyanin Index: ");
-  Serial.println(spectral_indices[IDX_ANTHOCYANIN], 3);
+  Serial.println(indices[IDX_ANTHOCYANIN], 3);
   
   Serial.print("  Water Stress Index: ");
-  Serial.println(spectral_indices[IDX_WATER_STRESS], 2);
+  Serial.println(indices[IDX_WATER_STRESS], 2);
   
   Serial.print("  Red:Far-Red Ratio: ");
-  Serial.println(spectral_indices[IDX_RED_FAR_RED], 2);
+  Serial.println(indices[IDX_RED_FAR_RED], 2);
   
   Serial.print("  Photosynthetic Activity: ");
-  Serial.println(spectral_indices[IDX_PHOTOSYN], 2);
+  Serial.println(indices[IDX_PHOTOSYN], 2);
   
   Serial.print("  Carotenoid Index: ");
-  Serial.println(spectral_indices[IDX_CAROTENOID], 3);
+  Serial.println(indices[IDX_CAROTENOID], 3);
   
   Serial.print("  Clear Channel (Illumination): ");
-  Serial.println(spectral_ch[CH_CLEAR]);
+  Serial.println(clear, 1);
   
   Serial.println();
 }
@@ -365,15 +568,15 @@ void calculate_health_levels() {
 /**
  * Print health level descriptions for serial debug
  */
-void print_health_description() {
+void print_health_description(const HealthLevels& levels = health_levels) {
   Serial.print("[HEALTH] Vigor:");
-  Serial.print(health_levels.vigor);
+  Serial.print(levels.vigor);
   Serial.print(" Chlor:");
-  Serial.print(health_levels.chlorophyll);
+  Serial.print(levels.chlorophyll);
   Serial.print(" Stress:");
-  Serial.print(health_levels.stress);
+  Serial.print(levels.stress);
   Serial.print(" Water:");
-  Serial.println(health_levels.water);
+  Serial.println(levels.water);
 }
 
 #endif // SPECTRAL_ANALYSIS_H
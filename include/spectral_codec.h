@@ -0,0 +1,276 @@
+/**
+ * Spectral Report Codec
+ * Versioned binary LoRa payload for one spectral frame
+ *
+ * Layout (all multi-byte fields little-endian / varint):
+ *   [0]    version (SPECTRAL_CODEC_VERSION)
+ *   [1]    node id
+ *   [2-3]  sequence
+ *   [4]    AGAIN code (bits 3:0) | flicker code (bits 5:4: 0 none, 1 50 Hz, 2 60 Hz)
+ *   [5]    ATIME
+ *   ...    13 channels: ch[0] varint, then zigzag varint of ch[i] - ch[i-1]
+ *          (neighbouring bands are correlated, so deltas stay small)
+ *   ...    7 table indices: zigzag varint of round(value x scale), scale by
+ *          formula type (see spectral_codec_scale())
+ *   ...    health: vigor|chlorophyll, stress|water as nibbles (2 bytes)
+ *
+ * Packets are self-contained (no state across packets), so a lost packet
+ * never corrupts the next one. Typical size is ~45 bytes vs ~200 as text.
+ */
+
+#ifndef SPECTRAL_CODEC_H
+#define SPECTRAL_CODEC_H
+
+#include <Arduino.h>
+#include "lora_config.h"
+#include "as7343_sensor.h"
+#include "spectral_analysis.h"
+#include "lora_functions.h"
+
+// ==========================================
+// CODEC CONFIGURATION
+// ==========================================
+
+#define SPECTRAL_CODEC_VERSION 1
+#define SPECTRAL_CODEC_HEADER  6
+
+// Quantisation per formula type (value x scale, rounded)
+#define SPECTRAL_SCALE_NORM_DIFF 10000.0f   // -1..1 -> 1e-4 resolution
+#define SPECTRAL_SCALE_RATIO     1000.0f    // Ratios -> 1e-3 resolution
+#define SPECTRAL_SCALE_INV_DIFF  1000000.0f // 1/a - 1/b is small in calibrated units
+
+// ==========================================
+// REPORT STRUCTURE
+// ==========================================
+
+/**
+ * Decoded spectral report
+ */
+struct SpectralReport {
+  uint8_t  node_id;
+  uint16_t seq;
+  uint8_t  gain;                              // AGAIN code of the frame
+  uint8_t  atime;
+  uint8_t  mains_hz;                          // 0, 50 or 60
+  uint16_t ch[AS7343_NUM_CHANNELS];           // Raw counts, AS7343Channel order
+  float    indices[SPECTRAL_NUM_INDICES];     // Flicker slot carries mains_hz
+  uint8_t  health[4];                         // Vigor, chlorophyll, stress, water (0-5)
+};
+
+// ==========================================
+// VARINT PRIMITIVES
+// ==========================================
+
+static inline uint32_t codec_zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t codec_unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * Append an unsigned LEB128 varint
+ * @return false if it does not fit
+ */
+static inline bool codec_put_varint(uint8_t* buf, size_t cap, size_t* pos, uint32_t v) {
+  do {
+    if (*pos >= cap) return false;
+    uint8_t b = v & 0x7F;
+    v >>= 7;
+    buf[(*pos)++] = b | (v ? 0x80 : 0);
+  } while (v);
+  return true;
+}
+
+static inline bool codec_get_varint(const uint8_t* buf, size_t len, size_t* pos, uint32_t* v) {
+  uint32_t result = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (*pos >= len) return false;
+    uint8_t b = buf[(*pos)++];
+    result |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;  // Over-long varint
+}
+
+// ==========================================
+// INDEX QUANTISATION
+// ==========================================
+
+/**
+ * Quantisation scale for an index slot, from its formula in spectral_index_table
+ * (0 for slots not in the table - the flicker slot travels in the header)
+ */
+float spectral_codec_scale(uint8_t slot) {
+  for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+    if (spectral_index_table[i].slot != slot) continue;
+    switch (spectral_index_table[i].formula) {
+      case FORMULA_NORM_DIFF: return SPECTRAL_SCALE_NORM_DIFF;
+      case FORMULA_INV_DIFF:  return SPECTRAL_SCALE_INV_DIFF;
+      default:                return SPECTRAL_SCALE_RATIO;
+    }
+  }
+  return 0.0f;
+}
+
+static inline int32_t codec_quantise(float v, float scale) {
+  float q = v * scale;
+  if (q > 2147483000.0f) return 2147483000;
+  if (q < -2147483000.0f) return -2147483000;
+  return (int32_t)lroundf(q);
+}
+
+// ==========================================
+// ENCODE / DECODE
+// ==========================================
+
+/**
+ * Fill a report from one frame's counts, indices and health levels
+ */
+void spectral_report_fill(SpectralReport* r, uint8_t node_id, uint16_t seq, uint8_t astatus,
+                          uint8_t atime, const uint16_t* ch, const float* indices,
+                          const HealthLevels& levels) {
+  r->node_id = node_id;
+  r->seq = seq;
+  r->gain = astatus & 0x0F;
+  r->atime = atime;
+  r->mains_hz = (uint8_t)indices[IDX_FLICKER_60HZ];
+  memcpy(r->ch, ch, sizeof(r->ch));
+  memcpy(r->indices, indices, sizeof(r->indices));
+  r->health[0] = levels.vigor;
+  r->health[1] = levels.chlorophyll;
+  r->health[2] = levels.stress;
+  r->health[3] = levels.water;
+}
+
+/**
+ * Fill a report from the current frame, indices and health levels
+ */
+void spectral_report_from_frame(SpectralReport* r, uint8_t node_id, uint16_t seq) {
+  spectral_report_fill(r, node_id, seq, as7343_frame.astatus, as7343_exposure.atime,
+                       as7343_ch, spectral_indices, health_levels);
+}
+
+/**
+ * Encode a report into buf
+ * @param cap buffer size (MAX_PACKET_LEN for a LoRa payload)
+ * @return encoded length, or 0 if buf is too small
+ */
+size_t spectral_encode(const SpectralReport* r, uint8_t* buf, size_t cap) {
+  if (cap < SPECTRAL_CODEC_HEADER) return 0;
+
+  uint8_t flicker = (r->mains_hz == 50) ? 1 : (r->mains_hz == 60) ? 2 : 0;
+  buf[0] = SPECTRAL_CODEC_VERSION;
+  buf[1] = r->node_id;
+  buf[2] = r->seq & 0xFF;
+  buf[3] = r->seq >> 8;
+  buf[4] = (r->gain & 0x0F) | (flicker << 4);
+  buf[5] = r->atime;
+  size_t pos = SPECTRAL_CODEC_HEADER;
+
+  // Channels - first absolute, then inter-band deltas
+  if (!codec_put_varint(buf, cap, &pos, r->ch[0])) return 0;
+  for (int i = 1; i < AS7343_NUM_CHANNELS; i++) {
+    int32_t delta = (int32_t)r->ch[i] - (int32_t)r->ch[i - 1];
+    if (!codec_put_varint(buf, cap, &pos, codec_zigzag(delta))) return 0;
+  }
+
+  // Indices in table order
+  for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+    uint8_t slot = spectral_index_table[i].slot;
+    int32_t q = codec_quantise(r->indices[slot], spectral_codec_scale(slot));
+    if (!codec_put_varint(buf, cap, &pos, codec_zigzag(q))) return 0;
+  }
+
+  // Health nibbles
+  if (pos + 2 > cap) return 0;
+  buf[pos++] = (r->health[0] & 0x0F) | (r->health[1] << 4);
+  buf[pos++] = (r->health[2] & 0x0F) | (r->health[3] << 4);
+  return pos;
+}
+
+/**
+ * Decode a packet produced by spectral_encode()
+ * @return false on version mismatch, truncation or trailing garbage
+ */
+bool spectral_decode(const uint8_t* buf, size_t len, SpectralReport* r) {
+  if (len < SPECTRAL_CODEC_HEADER || buf[0] != SPECTRAL_CODEC_VERSION) return false;
+
+  r->node_id = buf[1];
+  r->seq = buf[2] | ((uint16_t)buf[3] << 8);
+  r->gain = buf[4] & 0x0F;
+  uint8_t flicker = (buf[4] >> 4) & 0x03;
+  r->mains_hz = (flicker == 1) ? 50 : (flicker == 2) ? 60 : 0;
+  r->atime = buf[5];
+  size_t pos = SPECTRAL_CODEC_HEADER;
+  uint32_t v;
+
+  if (!codec_get_varint(buf, len, &pos, &v) || v > 0xFFFF) return false;
+  int32_t ch = (int32_t)v;
+  r->ch[0] = (uint16_t)ch;
+  for (int i = 1; i < AS7343_NUM_CHANNELS; i++) {
+    if (!codec_get_varint(buf, len, &pos, &v)) return false;
+    ch += codec_unzigzag(v);
+    if (ch < 0 || ch > 0xFFFF) return false;
+    r->ch[i] = (uint16_t)ch;
+  }
+
+  for (int i = 0; i < SPECTRAL_NUM_INDICES; i++) r->indices[i] = 0.0f;
+  for (size_t i = 0; i < SPECTRAL_TABLE_SIZE; i++) {
+    uint8_t slot = spectral_index_table[i].slot;
+    if (!codec_get_varint(buf, len, &pos, &v)) return false;
+    r->indices[slot] = codec_unzigzag(v) / spectral_codec_scale(slot);
+  }
+  r->indices[IDX_FLICKER_60HZ] = r->mains_hz;
+
+  if (pos + 2 != len) return false;
+  r->health[0] = buf[pos] & 0x0F;
+  r->health[1] = buf[pos] >> 4;
+  r->health[2] = buf[pos + 1] & 0x0F;
+  r->health[3] = buf[pos + 1] >> 4;
+  return true;
+}
+
+/**
+ * Read node id and sequence from a report header without decoding it
+ * @return false if buf is not a spectral report
+ */
+bool spectral_report_peek(const uint8_t* buf, size_t len, uint8_t* node_id, uint16_t* seq) {
+  if (len < SPECTRAL_CODEC_HEADER || buf[0] != SPECTRAL_CODEC_VERSION) return false;
+  *node_id = buf[1];
+  *seq = buf[2] | ((uint16_t)buf[3] << 8);
+  return true;
+}
+
+// ==========================================
+// TRANSMIT
+// ==========================================
+
+uint16_t spectral_report_seq = 0;
+
+/**
+ * Encode a filled report and seal it (encrypt + CRC) into buf
+ * @return packet length, or 0 if it does not fit
+ */
+size_t spectral_seal_report(const SpectralReport* r, uint8_t* buf, size_t cap) {
+  size_t len = spectral_encode(r, buf, cap - 2);         // Room for the CRC
+  if (len == 0) return 0;
+  return lora_packet_seal(buf, len, cap);
+}
+
+/**
+ * Encode the current frame and seal it (encrypt + CRC) into buf
+ * @return packet length, or 0 if it does not fit
+ */
+size_t spectral_build_report(uint8_t* buf, size_t cap) {
+  SpectralReport report;
+
+  spectral_report_from_frame(&report, DEFAULT_DEVICE_ID, spectral_report_seq++);
+  return spectral_seal_report(&report, buf, cap);
+}
+
+#endif // SPECTRAL_CODEC_H
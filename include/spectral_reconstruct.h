@@ -0,0 +1,478 @@
+/**
+ * Full-Spectrum Reconstruction + Red-Edge Features
+ * Turns the 12 calibrated AS7343 bands into a continuous spectrum
+ *
+ *   spectrum[SPECTRUM_POINTS] = M[SPECTRUM_POINTS][RECON_BANDS] * bands
+ *
+ * SPECTRUM_START_NM..SPECTRUM_END_NM in SPECTRUM_STEP_NM steps. The default
+ * M is a Wiener estimate built at boot from the sensor model (Gaussian band
+ * responses, smooth spectral prior):
+ *
+ *   M = K S^T (S K S^T + noise I)^-1
+ *
+ * S = band responses on the output grid (rows sum to 1), K = exponential
+ * correlation between wavelengths. A matrix measured against a reference
+ * spectrometer replaces it with spectral_recon_set_matrix() and survives
+ * reboots in NVS.
+ *
+ * Per frame: one matrix-vector product and short window scans - red-edge
+ * position (max dR/dλ and the linear four-point method), red-edge slope,
+ * red well and green peak, NIR/red NDVI and NDRE. The product and the band
+ * means use the ESP-DSP kernels when the library is available, a scalar
+ * loop otherwise (host bench).
+ */
+
+#ifndef SPECTRAL_RECONSTRUCT_H
+#define SPECTRAL_RECONSTRUCT_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "as7343_sensor.h"
+#include "spectral_analysis.h"
+
+#ifndef SPECTRAL_RECON_USE_DSP
+#if defined(__has_include)
+#if __has_include(<esp_dsp.h>)
+#define SPECTRAL_RECON_USE_DSP 1
+#endif
+#endif
+#endif
+#ifndef SPECTRAL_RECON_USE_DSP
+#define SPECTRAL_RECON_USE_DSP 0
+#endif
+
+#if SPECTRAL_RECON_USE_DSP
+#include <esp_dsp.h>
+#endif
+
+// ==========================================
+// RECONSTRUCTION CONFIGURATION
+// ==========================================
+
+#ifndef SPECTRAL_RECON_ENABLED
+#define SPECTRAL_RECON_ENABLED 1
+#endif
+
+#define SPECTRUM_START_NM     400
+#define SPECTRUM_END_NM       900
+#define SPECTRUM_STEP_NM      5
+
+#ifndef SPECTRAL_RECON_CORR_NM
+#define SPECTRAL_RECON_CORR_NM   50.0f    // Prior correlation length of the spectrum
+#endif
+#ifndef SPECTRAL_RECON_NOISE
+#define SPECTRAL_RECON_NOISE     1e-3f    // Regularisation, relative to the mean band power
+#endif
+
+#define SPECTRAL_RECON_NVS_NS    "spectral"
+#define SPECTRAL_RECON_NVS_KEY   "recon"      // Matrix blob, row-major
+#define SPECTRAL_RECON_NVS_LAYOUT "recon_fmt"  // Version / bands / points of the blob
+#define SPECTRAL_RECON_VERSION   1
+
+// ==========================================
+// SENSOR MODEL
+// ==========================================
+
+/**
+ * AS7343 band centres and FWHM (datasheet typicals), as7343_ch[] order
+ */
+constexpr uint8_t RECON_BANDS = AS7343_CLEAR;   // Clear is not a band
+const float recon_center_nm[RECON_BANDS] = {
+  405, 425, 450, 475, 515, 550, 555, 600, 640, 690, 745, 855
+};
+const float recon_fwhm_nm[RECON_BANDS] = {
+  30, 22, 55, 30, 40, 35, 100, 80, 50, 55, 60, 54
+};
+
+constexpr uint16_t SPECTRUM_POINTS = (SPECTRUM_END_NM - SPECTRUM_START_NM) / SPECTRUM_STEP_NM + 1;
+
+static_assert(RECON_BANDS == 12, "Sensor model covers the 12 AS7343 bands");
+static_assert((SPECTRUM_END_NM - SPECTRUM_START_NM) % SPECTRUM_STEP_NM == 0, "Grid must end on SPECTRUM_END_NM");
+
+// ==========================================
+// RECONSTRUCTION DATA
+// ==========================================
+
+struct SpectralFeatures {
+  bool  valid;
+  bool  reflectance;            // White reference taken - spectrum is 0..1 reflectance
+  float rep_nm;                 // Red-edge position: max dR/dλ in 680-750nm
+  float rep_linear_nm;          // Four-point linear method (670/700/740/780nm)
+  float red_edge_slope;         // Max dR/dλ per nm (spectrum units)
+  float red_well_nm;            // Chlorophyll absorption minimum 640-700nm
+  float green_peak_nm;          // Reflectance maximum 500-600nm
+  float ndvi;                   // NIR (780-880nm) vs red (650-680nm)
+  float ndre;                   // R790 vs R720
+};
+
+struct SpectralReconStats {
+  uint32_t frames;
+  bool     ready;               // A usable matrix is in place
+  bool     measured;            // M came from spectral_recon_set_matrix() / NVS
+};
+
+alignas(16) float spectral_recon_matrix[SPECTRUM_POINTS][RECON_BANDS];
+alignas(16) float spectral_recon_in[RECON_BANDS];
+alignas(16) float spectral_spectrum[SPECTRUM_POINTS];
+alignas(16) float spectral_recon_ones[SPECTRUM_POINTS];   // Dot-product operand for window sums
+SpectralFeatures spectral_features;
+SpectralReconStats spectral_recon_stats;
+
+// ==========================================
+// MATRIX CONSTRUCTION
+// ==========================================
+
+/**
+ * Layout word stored next to the matrix - a blob for another grid or
+ * sensor model is never loaded
+ */
+constexpr uint32_t spectral_recon_layout() {
+  return ((uint32_t)SPECTRAL_RECON_VERSION << 24) | ((uint32_t)RECON_BANDS << 16) | SPECTRUM_POINTS;
+}
+
+inline float spectrum_nm(uint16_t j) {
+  return (float)(SPECTRUM_START_NM + j * SPECTRUM_STEP_NM);
+}
+
+/**
+ * y = K x in place for the exponential prior K[j][k] = rho^|j-k|
+ * (forward + backward first-order recursion instead of a dense product)
+ * @param x SPECTRUM_POINTS values, stride apart
+ */
+void spectral_recon_apply_prior(float* x, uint16_t stride, float rho) {
+  float fwd[SPECTRUM_POINTS];
+  float acc = 0.0f;
+  for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) {
+    acc = x[j * stride] + rho * acc;
+    fwd[j] = acc;
+  }
+  acc = 0.0f;
+  for (int j = SPECTRUM_POINTS - 1; j >= 0; j--) {
+    float v = x[j * stride];
+    acc = v + rho * acc;
+    x[j * stride] = fwd[j] + acc - v;
+  }
+}
+
+/**
+ * Invert a small SPD matrix in place (Gauss-Jordan, partial pivoting)
+ * @return false if singular
+ */
+bool spectral_recon_invert(double a[RECON_BANDS][RECON_BANDS]) {
+  double inv[RECON_BANDS][RECON_BANDS];
+  for (uint8_t i = 0; i < RECON_BANDS; i++) {
+    for (uint8_t j = 0; j < RECON_BANDS; j++) inv[i][j] = (i == j) ? 1.0 : 0.0;
+  }
+  for (uint8_t c = 0; c < RECON_BANDS; c++) {
+    uint8_t p = c;
+    for (uint8_t r = c + 1; r < RECON_BANDS; r++) {
+      if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+    }
+    if (fabs(a[p][c]) < 1e-12) return false;
+    for (uint8_t j = 0; j < RECON_BANDS; j++) {
+      double t = a[c][j]; a[c][j] = a[p][j]; a[p][j] = t;
+      t = inv[c][j]; inv[c][j] = inv[p][j]; inv[p][j] = t;
+    }
+    double d = 1.0 / a[c][c];
+    for (uint8_t j = 0; j < RECON_BANDS; j++) { a[c][j] *= d; inv[c][j] *= d; }
+    for (uint8_t r = 0; r < RECON_BANDS; r++) {
+      if (r == c || a[r][c] == 0.0) continue;
+      double f = a[r][c];
+      for (uint8_t j = 0; j < RECON_BANDS; j++) {
+        a[r][j] -= f * a[c][j];
+        inv[r][j] -= f * inv[c][j];
+      }
+    }
+  }
+  memcpy(a, inv, sizeof(inv));
+  return true;
+}
+
+/**
+ * Build the default Wiener matrix from the sensor model into
+ * spectral_recon_matrix (boot only - a few ms, no heap)
+ * @return true on success
+ */
+bool spectral_recon_build_model() {
+  float (*m)[RECON_BANDS] = spectral_recon_matrix;
+  float rho = expf(-(float)SPECTRUM_STEP_NM / SPECTRAL_RECON_CORR_NM);
+
+  // S^T: Gaussian band responses sampled on the grid, each band normalised
+  for (uint8_t i = 0; i < RECON_BANDS; i++) {
+    float sigma = recon_fwhm_nm[i] / 2.3548f;
+    float sum = 0.0f;
+    for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) {
+      float d = (spectrum_nm(j) - recon_center_nm[i]) / sigma;
+      m[j][i] = expf(-0.5f * d * d);
+      sum += m[j][i];
+    }
+    for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) m[j][i] /= sum;
+  }
+
+  // A = S K S^T + noise I, one column of K S^T at a time
+  double a[RECON_BANDS][RECON_BANDS];
+  float col[SPECTRUM_POINTS];
+  for (uint8_t i = 0; i < RECON_BANDS; i++) {
+    for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) col[j] = m[j][i];
+    spectral_recon_apply_prior(col, 1, rho);
+    for (uint8_t l = 0; l < RECON_BANDS; l++) {
+      double s = 0.0;
+      for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) s += (double)m[j][l] * col[j];
+      a[l][i] = s;
+    }
+  }
+  double trace = 0.0;
+  for (uint8_t i = 0; i < RECON_BANDS; i++) trace += a[i][i];
+  for (uint8_t i = 0; i < RECON_BANDS; i++) a[i][i] += SPECTRAL_RECON_NOISE * trace / RECON_BANDS;
+  if (!spectral_recon_invert(a)) return false;
+
+  // B = S^T A^-1 row by row, then M = K B column by column
+  for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) {
+    float row[RECON_BANDS];
+    for (uint8_t i = 0; i < RECON_BANDS; i++) {
+      double s = 0.0;
+      for (uint8_t l = 0; l < RECON_BANDS; l++) s += m[j][l] * a[l][i];
+      row[i] = (float)s;
+    }
+    memcpy(m[j], row, sizeof(row));
+  }
+  for (uint8_t i = 0; i < RECON_BANDS; i++) spectral_recon_apply_prior(&m[0][i], RECON_BANDS, rho);
+  return true;
+}
+
+// ==========================================
+// MATRIX STORAGE
+// ==========================================
+
+/**
+ * Use a measured matrix (SPECTRUM_POINTS x RECON_BANDS, row-major)
+ * @param save also store it in NVS
+ * @return false if the NVS write failed
+ */
+bool spectral_recon_set_matrix(const float* matrix, bool save = true) {
+  memcpy(spectral_recon_matrix, matrix, sizeof(spectral_recon_matrix));
+  spectral_recon_stats.measured = true;
+  spectral_recon_stats.ready = true;
+  if (!save) return true;
+
+  Preferences prefs;
+  if (!prefs.begin(SPECTRAL_RECON_NVS_NS, false)) return false;
+  bool ok = prefs.putBytes(SPECTRAL_RECON_NVS_KEY, matrix, sizeof(spectral_recon_matrix)) ==
+            sizeof(spectral_recon_matrix) &&
+            prefs.putUInt(SPECTRAL_RECON_NVS_LAYOUT, spectral_recon_layout()) == sizeof(uint32_t);
+  prefs.end();
+  Serial.println(ok ? "[SPECTRUM] Matrix saved to NVS" : "[SPECTRUM] Matrix save FAILED");
+  return ok;
+}
+
+/**
+ * Load a measured matrix from NVS, or build the model default (call once
+ * at boot, after spectral_calibration_load())
+ * @return true if a usable matrix is in place
+ */
+bool spectral_recon_init() {
+  for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) spectral_recon_ones[j] = 1.0f;
+
+  Preferences prefs;
+  bool loaded = false;
+  if (prefs.begin(SPECTRAL_RECON_NVS_NS, true)) {
+    // Read straight into the matrix; the model rebuilds it if the blob is unusable
+    loaded = prefs.getUInt(SPECTRAL_RECON_NVS_LAYOUT, 0) == spectral_recon_layout() &&
+             prefs.getBytes(SPECTRAL_RECON_NVS_KEY, spectral_recon_matrix,
+                            sizeof(spectral_recon_matrix)) == sizeof(spectral_recon_matrix);
+    prefs.end();
+  }
+  if (loaded) {
+    spectral_recon_stats.measured = true;
+    spectral_recon_stats.ready = true;
+    Serial.println("[SPECTRUM] Measured reconstruction matrix loaded from NVS");
+    return true;
+  }
+
+  spectral_recon_stats.measured = false;
+  bool ok = spectral_recon_build_model();
+  spectral_recon_stats.ready = ok;
+  Serial.println(ok ? "[SPECTRUM] Using sensor-model reconstruction matrix"
+                    : "[SPECTRUM] Model matrix singular - reconstruction off");
+  return ok;
+}
+
+// ==========================================
+// FEATURE EXTRACTION
+// ==========================================
+
+inline uint16_t spectrum_index(float nm) {
+  int j = (int)lroundf((nm - SPECTRUM_START_NM) / SPECTRUM_STEP_NM);
+  if (j < 0) j = 0;
+  if (j >= SPECTRUM_POINTS) j = SPECTRUM_POINTS - 1;
+  return (uint16_t)j;
+}
+
+/**
+ * Spectrum value at a wavelength (linear interpolation on the grid)
+ */
+float spectrum_at(const float* s, float nm) {
+  float x = (nm - SPECTRUM_START_NM) / SPECTRUM_STEP_NM;
+  if (x <= 0.0f) return s[0];
+  if (x >= SPECTRUM_POINTS - 1) return s[SPECTRUM_POINTS - 1];
+  uint16_t j = (uint16_t)x;
+  float f = x - j;
+  return s[j] + f * (s[j + 1] - s[j]);
+}
+
+/**
+ * Mean over [lo_nm, hi_nm]
+ */
+float spectrum_mean(const float* s, float lo_nm, float hi_nm) {
+  uint16_t lo = spectrum_index(lo_nm);
+  uint16_t n = spectrum_index(hi_nm) - lo + 1;
+  float sum = 0.0f;
+#if SPECTRAL_RECON_USE_DSP
+  dsps_dotprod_f32(s + lo, spectral_recon_ones, &sum, n);
+#else
+  for (uint16_t j = 0; j < n; j++) sum += s[lo + j];
+#endif
+  return sum / n;
+}
+
+/**
+ * Extremum in [lo_nm, hi_nm], refined with a parabola through the
+ * neighbours
+ * @param sign +1 for a maximum, -1 for a minimum
+ * @return wavelength of the extremum
+ */
+float spectrum_peak_nm(const float* s, float lo_nm, float hi_nm, int sign, float* value = NULL) {
+  uint16_t lo = spectrum_index(lo_nm);
+  uint16_t hi = spectrum_index(hi_nm);
+  uint16_t best = lo;
+  for (uint16_t j = lo + 1; j <= hi; j++) {
+    if (sign * s[j] > sign * s[best]) best = j;
+  }
+  float offset = 0.0f;
+  if (best > 0 && best < SPECTRUM_POINTS - 1) {
+    float y0 = s[best - 1], y1 = s[best], y2 = s[best + 1];
+    float den = y0 - 2.0f * y1 + y2;
+    if (den != 0.0f) offset = 0.5f * (y0 - y2) / den;
+    if (offset > 0.5f) offset = 0.5f;
+    if (offset < -0.5f) offset = -0.5f;
+  }
+  if (value) *value = s[best];
+  return spectrum_nm(best) + offset * SPECTRUM_STEP_NM;
+}
+
+inline float spectral_norm_diff(float a, float b) {
+  float sum = a + b;
+  return (fabsf(sum) > 1e-6f) ? (a - b) / sum : 0.0f;
+}
+
+/**
+ * Features of one reconstructed spectrum
+ */
+void spectral_extract_features(const float* s, SpectralFeatures* f) {
+  // First derivative over the red edge only (central differences)
+  const uint16_t lo = spectrum_index(680), hi = spectrum_index(750);
+  float deriv[SPECTRUM_POINTS];
+  for (uint16_t j = lo; j <= hi; j++) {
+    deriv[j] = (s[j + 1] - s[j - 1]) / (2.0f * SPECTRUM_STEP_NM);
+  }
+  deriv[lo - 1] = deriv[lo];                // Keeps the parabola inside the window
+  deriv[hi + 1] = deriv[hi];
+  f->rep_nm = spectrum_peak_nm(deriv, 680, 750, +1, &f->red_edge_slope);
+
+  float r670 = spectrum_at(s, 670), r700 = spectrum_at(s, 700);
+  float r740 = spectrum_at(s, 740), r780 = spectrum_at(s, 780);
+  float slope = r740 - r700;
+  f->rep_linear_nm = (fabsf(slope) > 1e-6f)
+                     ? 700.0f + 40.0f * ((r670 + r780) * 0.5f - r700) / slope : 0.0f;
+
+  f->red_well_nm = spectrum_peak_nm(s, 640, 700, -1);
+  f->green_peak_nm = spectrum_peak_nm(s, 500, 600, +1);
+  f->ndvi = spectral_norm_diff(spectrum_mean(s, 780, 880), spectrum_mean(s, 650, 680));
+  f->ndre = spectral_norm_diff(spectrum_at(s, 790), spectrum_at(s, 720));
+  f->valid = true;
+}
+
+static_assert(SPECTRUM_START_NM < 680 - SPECTRUM_STEP_NM && SPECTRUM_END_NM > 880,
+              "Feature windows must lie inside the grid");
+
+/**
+ * Reconstruct bands[RECON_BANDS] into spectrum[] and derive the features
+ */
+void spectral_reconstruct(const float* bands, float* spectrum, SpectralFeatures* f) {
+#if SPECTRAL_RECON_USE_DSP
+  dspm_mult_f32(&spectral_recon_matrix[0][0], bands, spectrum, SPECTRUM_POINTS, RECON_BANDS, 1);
+#else
+  for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) {
+    const float* row = spectral_recon_matrix[j];
+    float acc = 0.0f;
+    for (uint8_t i = 0; i < RECON_BANDS; i++) acc += row[i] * bands[i];
+    spectrum[j] = acc;
+  }
+#endif
+  spectral_extract_features(spectrum, f);
+}
+
+/**
+ * Reconstruct the current calibrated frame (spectral_ch[]) into
+ * spectral_spectrum[] / spectral_features
+ */
+void spectral_reconstruct_frame() {
+#if SPECTRAL_RECON_ENABLED
+  if (!spectral_recon_stats.ready) return;
+  // White-balanced bands become reflectance; uncalibrated ones stay relative
+  bool reflectance = spectral_calibration.calibrated;
+  float scale = reflectance ? 1.0f / SPECTRAL_WHITE_SCALE : 1.0f;
+  for (uint8_t i = 0; i < RECON_BANDS; i++) spectral_recon_in[i] = spectral_ch[i] * scale;
+  spectral_reconstruct(spectral_recon_in, spectral_spectrum, &spectral_features);
+  spectral_features.reflectance = reflectance;
+  spectral_recon_stats.frames++;
+#endif
+}
+
+// ==========================================
+// OUTPUT
+// ==========================================
+
+void print_spectral_features(const SpectralFeatures& f = spectral_features) {
+  if (!f.valid) return;
+  Serial.println("[SPECTRUM FEATURES]");
+  Serial.print("  Red Edge: ");
+  Serial.print(f.rep_nm, 1);
+  Serial.print("nm (linear ");
+  Serial.print(f.rep_linear_nm, 1);
+  Serial.print("nm) slope ");
+  Serial.println(f.red_edge_slope, 5);
+  Serial.print("  Red Well: ");
+  Serial.print(f.red_well_nm, 1);
+  Serial.print("nm | Green Peak: ");
+  Serial.print(f.green_peak_nm, 1);
+  Serial.println("nm");
+  Serial.print("  NDVI (NIR/red): ");
+  Serial.print(f.ndvi, 3);
+  Serial.print(" | NDRE: ");
+  Serial.print(f.ndre, 3);
+  Serial.println(f.reflectance ? "" : "  (uncalibrated - relative spectrum)");
+  Serial.println();
+}
+
+/**
+ * Dump the current spectrum as "nm,value" lines
+ */
+void print_spectrum() {
+  Serial.print("\n[SPECTRUM] ");
+  Serial.print(SPECTRUM_POINTS);
+  Serial.print(" points, ");
+  Serial.print(spectral_recon_stats.measured ? "measured" : "model");
+  Serial.print(" matrix, ");
+  Serial.print(SPECTRAL_RECON_USE_DSP ? "esp-dsp" : "scalar");
+  Serial.print(", frames ");
+  Serial.println(spectral_recon_stats.frames);
+  for (uint16_t j = 0; j < SPECTRUM_POINTS; j++) {
+    Serial.print((int)spectrum_nm(j));
+    Serial.print(",");
+    Serial.println(spectral_spectrum[j], 4);
+  }
+  print_spectral_features();
+}
+
+#endif // SPECTRAL_RECONSTRUCT_H
@@ -0,0 +1,238 @@
+/**
+ * Streaming Spectral Statistics
+ * Per-channel and per-index running statistics between acquisition and
+ * the index engine, in fixed memory with O(1) cost per sample
+ *
+ * - Welford mean/variance, min, max over a window of STATS_WINDOW_FRAMES
+ * - EMA and sliding median-of-5 (continuous, never reset)
+ * - Decimated summary frame once per window for telemetry/uplink
+ */
+
+#ifndef SPECTRAL_STATS_H
+#define SPECTRAL_STATS_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "spectral_analysis.h"
+
+// ==========================================
+// STATS CONFIGURATION
+// ==========================================
+
+#define STATS_WINDOW_FRAMES 32     // Frames per summary (decimation factor)
+#define STATS_EMA_ALPHA     0.2f   // EMA weight of the newest sample
+#define STATS_MEDIAN_LEN    5      // Sliding median length (fixed network below)
+
+// Filter applied to spectral_ch[] in place before the indices are computed
+#define STATS_FILTER_NONE       0
+#define STATS_FILTER_MEDIAN     1  // Spike rejection only
+#define STATS_FILTER_MEDIAN_EMA 2  // Median, then EMA smoothing
+#define STATS_FILTER_MODE STATS_FILTER_NONE
+
+// ==========================================
+// STATS STATE
+// ==========================================
+
+/**
+ * Running statistics for one scalar stream
+ */
+struct StreamStat {
+  uint16_t n;                         // Samples in the current window
+  float    mean;                      // Welford running mean
+  float    m2;                        // Welford sum of squared deviations
+  float    min;
+  float    max;
+  float    ema;
+  float    median_buf[STATS_MEDIAN_LEN];
+  uint8_t  median_pos;
+  uint8_t  median_fill;
+};
+
+/**
+ * Window summary for one stream
+ */
+struct StatSummary {
+  float mean;
+  float stddev;
+  float min;
+  float max;
+};
+
+/**
+ * Decimated summary frame - one per STATS_WINDOW_FRAMES frames
+ */
+struct SpectralSummary {
+  uint32_t window;                    // Summary sequence number
+  uint32_t start_ms;                  // First frame timestamp
+  uint32_t end_ms;                    // Last frame timestamp
+  uint16_t frames;                    // Frames in the window
+  StatSummary ch[SPECTRAL_NUM_BANDS];
+  StatSummary idx[SPECTRAL_NUM_INDICES];
+};
+
+StreamStat stats_ch[SPECTRAL_NUM_BANDS];
+StreamStat stats_idx[SPECTRAL_NUM_INDICES];
+
+// Continuous filter outputs per channel / index
+float stats_ch_median[SPECTRAL_NUM_BANDS];
+float stats_ch_ema[SPECTRAL_NUM_BANDS];
+float stats_idx_ema[SPECTRAL_NUM_INDICES];
+
+SpectralSummary spectral_summary;
+bool spectral_summary_ready = false;  // Set when a window closes, cleared by the consumer
+uint32_t stats_window_start_ms = 0;
+uint32_t stats_windows = 0;
+
+// ==========================================
+// STREAM PRIMITIVES
+// ==========================================
+
+void stream_stat_reset_window(StreamStat* s) {
+  s->n = 0;
+  s->mean = 0.0f;
+  s->m2 = 0.0f;
+  s->min = INFINITY;
+  s->max = -INFINITY;
+}
+
+void stream_stat_init(StreamStat* s) {
+  stream_stat_reset_window(s);
+  s->ema = 0.0f;
+  s->median_pos = 0;
+  s->median_fill = 0;
+}
+
+/**
+ * Median of 5 with a fixed 8-compare selection network
+ */
+static inline float stats_median5(const float* v) {
+  float a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], t;
+#define STATS_SORT2(x, y) if (x > y) { t = x; x = y; y = t; }
+  STATS_SORT2(a, b); STATS_SORT2(d, e); STATS_SORT2(a, c);
+  STATS_SORT2(b, c); STATS_SORT2(a, d); STATS_SORT2(c, d);
+  STATS_SORT2(b, e); STATS_SORT2(b, c);
+#undef STATS_SORT2
+  return c;
+}
+
+/**
+ * Add one sample: Welford, min/max, median window and EMA
+ * @return the sample's median-of-5 (the sample itself until the window fills)
+ */
+float stream_stat_push(StreamStat* s, float x) {
+  // Welford
+  s->n++;
+  float delta = x - s->mean;
+  s->mean += delta / s->n;
+  s->m2 += delta * (x - s->mean);
+  if (x < s->min) s->min = x;
+  if (x > s->max) s->max = x;
+
+  // Sliding median
+  s->median_buf[s->median_pos] = x;
+  s->median_pos = (s->median_pos + 1) % STATS_MEDIAN_LEN;
+  if (s->median_fill < STATS_MEDIAN_LEN) s->median_fill++;
+  float median = (s->median_fill == STATS_MEDIAN_LEN) ? stats_median5(s->median_buf) : x;
+
+  // EMA (of the median, so single-frame spikes do not leak into it)
+  s->ema = (s->median_fill == 1) ? median : s->ema + STATS_EMA_ALPHA * (median - s->ema);
+  return median;
+}
+
+void stream_stat_summarise(const StreamStat* s, StatSummary* out) {
+  out->mean = s->mean;
+  out->stddev = (s->n > 1) ? sqrtf(s->m2 / (s->n - 1)) : 0.0f;
+  out->min = s->min;
+  out->max = s->max;
+}
+
+// ==========================================
+// PIPELINE STAGE
+// ==========================================
+
+void spectral_stats_init() {
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) stream_stat_init(&stats_ch[i]);
+  for (int i = 0; i < SPECTRAL_NUM_INDICES; i++) stream_stat_init(&stats_idx[i]);
+  stats_window_start_ms = millis();
+  spectral_summary_ready = false;
+}
+
+/**
+ * Feed the calibrated frame; optionally filter it in place (STATS_FILTER_MODE)
+ * Call after apply_spectral_calibration(), before calculate_all_indices().
+ */
+void spectral_stats_update_channels(float* frame) {
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    stats_ch_median[i] = stream_stat_push(&stats_ch[i], frame[i]);
+    stats_ch_ema[i] = stats_ch[i].ema;
+#if STATS_FILTER_MODE == STATS_FILTER_MEDIAN
+    frame[i] = stats_ch_median[i];
+#elif STATS_FILTER_MODE == STATS_FILTER_MEDIAN_EMA
+    frame[i] = stats_ch_ema[i];
+#endif
+  }
+}
+
+/**
+ * Feed the indices and close the window every STATS_WINDOW_FRAMES frames
+ * Call after calculate_all_indices().
+ * @return true if a new spectral_summary is ready
+ */
+bool spectral_stats_update_indices(const float* indices, uint32_t timestamp_ms) {
+  for (int i = 0; i < SPECTRAL_NUM_INDICES; i++) {
+    stream_stat_push(&stats_idx[i], indices[i]);
+    stats_idx_ema[i] = stats_idx[i].ema;
+  }
+
+  if (stats_idx[0].n == 1) stats_window_start_ms = timestamp_ms;
+  if (stats_idx[0].n < STATS_WINDOW_FRAMES) return false;
+
+  spectral_summary.window = stats_windows++;
+  spectral_summary.start_ms = stats_window_start_ms;
+  spectral_summary.end_ms = timestamp_ms;
+  spectral_summary.frames = stats_idx[0].n;
+  for (int i = 0; i < SPECTRAL_NUM_BANDS; i++) {
+    stream_stat_summarise(&stats_ch[i], &spectral_summary.ch[i]);
+    stream_stat_reset_window(&stats_ch[i]);
+  }
+  for (int i = 0; i < SPECTRAL_NUM_INDICES; i++) {
+    stream_stat_summarise(&stats_idx[i], &spectral_summary.idx[i]);
+    stream_stat_reset_window(&stats_idx[i]);
+  }
+
+  spectral_summary_ready = true;
+  return true;
+}
+
+/**
+ * Print a window summary (index streams)
+ * (defaults to the latest; the pipeline passes its frame copy)
+ */
+void print_spectral_summary(const SpectralSummary& summary = spectral_summary) {
+  static const char* names[SPECTRAL_NUM_INDICES] = {
+    "NDVI", "Chlor", "Anth", "Water", "R:FR", "Photo", "Car", "Flick"
+  };
+
+  Serial.print("\n[SUMMARY] Window ");
+  Serial.print(summary.window);
+  Serial.print(" (");
+  Serial.print(summary.frames);
+  Serial.print(" frames, ");
+  Serial.print(summary.end_ms - summary.start_ms);
+  Serial.println(" ms)  mean / std / min / max");
+  for (int i = 0; i < SPECTRAL_NUM_INDICES; i++) {
+    const StatSummary& s = summary.idx[i];
+    Serial.print("  ");
+    Serial.print(names[i]);
+    Serial.print(": ");
+    Serial.print(s.mean, 3);
+    Serial.print(" / ");
+    Serial.print(s.stddev, 3);
+    Serial.print(" / ");
+    Serial.print(s.min, 3);
+    Serial.print(" / ");
+    Serial.println(s.max, 3);
+  }
+}
+
+#endif // SPECTRAL_STATS_H
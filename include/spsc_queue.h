@@ -0,0 +1,59 @@
+/**
+ * Lock-free Single-Producer / Single-Consumer Queue
+ * Fixed capacity, no allocation - one task pushes, one task pops
+ *
+ * Head and tail are free-running counters, so all N slots are usable
+ * (count = head - tail). N must be a power of two.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+  SpscQueue() : head_(0), tail_(0) {}
+
+  /**
+   * Producer side
+   * @return false if the queue is full
+   */
+  bool push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= N) return false;
+    items_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Consumer side
+   * @return false if the queue is empty
+   */
+  bool pop(T* item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return false;
+    *item = items_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+  static constexpr uint32_t capacity() { return N; }
+
+private:
+  T items_[N];
+  std::atomic<uint32_t> head_;   // Written by the producer only
+  std::atomic<uint32_t> tail_;   // Written by the consumer only
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,116 @@
+/**
+ * Serial Telemetry Output
+ * Text reports for humans, or compact binary frames for logging rigs
+ *
+ * Binary frames go into the UART driver's TX ring buffer and are drained
+ * by the UART interrupt, so sending never blocks loop(). If the ring is
+ * full the frame is dropped and counted. Host decoder: read_telemetry.py
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "as7343_sensor.h"
+#include "spectral_analysis.h"
+#include "lora_functions.h"
+
+// ==========================================
+// TELEMETRY CONFIGURATION
+// ==========================================
+
+#define TELEMETRY_TEXT   0    // Human-readable serial reports (throttled)
+#define TELEMETRY_BINARY 1    // One binary frame per sensor frame
+
+#define TELEMETRY_MODE TELEMETRY_TEXT
+
+#define TELEMETRY_TX_BUFFER 4096  // UART driver TX ring (bytes)
+
+#define TELEMETRY_SYNC_0   0xAA
+#define TELEMETRY_SYNC_1   0x55
+#define TELEMETRY_VERSION  1
+
+// ==========================================
+// BINARY FRAME LAYOUT
+// ==========================================
+
+/**
+ * Binary telemetry frame (little-endian, 78 bytes)
+ * CRC is CRC-16/MODBUS over every byte before the crc field.
+ */
+struct __attribute__((packed)) TelemetryFrame {
+  uint8_t  sync[2];                          // TELEMETRY_SYNC_0, TELEMETRY_SYNC_1
+  uint8_t  version;                          // TELEMETRY_VERSION
+  uint8_t  length;                           // sizeof(TelemetryFrame)
+  uint32_t seq;                              // as7343_frame.seq
+  uint32_t timestamp_ms;                     // as7343_frame.timestamp_ms
+  uint16_t ch[AS7343_NUM_CHANNELS];          // Raw counts, AS7343Channel order
+  float    indices[SPECTRAL_NUM_INDICES];    // spectral_indices[]
+  uint8_t  health[4];                        // Vigor, chlorophyll, stress, water (0-5)
+  uint8_t  gain;                             // AGAIN code the frame was taken with
+  uint8_t  atime;                            // ATIME the frame was taken with
+  uint16_t crc;
+};
+
+static_assert(sizeof(TelemetryFrame) == 78, "TelemetryFrame layout changed - update read_telemetry.py");
+
+uint8_t telemetry_mode = TELEMETRY_MODE;
+uint32_t telemetry_sent = 0;
+uint32_t telemetry_dropped = 0;
+
+// ==========================================
+// TELEMETRY FUNCTIONS
+// ==========================================
+
+/**
+ * Size the UART TX ring buffer
+ * Must be called BEFORE Serial.begin() - the driver allocates it there
+ */
+void telemetry_init() {
+  Serial.setTxBufferSize(TELEMETRY_TX_BUFFER);
+}
+
+/**
+ * Fill a binary frame from a sensor frame, its indices and health
+ * (defaults to the current frame; the pipeline passes its frame copy)
+ */
+void telemetry_build_frame(TelemetryFrame* f, const AS7343Frame& frame = as7343_frame,
+                           const uint16_t* ch = as7343_ch, const float* indices = spectral_indices,
+                           const HealthLevels& health = health_levels,
+                           const AS7343Exposure& exposure = as7343_exposure) {
+  f->sync[0] = TELEMETRY_SYNC_0;
+  f->sync[1] = TELEMETRY_SYNC_1;
+  f->version = TELEMETRY_VERSION;
+  f->length = sizeof(TelemetryFrame);
+  f->seq = frame.seq;
+  f->timestamp_ms = frame.timestamp_ms;
+  memcpy(f->ch, ch, sizeof(f->ch));
+  memcpy(f->indices, indices, sizeof(f->indices));
+  f->health[0] = health.vigor;
+  f->health[1] = health.chlorophyll;
+  f->health[2] = health.stress;
+  f->health[3] = health.water;
+  f->gain = frame.astatus & 0x0F;
+  f->atime = exposure.atime;
+  f->crc = calculateCRC16((uint8_t*)f, sizeof(TelemetryFrame) - sizeof(f->crc));
+}
+
+/**
+ * Queue one binary frame for the UART without blocking
+ * @return true if queued, false if the TX ring was full (frame dropped)
+ */
+bool telemetry_send_frame() {
+  TelemetryFrame frame;
+
+  if (Serial.availableForWrite() < (int)sizeof(frame)) {
+    telemetry_dropped++;
+    return false;
+  }
+
+  telemetry_build_frame(&frame);
+  Serial.write((const uint8_t*)&frame, sizeof(frame));
+  telemetry_sent++;
+  return true;
+}
+
+#endif // TELEMETRY_H
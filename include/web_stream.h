@@ -0,0 +1,362 @@
+/**
+ * Live Spectral Stream
+ * Server-Sent Events and raw binary push of every sensor frame over WiFi
+ *
+ * A separate listener (WEB_STREAM_PORT) keeps subscriber sockets open:
+ *   GET /events  text/event-stream, one JSON "frame" event per sensor frame
+ *                (calibrated channels, raw counts, indices, health, exposure)
+ *   GET /frames  application/octet-stream, back-to-back TelemetryFrames
+ *                (the serial binary format - read_telemetry.py decodes it)
+ *
+ * Each format is serialised once per frame into a static buffer and sent
+ * to all its subscribers with non-blocking socket writes. A client whose
+ * socket buffer is full keeps its unsent tail in its own slot buffer and
+ * skips frames until that drains, so a slow browser loses frames instead
+ * of stalling acquisition; a client stuck for WEB_STREAM_STALL_MS is
+ * dropped. No heap allocation per frame.
+ *
+ * Both calls run on the output side, never beside acquisition: with the
+ * pipeline that is the core-0 output task (web_stream_poll() from the
+ * network hook, web_stream_frame() as pipe_frame_hook), otherwise loop().
+ * Frames are serialised from the PipelineFrame copy, not the globals.
+ */
+
+#ifndef WEB_STREAM_H
+#define WEB_STREAM_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include "spectral_analysis.h"
+#include "telemetry.h"
+#include "pipeline_stages.h"
+
+// ==========================================
+// STREAM CONFIGURATION
+// ==========================================
+
+#define WEB_STREAM_PORT         81
+#define WEB_STREAM_MAX_CLIENTS  4
+#define WEB_STREAM_MSG_MAX      768         // Largest serialised frame (SSE JSON)
+#define WEB_STREAM_REQ_MAX      48          // Request line bytes kept
+#define WEB_STREAM_REQ_TIMEOUT  2000        // ms to receive the request line
+#define WEB_STREAM_STALL_MS     10000       // Drop a client that accepts nothing this long
+#define WEB_STREAM_KEEPALIVE_MS 15000       // SSE comment when no frames flow
+
+// ==========================================
+// STREAM STATE
+// ==========================================
+
+enum WebStreamMode : uint8_t {
+    WEB_STREAM_FREE = 0,
+    WEB_STREAM_REQUEST,         // Connected, waiting for the request line
+    WEB_STREAM_SSE,
+    WEB_STREAM_BINARY
+};
+
+struct WebStreamClient {
+    WiFiClient client;
+    WebStreamMode mode;
+    uint8_t  req_len;
+    char     req[WEB_STREAM_REQ_MAX];
+    uint32_t since;             // millis() of connect / last successful write
+    uint16_t pend_len;          // Unsent tail of the last message
+    uint16_t pend_off;
+    uint8_t  pend[WEB_STREAM_MSG_MAX];
+    uint32_t sent;              // Frames fully handed to the socket
+    uint32_t skipped;           // Frames skipped while pend was draining
+};
+
+struct WebStreamStats {
+    uint32_t connects;
+    uint32_t rejects;           // No free slot / unknown path
+    uint32_t frames;            // Frames serialised
+    uint32_t skipped;           // Client-frames lost to backpressure
+    uint32_t stalls;            // Clients dropped for not reading
+};
+
+WiFiServer web_stream_server(WEB_STREAM_PORT);
+WebStreamClient web_stream_clients[WEB_STREAM_MAX_CLIENTS];
+WebStreamStats web_stream_stats = {0, 0, 0, 0, 0};
+bool web_stream_running = false;
+uint32_t web_stream_last_frame = 0;
+
+// Per-frame serialisation buffers, shared by all subscribers of a format
+char web_stream_json[WEB_STREAM_MSG_MAX];
+TelemetryFrame web_stream_bin;
+
+// ==========================================
+// SOCKET I/O
+// ==========================================
+
+/**
+ * Non-blocking write
+ * @return bytes accepted (0 if the socket buffer is full), -1 on error
+ */
+int web_stream_write(WebStreamClient& c, const uint8_t* data, size_t len) {
+    int n = send(c.client.fd(), data, len, MSG_DONTWAIT);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    return n;
+}
+
+void web_stream_close(WebStreamClient& c) {
+    c.client.stop();
+    c.mode = WEB_STREAM_FREE;
+    c.pend_len = 0;
+}
+
+/**
+ * Push the unsent tail of the previous message
+ * @return true once nothing is pending
+ */
+bool web_stream_flush_pending(WebStreamClient& c) {
+    if (c.pend_len == 0) return true;
+    int n = web_stream_write(c, c.pend + c.pend_off, c.pend_len - c.pend_off);
+    if (n < 0) {
+        web_stream_close(c);
+        return false;
+    }
+    if (n > 0) c.since = millis();
+    c.pend_off += n;
+    if (c.pend_off < c.pend_len) return false;
+    c.pend_len = 0;
+    return true;
+}
+
+/**
+ * Send one whole message or start it and park the remainder in the slot
+ */
+void web_stream_send(WebStreamClient& c, const uint8_t* data, size_t len) {
+    if (!web_stream_flush_pending(c)) {
+        if (c.mode != WEB_STREAM_FREE) {
+            c.skipped++;
+            web_stream_stats.skipped++;
+        }
+        return;
+    }
+    int n = web_stream_write(c, data, len);
+    if (n < 0) {
+        web_stream_close(c);
+        return;
+    }
+    if (n > 0) c.since = millis();
+    if ((size_t)n < len) {
+        c.pend_len = len - n;
+        c.pend_off = 0;
+        memcpy(c.pend, data + n, c.pend_len);
+    }
+    c.sent++;
+}
+
+// ==========================================
+// SUBSCRIPTIONS
+// ==========================================
+
+const char web_stream_sse_header[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: keep-alive\r\n\r\n"
+    "retry: 2000\n"
+    "event: meta\n"
+    "data: {\"channels\":[405,425,450,475,515,550,555,600,640,690,745,855,\"clr\"],"
+    "\"indices\":[\"ndvi\",\"chlorophyll\",\"anthocyanin\",\"water_stress\","
+    "\"red_far_red\",\"photosyn\",\"carotenoid\",\"flicker\"]}\n\n";
+
+const char web_stream_bin_header[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Connection: close\r\n\r\n";
+
+/**
+ * Read the request line of a new connection and subscribe it
+ */
+void web_stream_handshake(WebStreamClient& c) {
+    while (c.client.available() > 0) {
+        int ch = c.client.read();
+        if (ch < 0) break;
+        if (ch == '\n') {
+            c.req[c.req_len] = '\0';
+            const char* hdr = NULL;
+            if (strncmp(c.req, "GET /events", 11) == 0) {
+                c.mode = WEB_STREAM_SSE;
+                hdr = web_stream_sse_header;
+            } else if (strncmp(c.req, "GET /frames", 11) == 0) {
+                c.mode = WEB_STREAM_BINARY;
+                hdr = web_stream_bin_header;
+            } else {
+                c.client.print("HTTP/1.1 404 Not Found\r\nConnection: close\r\n\r\n");
+                web_stream_stats.rejects++;
+                web_stream_close(c);
+                return;
+            }
+            c.client.setNoDelay(true);
+            c.since = millis();
+            web_stream_send(c, (const uint8_t*)hdr, strlen(hdr));
+            web_stream_stats.connects++;
+            return;
+        }
+        if (c.req_len < WEB_STREAM_REQ_MAX - 1) c.req[c.req_len++] = (char)ch;
+    }
+    if (millis() - c.since > WEB_STREAM_REQ_TIMEOUT) web_stream_close(c);
+}
+
+// ==========================================
+// STREAM API
+// ==========================================
+
+/**
+ * Start the stream listener (call once WiFi is up)
+ */
+void web_stream_init() {
+    if (web_stream_running) return;
+    web_stream_server.begin();
+    web_stream_server.setNoDelay(true);
+    web_stream_running = true;
+    Serial.print("[Stream] SSE /events, binary /frames on port ");
+    Serial.println(WEB_STREAM_PORT);
+}
+
+/**
+ * Accept subscribers, finish handshakes, drain pending tails and drop
+ * stalled or closed clients (call every loop() iteration)
+ */
+void web_stream_poll() {
+    if (!web_stream_running) return;
+    uint32_t now = millis();
+
+    WiFiClient incoming = web_stream_server.available();
+    if (incoming) {
+        int slot = -1;
+        for (int i = 0; i < WEB_STREAM_MAX_CLIENTS; i++) {
+            if (web_stream_clients[i].mode == WEB_STREAM_FREE) { slot = i; break; }
+        }
+        if (slot < 0) {
+            incoming.print("HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n");
+            incoming.stop();
+            web_stream_stats.rejects++;
+        } else {
+            WebStreamClient& c = web_stream_clients[slot];
+            c.client = incoming;
+            c.mode = WEB_STREAM_REQUEST;
+            c.req_len = 0;
+            c.since = now;
+            c.pend_len = 0;
+            c.sent = 0;
+            c.skipped = 0;
+        }
+    }
+
+    bool keepalive = (now - web_stream_last_frame > WEB_STREAM_KEEPALIVE_MS);
+    for (int i = 0; i < WEB_STREAM_MAX_CLIENTS; i++) {
+        WebStreamClient& c = web_stream_clients[i];
+        if (c.mode == WEB_STREAM_FREE) continue;
+        if (!c.client.connected()) {
+            web_stream_close(c);
+            continue;
+        }
+        if (c.mode == WEB_STREAM_REQUEST) {
+            web_stream_handshake(c);
+            continue;
+        }
+        if (c.pend_len > 0) {
+            web_stream_flush_pending(c);
+            if (c.mode != WEB_STREAM_FREE && c.pend_len > 0 && now - c.since > WEB_STREAM_STALL_MS) {
+                web_stream_stats.stalls++;
+                web_stream_close(c);
+            }
+        } else if (keepalive && c.mode == WEB_STREAM_SSE) {
+            web_stream_send(c, (const uint8_t*)":\n\n", 3);   // Keeps proxies from timing out
+        }
+    }
+    if (keepalive) web_stream_last_frame = now;
+}
+
+/**
+ * Number of subscribed clients
+ */
+int web_stream_subscribers(WebStreamMode mode) {
+    int n = 0;
+    for (int i = 0; i < WEB_STREAM_MAX_CLIENTS; i++) {
+        if (web_stream_clients[i].mode == mode) n++;
+    }
+    return n;
+}
+
+/**
+ * Serialise a frame as one SSE event
+ * @return event length in web_stream_json
+ */
+size_t web_stream_build_json(const PipelineFrame& f) {
+    char* p = web_stream_json;
+    char* end = web_stream_json + sizeof(web_stream_json);
+    p += snprintf(p, end - p, "event: frame\ndata: {\"seq\":%u,\"ts\":%u,\"cal\":[",
+                  (unsigned)f.frame.seq, (unsigned)f.frame.timestamp_ms);
+    for (int i = 0; i < SPECTRAL_NUM_BANDS && p < end; i++) {
+        p += snprintf(p, end - p, i ? ",%.4g" : "%.4g", f.cal[i]);
+    }
+    if (p < end) p += snprintf(p, end - p, "],\"raw\":[");
+    for (int i = 0; i < AS7343_NUM_CHANNELS && p < end; i++) {
+        p += snprintf(p, end - p, i ? ",%u" : "%u", f.ch[i]);
+    }
+    if (p < end) p += snprintf(p, end - p, "],\"idx\":[");
+    for (int i = 0; i < SPECTRAL_NUM_INDICES && p < end; i++) {
+        p += snprintf(p, end - p, i ? ",%.5g" : "%.5g", f.indices[i]);
+    }
+    if (p < end) {
+        p += snprintf(p, end - p, "],\"health\":[%u,%u,%u,%u],\"gain\":%u,\"atime\":%u,\"astep\":%u}\n\n",
+                      f.health.vigor, f.health.chlorophyll, f.health.stress, f.health.water,
+                      f.exposure.gain, f.exposure.atime, f.exposure.astep);
+    }
+    return (p < end) ? (size_t)(p - web_stream_json) : 0;   // 0 = truncated, not sent
+}
+
+/**
+ * Push a frame to every subscriber
+ * Each format is only built if someone is subscribed to it.
+ */
+void web_stream_frame(const PipelineFrame& f) {
+    if (!web_stream_running) return;
+    web_stream_last_frame = millis();
+
+    size_t json_len = 0;
+    bool have_bin = false;
+    if (web_stream_subscribers(WEB_STREAM_SSE) > 0) json_len = web_stream_build_json(f);
+    if (web_stream_subscribers(WEB_STREAM_BINARY) > 0) {
+        telemetry_build_frame(&web_stream_bin, f.frame, f.ch, f.indices, f.health, f.exposure);
+        have_bin = true;
+    }
+    if (json_len == 0 && !have_bin) return;
+    web_stream_stats.frames++;
+
+    for (int i = 0; i < WEB_STREAM_MAX_CLIENTS; i++) {
+        WebStreamClient& c = web_stream_clients[i];
+        if (c.mode == WEB_STREAM_SSE && json_len > 0) {
+            web_stream_send(c, (const uint8_t*)web_stream_json, json_len);
+        } else if (c.mode == WEB_STREAM_BINARY && have_bin) {
+            web_stream_send(c, (const uint8_t*)&web_stream_bin, sizeof(web_stream_bin));
+        }
+    }
+}
+
+void print_web_stream_stats() {
+    Serial.print("[Stream] Clients SSE:");
+    Serial.print(web_stream_subscribers(WEB_STREAM_SSE));
+    Serial.print(" bin:");
+    Serial.print(web_stream_subscribers(WEB_STREAM_BINARY));
+    Serial.print(" Frames:");
+    Serial.print(web_stream_stats.frames);
+    Serial.print(" Skipped:");
+    Serial.print(web_stream_stats.skipped);
+    Serial.print(" Stalled:");
+    Serial.print(web_stream_stats.stalls);
+    Serial.print(" Connects:");
+    Serial.print(web_stream_stats.connects);
+    Serial.print(" Rejects:");
+    Serial.println(web_stream_stats.rejects);
+}
+
+#endif // WEB_STREAM_H
@@ -11,6 +11,7 @@
 #include <PubSubClient.h>
 #include <WebServer.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
 #include "lora_config.h"
 
 // ==========================================
@@ -47,6 +48,64 @@ extern struct Config {
     String device_name;
 } config;
 
+// ==========================================
+// WIFI MANAGER STATE
+// ==========================================
+
+#define WIFI_FAST_CONNECT_TIMEOUT 3000  // Cached BSSID/channel attempt (ms)
+#define WIFI_RETRY_BACKOFF_MS     30000 // Pause after all networks failed
+#define WIFI_CACHE_MAGIC          0x57494643  // "WIFC"
+#define WIFI_CACHE_NVS_NS         "wifi"
+#define WIFI_CACHE_NVS_KEY        "last"
+
+struct WifiNetwork {
+    const char* ssid;
+    const char* pass;
+};
+
+const WifiNetwork wifi_networks[] = {
+    { WIFI_SSID_1, WIFI_PASS_1 },
+    { WIFI_SSID_2, WIFI_PASS_2 },
+    { WIFI_SSID_3, WIFI_PASS_3 }
+};
+#define WIFI_NETWORK_COUNT (sizeof(wifi_networks) / sizeof(wifi_networks[0]))
+
+/**
+ * Last good access point - kept in RTC memory across deep sleep and in
+ * NVS across power loss
+ */
+struct WifiCache {
+    uint32_t magic;
+    uint8_t  network;           // Index into wifi_networks
+    uint8_t  channel;
+    uint8_t  bssid[6];
+};
+
+RTC_DATA_ATTR WifiCache wifi_rtc_cache = {0, 0, 0, {0}};
+
+enum WifiMgrState : uint8_t {
+    WIFI_MGR_IDLE = 0,
+    WIFI_MGR_FAST,              // Cached AP, fixed channel + BSSID
+    WIFI_MGR_LIST,              // Trying wifi_networks[] in order
+    WIFI_MGR_CONNECTED,
+    WIFI_MGR_BACKOFF
+};
+
+struct WifiManager {
+    WifiMgrState state;
+    uint8_t  network;           // Network of the current WIFI_MGR_LIST attempt
+    volatile bool got_ip;       // Set by the event handler
+    volatile bool disconnected;
+    uint32_t attempt_start;     // millis() of the current attempt
+    uint32_t connect_start;     // millis() when the connection was lost / boot
+    uint32_t last_latency_ms;   // connect_start -> GOT_IP
+    uint32_t fast_hits;
+    uint32_t fast_misses;
+    uint32_t connects;
+};
+
+WifiManager wifi_mgr = {WIFI_MGR_IDLE, 0, false, false, 0, 0, 0, 0, 0, 0};
+
 // ==========================================
 // WIFI EVENT HANDLER
 // ==========================================
@@ -68,6 +127,7 @@ void wifi_event_handler(WiFiEvent_t event) {
         case ARDUINO_EVENT_WIFI_STA_GOT_IP:
             Serial.print("[WiFi] Got IP: ");
             Serial.println(WiFi.localIP());
+            wifi_mgr.got_ip = true;         // Latency / cache handled in wifi_manager_poll()
             sysStatus.wifi_connected = true;
             sysStatus.ip_address = WiFi.localIP().toString();
             sysStatus.wifi_ssid = WiFi.SSID();
@@ -75,6 +135,7 @@ void wifi_event_handler(WiFiEvent_t event) {
             
         case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
             Serial.println("[WiFi] Disconnected from SSID");
+            wifi_mgr.disconnected = true;
             sysStatus.wifi_connected = false;
             break;
             
@@ -100,6 +161,8 @@ void wifi_event_handler(WiFiEvent_t event) {
 // MQTT CALLBACK & FUNCTIONS
 // ==========================================
 
+#define MQTT_ECHO_PUBLISH 0     // Echo every published payload to Serial (debug only)
+
 /**
  * MQTT Message Callback
  * Called when message received on subscribed topic
@@ -167,10 +230,12 @@ bool mqtt_publish(const char* topic, const char* message) {
     }
     
     if (mqttClient.publish(topic, message)) {
+#if MQTT_ECHO_PUBLISH
         Serial.print("[MQTT] Published to ");
         Serial.print(topic);
         Serial.print(": ");
         Serial.println(message);
+#endif
         return true;
     }
     
@@ -182,65 +247,159 @@ bool mqtt_publish(const char* topic, const char* message) {
 // ==========================================
 
 /**
- * Initialize WiFi in Station Mode (client)
- * Attempts to connect to known networks
- * @return true if connected successfully
+ * Load the AP cache: RTC copy first (deep-sleep wake), then NVS
+ * @return true if a valid cache entry is available
  */
-bool init_wifi_sta() {
-    Serial.println("[WiFi] Initializing Station Mode...");
-    WiFi.onEvent(wifi_event_handler);
-    WiFi.mode(WIFI_STA);
-    
-    // Try first network
-    Serial.println("[WiFi] Attempting to connect to: " + String(WIFI_SSID_1));
-    WiFi.begin(WIFI_SSID_1, WIFI_PASS_1);
-    
-    int timeout = WIFI_CONNECT_TIMEOUT / 100;  // 100ms units
-    while (!sysStatus.wifi_connected && timeout > 0) {
-        delay(100);
-        timeout--;
-        Serial.print(".");
+bool wifi_cache_load() {
+    if (wifi_rtc_cache.magic == WIFI_CACHE_MAGIC) return true;
+
+    Preferences prefs;
+    if (!prefs.begin(WIFI_CACHE_NVS_NS, true)) return false;
+    WifiCache c;
+    size_t len = prefs.getBytes(WIFI_CACHE_NVS_KEY, &c, sizeof(c));
+    prefs.end();
+
+    if (len != sizeof(c) || c.magic != WIFI_CACHE_MAGIC || c.network >= WIFI_NETWORK_COUNT) return false;
+    wifi_rtc_cache = c;
+    return true;
+}
+
+/**
+ * Remember the AP we are connected to (NVS written only when it changed)
+ */
+void wifi_cache_store(uint8_t network) {
+    WifiCache c;
+    c.magic = WIFI_CACHE_MAGIC;
+    c.network = network;
+    c.channel = WiFi.channel();
+    memcpy(c.bssid, WiFi.BSSID(), 6);
+
+    if (memcmp(&c, &wifi_rtc_cache, sizeof(c)) == 0) return;
+    wifi_rtc_cache = c;
+
+    Preferences prefs;
+    if (prefs.begin(WIFI_CACHE_NVS_NS, false)) {
+        prefs.putBytes(WIFI_CACHE_NVS_KEY, &c, sizeof(c));
+        prefs.end();
     }
-    
-    if (sysStatus.wifi_connected) {
-        Serial.println("\n[WiFi] Connected!");
-        return true;
+}
+
+/**
+ * Forget the cached AP in RTC and NVS, so the next cycle (or boot) starts
+ * from the network list
+ */
+void wifi_cache_invalidate() {
+    wifi_rtc_cache.magic = 0;
+
+    Preferences prefs;
+    if (prefs.begin(WIFI_CACHE_NVS_NS, false)) {
+        prefs.remove(WIFI_CACHE_NVS_KEY);
+        prefs.end();
     }
-    
-    // Try second network
-    Serial.println("[WiFi] First network failed. Trying: " + String(WIFI_SSID_2));
-    WiFi.begin(WIFI_SSID_2, WIFI_PASS_2);
-    
-    timeout = WIFI_CONNECT_TIMEOUT / 100;
-    while (!sysStatus.wifi_connected && timeout > 0) {
-        delay(100);
-        timeout--;
-        Serial.print(".");
+}
+
+void wifi_start_attempt(WifiMgrState state, uint8_t network) {
+    const WifiNetwork& n = wifi_networks[network];
+    wifi_mgr.state = state;
+    wifi_mgr.network = network;
+    wifi_mgr.got_ip = false;
+    wifi_mgr.disconnected = false;
+    wifi_mgr.attempt_start = millis();
+
+    if (state == WIFI_MGR_FAST) {
+        Serial.print("[WiFi] Fast connect: ");
+        Serial.print(n.ssid);
+        Serial.print(" ch");
+        Serial.println(wifi_rtc_cache.channel);
+        WiFi.begin(n.ssid, n.pass, wifi_rtc_cache.channel, wifi_rtc_cache.bssid);
+    } else {
+        Serial.print("[WiFi] Connecting: ");
+        Serial.println(n.ssid);
+        WiFi.begin(n.ssid, n.pass);
     }
-    
-    if (sysStatus.wifi_connected) {
-        Serial.println("\n[WiFi] Connected!");
-        return true;
+}
+
+/**
+ * Start a connection cycle: cached AP first, then the network list
+ */
+void wifi_connect_cycle() {
+    wifi_mgr.connect_start = millis();
+    if (wifi_cache_load()) {
+        wifi_start_attempt(WIFI_MGR_FAST, wifi_rtc_cache.network);
+    } else {
+        wifi_start_attempt(WIFI_MGR_LIST, 0);
     }
-    
-    // Try third network
-    Serial.println("[WiFi] Second network failed. Trying: " + String(WIFI_SSID_3));
-    WiFi.begin(WIFI_SSID_3, WIFI_PASS_3);
-    
-    timeout = WIFI_CONNECT_TIMEOUT / 100;
-    while (!sysStatus.wifi_connected && timeout > 0) {
-        delay(100);
-        timeout--;
-        Serial.print(".");
+}
+
+/**
+ * Advance the WiFi manager - call from loop(), never blocks
+ */
+void wifi_manager_poll() {
+    uint32_t now = millis();
+
+    if (wifi_mgr.got_ip && wifi_mgr.state != WIFI_MGR_CONNECTED) {
+        if (wifi_mgr.state == WIFI_MGR_FAST) wifi_mgr.fast_hits++;
+        wifi_mgr.last_latency_ms = now - wifi_mgr.connect_start;
+        wifi_mgr.connects++;
+        wifi_mgr.state = WIFI_MGR_CONNECTED;
+        wifi_cache_store(wifi_mgr.network);
+        Serial.print("[WiFi] Connected in ");
+        Serial.print(wifi_mgr.last_latency_ms);
+        Serial.println(" ms");
+        return;
     }
-    
-    if (sysStatus.wifi_connected) {
-        Serial.println("\n[WiFi] Connected!");
-        return true;
+
+    switch (wifi_mgr.state) {
+        case WIFI_MGR_IDLE:
+            break;
+
+        case WIFI_MGR_FAST:
+            if (wifi_mgr.disconnected || now - wifi_mgr.attempt_start >= WIFI_FAST_CONNECT_TIMEOUT) {
+                // AP moved channel or is gone - forget it and fall back to the list
+                wifi_mgr.fast_misses++;
+                wifi_cache_invalidate();
+                wifi_start_attempt(WIFI_MGR_LIST, 0);
+            }
+            break;
+
+        case WIFI_MGR_LIST:
+            if (now - wifi_mgr.attempt_start >= WIFI_CONNECT_TIMEOUT) {
+                if (wifi_mgr.network + 1 < (int)WIFI_NETWORK_COUNT) {
+                    wifi_start_attempt(WIFI_MGR_LIST, wifi_mgr.network + 1);
+                } else {
+                    Serial.println("[WiFi] All networks failed");
+                    WiFi.disconnect();
+                    wifi_mgr.state = WIFI_MGR_BACKOFF;
+                    wifi_mgr.attempt_start = now;
+                }
+            }
+            break;
+
+        case WIFI_MGR_CONNECTED:
+            if (wifi_mgr.disconnected) wifi_connect_cycle();
+            break;
+
+        case WIFI_MGR_BACKOFF:
+            if (now - wifi_mgr.attempt_start >= WIFI_RETRY_BACKOFF_MS) wifi_connect_cycle();
+            break;
     }
-    
-    Serial.println("\n[WiFi] All networks failed");
-    return false;
+}
+
+/**
+ * Initialize WiFi in Station Mode (client)
+ * Starts a background connection and returns immediately - the cached
+ * AP is tried first, then WIFI_SSID_1..3; progress is driven by
+ * wifi_manager_poll()
+ * @return true if already connected
+ */
+bool init_wifi_sta() {
+    Serial.println("[WiFi] Initializing Station Mode...");
+    WiFi.onEvent(wifi_event_handler);
+    WiFi.persistent(false);         // Manager keeps its own cache; no SDK flash writes
+    WiFi.setAutoReconnect(false);   // Reconnects go through the fast path
+    WiFi.mode(WIFI_STA);
+    wifi_connect_cycle();
+    return sysStatus.wifi_connected;
 }
 
 /**
@@ -269,10 +428,10 @@ bool init_wifi_ap(const char* ssid, const char* password) {
 }
 
 /**
- * Get current WiFi status as JSON
- * @return JSON string with WiFi status
+ * Serialise the current WiFi status as JSON into a caller buffer
+ * @return JSON length (0 if it did not fit)
  */
-String get_wifi_status_json() {
+size_t get_wifi_status_json(char* out, size_t cap) {
     StaticJsonDocument<256> doc;
     
     doc["connected"] = sysStatus.wifi_connected;
@@ -282,10 +441,20 @@ String get_wifi_status_json() {
     doc["ap_ip"] = sysStatus.ap_ip;
     doc["mqtt_connected"] = sysStatus.mqtt_connected;
     doc["signal_strength"] = WiFi.RSSI();
+    doc["connect_ms"] = wifi_mgr.last_latency_ms;
     
-    String json;
-    serializeJson(doc, json);
-    return json;
+    if (measureJson(doc) >= cap) return 0;
+    return serializeJson(doc, out, cap);
+}
+
+/**
+ * Get current WiFi status as JSON
+ * @return JSON string with WiFi status
+ */
+String get_wifi_status_json() {
+    static char json[256];
+    json[get_wifi_status_json(json, sizeof(json))] = '\0';
+    return String(json);
 }
 
 /**
@@ -314,6 +483,14 @@ void print_wifi_diagnostics() {
         Serial.println(sysStatus.ap_ip);
     }
     
+    Serial.print("  Last Connect: ");
+    Serial.print(wifi_mgr.last_latency_ms);
+    Serial.print(" ms (fast ");
+    Serial.print(wifi_mgr.fast_hits);
+    Serial.print("/");
+    Serial.print(wifi_mgr.fast_hits + wifi_mgr.fast_misses);
+    Serial.println(")");
+    
     Serial.print("  MQTT Connected: ");
     Serial.println(sysStatus.mqtt_connected ? "Yes" : "No");
 }
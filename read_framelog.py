@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Export and decode the on-device frame log (include/framelog.h)
+
+Usage:
+    python read_framelog.py [PORT] [BAUD] [--bin out.bin] [--csv out.csv]
+    python read_framelog.py --file framelog.bin [--csv out.csv]
+
+Over serial the script sends 'L', waits for the "FRAMELOG <bytes>" header
+and reads the raw records. A file can come from --bin or from the HTTP
+route (curl -o framelog.bin http://<gateway>/framelog).
+Erased slots (seq 0xFFFFFFFF) and records failing CRC-16/MODBUS are skipped.
+"""
+import struct
+import sys
+import time
+
+VERSION = 1
+ERASED = 0xFFFFFFFF
+NUM_CHANNELS = 13
+NUM_INDICES = 7
+
+# Must match struct FrameLogRecord (packed, little-endian)
+RECORD_FMT = '<II%dH%de2BBBHBBBBIH' % (NUM_CHANNELS, NUM_INDICES)
+RECORD_LEN = struct.calcsize(RECORD_FMT)  # 64
+
+CHANNEL_NAMES = ['405', '425', '450', '475', '515', '550', '555',
+                 '600', '640', '690', '745', '855', 'CLR']
+INDEX_NAMES = ['ndvi', 'chlorophyll', 'anthocyanin', 'water_stress',
+               'red_far_red', 'photosyn', 'carotenoid']
+HEALTH_NAMES = ['vigor', 'chlor', 'stress', 'water']
+
+
+def crc16_modbus(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def decode_record(raw):
+    """Return a dict for one RECORD_LEN-byte record, None if erased,
+    False if corrupt."""
+    fields = struct.unpack(RECORD_FMT, raw)
+    if fields[0] == ERASED:
+        return None
+    if crc16_modbus(raw[:-2]) != fields[-1]:
+        return False
+
+    pos = 2
+    ch = fields[pos:pos + NUM_CHANNELS]
+    pos += NUM_CHANNELS
+    idx = fields[pos:pos + NUM_INDICES]
+    pos += NUM_INDICES
+    h0, h1 = fields[pos], fields[pos + 1]
+    pos += 2
+    gain, atime, astep, agc, peak, mains, version, frame_seq = fields[pos:pos + 8]
+    if version != VERSION:
+        return False
+    return {'seq': fields[0], 'ts': fields[1], 'ch': ch, 'idx': idx,
+            'health': (h0 & 0x0F, h0 >> 4, h1 & 0x0F, h1 >> 4),
+            'gain': gain, 'atime': atime, 'astep': astep,
+            'agc_idx': agc & 0x0F, 'saturated': (agc >> 4) & 1, 'settle': agc >> 5,
+            'peak': peak / 255.0, 'mains_hz': mains, 'frame_seq': frame_seq}
+
+
+def decode_log(data):
+    """Decode a raw export; returns (records sorted by seq, corrupt count)."""
+    out = []
+    corrupt = 0
+    for off in range(0, len(data) - RECORD_LEN + 1, RECORD_LEN):
+        r = decode_record(data[off:off + RECORD_LEN])
+        if r is False:
+            corrupt += 1
+        elif r is not None:
+            out.append(r)
+    out.sort(key=lambda r: r['seq'])
+    return out, corrupt
+
+
+def read_serial(port, baud):
+    import serial
+    ser = serial.Serial(port, baud, timeout=2)
+    ser.reset_input_buffer()
+    ser.write(b'L')
+    deadline = time.time() + 10
+    while time.time() < deadline:
+        line = ser.readline().decode('ascii', 'replace').strip()
+        if line.startswith('FRAMELOG '):
+            size = int(line.split()[1])
+            break
+    else:
+        raise RuntimeError('no FRAMELOG header from %s' % port)
+
+    data = bytearray()
+    start = time.time()
+    while len(data) < size:
+        chunk = ser.read(min(65536, size - len(data)))
+        if not chunk:
+            raise RuntimeError('export stalled at %d/%d bytes' % (len(data), size))
+        data.extend(chunk)
+    elapsed = max(time.time() - start, 1e-3)
+    sys.stderr.write('%d bytes in %.1f s (%.1f KB/s)\n'
+                     % (size, elapsed, size / 1024.0 / elapsed))
+    return bytes(data)
+
+
+def csv_header():
+    return ','.join(['seq', 'ts_ms', 'frame_seq'] + CHANNEL_NAMES + INDEX_NAMES +
+                    HEALTH_NAMES + ['gain', 'atime', 'astep', 'agc_idx',
+                                    'saturated', 'settle', 'peak', 'mains_hz'])
+
+
+def csv_row(r):
+    vals = [r['seq'], r['ts'], r['frame_seq']] + list(r['ch']) + \
+           ['%.5g' % v for v in r['idx']] + list(r['health']) + \
+           [r['gain'], r['atime'], r['astep'], r['agc_idx'], r['saturated'],
+            r['settle'], '%.3f' % r['peak'], r['mains_hz']]
+    return ','.join(str(v) for v in vals)
+
+
+def main():
+    args = sys.argv[1:]
+    opts = {}
+    for flag in ('--csv', '--bin', '--file'):
+        if flag in args:
+            i = args.index(flag)
+            opts[flag] = args[i + 1]
+            del args[i:i + 2]
+
+    if '--file' in opts:
+        with open(opts['--file'], 'rb') as fh:
+            data = fh.read()
+    else:
+        port = args[0] if args else 'COM13'
+        baud = int(args[1]) if len(args) > 1 else 115200
+        data = read_serial(port, baud)
+        if '--bin' in opts:
+            with open(opts['--bin'], 'wb') as fh:
+                fh.write(data)
+
+    records, corrupt = decode_log(data)
+    out = open(opts['--csv'], 'w') if '--csv' in opts else sys.stdout
+    out.write(csv_header() + '\n')
+    for r in records:
+        out.write(csv_row(r) + '\n')
+    if out is not sys.stdout:
+        out.close()
+
+    gaps = sum(1 for a, b in zip(records, records[1:]) if b['seq'] != a['seq'] + 1)
+    span = (records[-1]['ts'] - records[0]['ts']) / 1000.0 if records else 0.0
+    sys.stderr.write('\n=== %d records over %.0f s, %d corrupt, %d seq gaps ===\n'
+                     % (len(records), span, corrupt, gaps))
+
+
+if __name__ == '__main__':
+    main()
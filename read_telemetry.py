@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+Decode binary telemetry frames (TELEMETRY_BINARY mode, include/telemetry.h)
+
+Usage:
+    python read_telemetry.py [PORT] [BAUD] [--csv out.csv]
+    python read_telemetry.py --file capture.bin [--csv out.csv]
+
+Frames are resynchronised on the 0xAA 0x55 sync word and CRC-16/MODBUS,
+so boot text or a dropped byte only costs the frame it lands in.
+"""
+import struct
+import sys
+import time
+
+SYNC = b'\xAA\x55'
+VERSION = 1
+NUM_CHANNELS = 13
+NUM_INDICES = 8
+
+# Must match struct TelemetryFrame (packed, little-endian)
+FRAME_FMT = '<2sBBII%dH%df4BBBH' % (NUM_CHANNELS, NUM_INDICES)
+FRAME_LEN = struct.calcsize(FRAME_FMT)  # 78
+
+CHANNEL_NAMES = ['405', '425', '450', '475', '515', '550', '555',
+                 '600', '640', '690', '745', '855', 'CLR']
+INDEX_NAMES = ['ndvi', 'chlorophyll', 'anthocyanin', 'water_stress',
+               'red_far_red', 'photosyn', 'carotenoid', 'flicker']
+HEALTH_NAMES = ['vigor', 'chlor', 'stress', 'water']
+
+
+def crc16_modbus(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def decode_frame(raw):
+    """Return a dict for one FRAME_LEN-byte frame, or None if invalid."""
+    fields = struct.unpack(FRAME_FMT, raw)
+    if fields[1] != VERSION or fields[2] != FRAME_LEN:
+        return None
+    if crc16_modbus(raw[:-2]) != fields[-1]:
+        return None
+
+    pos = 3
+    seq, ts = fields[pos], fields[pos + 1]
+    pos += 2
+    ch = fields[pos:pos + NUM_CHANNELS]
+    pos += NUM_CHANNELS
+    idx = fields[pos:pos + NUM_INDICES]
+    pos += NUM_INDICES
+    health = fields[pos:pos + 4]
+    pos += 4
+    gain, atime = fields[pos], fields[pos + 1]
+    return {'seq': seq, 'ts': ts, 'ch': ch, 'idx': idx,
+            'health': health, 'gain': gain, 'atime': atime}
+
+
+class FrameDecoder:
+    """Incremental decoder - feed() arbitrary chunks, get frames back."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.frames = 0
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buf.extend(data)
+        out = []
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                del self.buf[:-1]          # Keep a possible half sync word
+                return out
+            if len(self.buf) - start < FRAME_LEN:
+                del self.buf[:start]
+                return out
+            frame = decode_frame(bytes(self.buf[start:start + FRAME_LEN]))
+            if frame is None:
+                self.crc_errors += 1
+                del self.buf[:start + 1]   # False sync - resync one byte later
+                continue
+            out.append(frame)
+            self.frames += 1
+            del self.buf[:start + FRAME_LEN]
+
+
+def csv_header():
+    return ','.join(['seq', 'ts_ms'] + CHANNEL_NAMES + INDEX_NAMES +
+                    HEALTH_NAMES + ['gain', 'atime'])
+
+
+def csv_row(f):
+    vals = [f['seq'], f['ts']] + list(f['ch']) + \
+           ['%.5g' % v for v in f['idx']] + list(f['health']) + \
+           [f['gain'], f['atime']]
+    return ','.join(str(v) for v in vals)
+
+
+def main():
+    args = sys.argv[1:]
+    csv_path = None
+    if '--csv' in args:
+        i = args.index('--csv')
+        csv_path = args[i + 1]
+        del args[i:i + 2]
+
+    csv_out = open(csv_path, 'w') if csv_path else None
+    if csv_out:
+        csv_out.write(csv_header() + '\n')
+
+    dec = FrameDecoder()
+    last_seq = None
+    gaps = 0
+    start = time.time()
+
+    def handle(frames):
+        nonlocal last_seq, gaps
+        for f in frames:
+            if last_seq is not None and f['seq'] != last_seq + 1:
+                gaps += 1
+            last_seq = f['seq']
+            if csv_out:
+                csv_out.write(csv_row(f) + '\n')
+            else:
+                print(csv_row(f))
+
+    try:
+        if args and args[0] == '--file':
+            with open(args[1], 'rb') as fh:
+                handle(dec.feed(fh.read()))
+        else:
+            import serial
+            port = args[0] if args else 'COM13'
+            baud = int(args[1]) if len(args) > 1 else 115200
+            ser = serial.Serial(port, baud, timeout=0.1)
+            ser.reset_input_buffer()
+            if not csv_out:
+                print(csv_header())
+            while True:
+                handle(dec.feed(ser.read(4096)))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if csv_out:
+            csv_out.close()
+        elapsed = max(time.time() - start, 1e-3)
+        sys.stderr.write('\n=== %d frames (%.1f/s), %d CRC errors, %d seq gaps ===\n'
+                         % (dec.frames, dec.frames / elapsed, dec.crc_errors, gaps))
+
+
+if __name__ == '__main__':
+    main()
@@ -4,25 +4,51 @@
 #include <Adafruit_SSD1306.h>
 #include "lora_config.h"
 #include "lora_functions.h"
+#include "i2c_bus.h"
 #include "oled_display.h"
 #include "hardware_init.h"
 #include "as7343_sensor.h"
+#include "as7343_agc.h"
+#include "as7343_flicker.h"
 #include "spectral_analysis.h"
+#include "spectral_reconstruct.h"
+#include "spectral_stats.h"
+#include "spectral_codec.h"
+#include "telemetry.h"
+#include "lora_rx_queue.h"
+#include "msg_dedup.h"
+#include "node_table.h"
+#include "boot_profiler.h"
+#include "duty_cycle.h"
+#include "report_policy.h"
+#include "pipeline_stages.h"
+#include "framelog.h"
+#include "as7343_array.h"
+#include "pipeline_profiler.h"
+#include "deferred_log.h"
+#include "espnow_control.h"
+#include "ad7343_sensor.h"
+#include "mqtt_uplink.h"
+#include "web_stream.h"
 
 // ===== GLOBAL OBJECT DEFINITIONS =====
-RH_RF95 rf95(LORA_SS, LORA_DIO0);  // Chip select and interrupt pins
+LoraRadio rf95(LORA_SS, LORA_DIO0);  // Chip select and interrupt pins
 RHReliableDatagram manager(rf95, GATEWAY_ADDRESS);
-Adafruit_SSD1306 display(128, 64, &Wire, -1);
+Adafruit_SSD1306 display(128, 64, &Wire, -1, I2C_BUS_FREQ, I2C_BUS_FREQ);  // Keep the bus in fast mode
+WiFiClient espClient;
+PubSubClient mqttClient(espClient);
+WebServer server(80);
+SystemStatus sysStatus;
+Config config;
 
 // ===== CONFIGURATION =====
-#define UPDATE_INTERVAL      1000  // Update display every 1 second
-#define LORA_CHECK_INTERVAL  100   // Check LoRa every 100ms
-#define SENSOR_READ_INTERVAL 500   // Read sensor every 500ms
+#define UPDATE_INTERVAL      250   // Update display every 250ms (only changed fields are sent)
+#define ENABLE_LORA_RX       1     // Interrupt-driven gateway receive path
+#define SENSOR_PRINT_INTERVAL 500  // Print sensor report every 500ms (frames are processed as they arrive)
 
 // ===== GLOBAL VARIABLES =====
 uint32_t last_update_time = 0;
-uint32_t last_lora_check = 0;
-uint32_t last_sensor_read = 0;
+uint32_t last_sensor_print = 0;
 uint8_t msg_count = 0;
 int16_t last_rssi = 0;
 char last_message[64] = "";
@@ -30,13 +56,32 @@ uint8_t last_msg_len = 0;
 uint32_t last_rx_time = 0;
 
 // ===== FUNCTION DECLARATIONS =====
-void display_status(void);
+void display_status(const float* indices, float clear, const HealthLevels& levels);
 void check_lora_rx(void);
+void handle_serial_command(void);
+void run_serial_command(char cmd);
+void poll_sensor_array(uint32_t current_time);
+#if PIPELINE_ACTIVE
+void display_pipeline_frame(const PipelineDisplay* d);
+void pipeline_net_poll(void);
+#endif
+#if WIFI_GATEWAY_ENABLED
+void wifi_gateway_poll(void);
+#endif
 
 // ===== SETUP =====
 void setup() {
+  telemetry_init();                         // UART TX ring - must precede Serial.begin()
   Serial.begin(115200);
-  delay(2000);
+  dlog_init();                              // Log formatter task (DLOG_* output)
+  if (duty_cycle_resume()) {                // Timer wake: state is in RTC memory
+    duty_cycle_wake_init();
+    spectral_recon_init();                  // Matrix is too large for RTC memory: reload
+    spectral_stats_init();
+    return;
+  }
+  BOOT_DELAY(2000);                         // Time to attach the serial monitor
+  boot_stage("Serial");
   
   Serial.println("\n\n\n============================================");
   Serial.println("   ESP32 LoRa + OLED + AS7343 SPECTRAL   ");
@@ -49,12 +94,22 @@ void setup() {
   init_spi();
   init_gpio();
   init_lora_gpio();
+  boot_stage("I2C/SPI/GPIO");
+  
+#if FAST_START && !AS7343_ARRAY_ENABLED
+  // Start the first integration now - radio and display come up while it runs
+  init_as7343();
+  as7343_flicker_init();
+  boot_stage("AS7343");
+#endif
   
   // Initialize OLED Display
   if (!init_oled()) {
     Serial.println("[ERROR] OLED initialization failed!");
     while (1);
   }
+  duty_cycle_oled_on = true;
+  boot_stage("OLED");
   
   // Initialize LoRa Radio
   if (!rf95.init()) {
@@ -62,189 +117,380 @@ void setup() {
     while (1);
   }
   configure_lora();
+#if ENABLE_LORA_RX
+  node_table_init();                        // Per-node history rings in PSRAM
+  lora_rx_init();                           // DIO0 -> RX task -> packet pool
+#endif
+  boot_stage("LoRa");
+#if WIFI_GATEWAY_ENABLED
+  init_wifi_sta();                          // Background connect, driven by wifi_gateway_poll()
+  mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
+  uplink_init();                            // Node reports -> batched MQTT (task on core 0)
+  pipe_frame_hook = web_stream_frame;       // Every output frame to the stream subscribers
+  boot_stage("WiFi/Uplink");
+#endif
   
+#if AS7343_ARRAY_ENABLED
+  as7343_array_init();                      // Sensors behind the TCA9548A mux
+  boot_stage("AS7343 array");
+#elif !FAST_START
   // Initialize AS7343 Spectral Sensor
   Serial.println("\n[SETUP] About to init AS7343...");
   Serial.flush();
   init_as7343();
+  as7343_flicker_init();
   Serial.println("[SETUP] AS7343 init complete.");
   Serial.flush();
+  boot_stage("AS7343");
+#endif
+  spectral_calibration_load();              // Reuse stored dark/white references
+  spectral_recon_init();                    // Measured or sensor-model spectrum matrix
+  spectral_stats_init();
+  report_policy_init();                     // Deadband / heartbeat reporting
+  boot_stage("Calibration");
+  framelog_init();                          // Resume the flash frame log
+  boot_stage("Frame log");
+#if AD7343_ENABLED
+  ad7343_acq_start(AD7343_SAMPLE_RATE_HZ);  // Timer-paced DMA sampling on HSPI
+  boot_stage("AD7343");
+#endif
+#if ESPNOW_CONTROL_ROLE
+  espnow_control_init();                    // Fixed-rate converter control on core 0
+  boot_stage("ESP-NOW");
+#endif
+  prof_init();                              // Per-stage cycle profiling ('P')
+  prof_register_task("loop", NULL);
+#if ENABLE_LORA_RX
+  prof_register_task("lora_rx", lora_rx_task_handle);
+#endif
+#if ESPNOW_CONTROL_ROLE
+  prof_register_task("espnow_ctl", espnow_task_handle);
+#endif
+#if AD7343_ENABLED
+  prof_register_task("ad7343_acq", ad7343_acq_task_handle);
+#endif
+#if PIPELINE_ACTIVE
+  pipeline_start(display_pipeline_frame, pipeline_net_poll, run_serial_command);  // Stage tasks take over from loop()
+  boot_stage("Pipeline");
+#endif
   
   Serial.println("System ready!");
-  display.clearDisplay();
-  display.setCursor(0, 0);
-  display.println("LoRa+OLED Ready");
-  display.display();
+#if !FAST_START
+  oled_show_message("LoRa+OLED Ready");
+#endif
+  boot_stage("Ready");
+  print_boot_profile();
   
   last_update_time = millis();
-  last_lora_check = millis();
 }
 
 // ===== MAIN LOOP =====
+// With the pipeline running, frames are processed by the stage tasks and
+// loop() only serves the console
 void loop() {
+#if PIPELINE_ACTIVE
+  handle_serial_command();
+  delay(20);
+#else
   uint32_t current_time = millis();
+  uint32_t loop_start = prof_loop_begin();
+  uint32_t t = loop_start;
   
-  // Check for incoming LoRa messages (PAUSED)
-  // if (current_time - last_lora_check >= LORA_CHECK_INTERVAL) {
-  //   check_lora_rx();
-  //   last_lora_check = current_time;
-  // }
-  
-  // Read sensor data and calculate spectral indices
-  if (current_time - last_sensor_read >= SENSOR_READ_INTERVAL) {
-    read_as7343();
-    apply_spectral_calibration();           // Apply dark/white balance
-    calculate_all_indices();                // Calculate vegetation indices
-    calculate_health_levels();              // Calculate 0-5 health levels
-    print_as7343_data();
-    print_vegetation_indices();
-    print_health_description();             // Print health levels 0-5
-    last_sensor_read = current_time;
+#if ENABLE_LORA_RX
+  check_lora_rx();                          // Drain packets queued by the RX task
+  t = prof_lap(PROF_LORA_RX, t);
+#endif
+  
+  handle_serial_command();
+  
+  // Process each fresh sensor frame as soon as the AS7343 signals data-ready
+  // (same stage functions as the pipeline tasks, run back to back)
+  static PipelineFrame frame;
+  if (pipeline_acquire(&frame)) {
+    pipeline_output(&frame);
+    prof_frame_end(frame.start_cycles, frame.frame.interval_ms);
+    
+    duty_cycle_after_frame();               // Duty-cycle mode: report and deep sleep
   }
+#if AS7343_ARRAY_ENABLED
+  poll_sensor_array(current_time);
+#endif
+  duty_cycle_poll();
   
-  // Update display
-  if (current_time - last_update_time >= UPDATE_INTERVAL) {
-    display_status();
+  // Update display (left off on duty-cycle wakes)
+  if (!duty_cycle_woke && current_time - last_update_time >= UPDATE_INTERVAL) {
+    t = prof_now();
+    display_status(spectral_indices, spectral_ch[CH_CLEAR], health_levels);
+    t = prof_lap(PROF_DISPLAY, t);
     last_update_time = current_time;
   }
+  prof_poll();                              // Periodic stats packet (PROF_REPORT_LORA)
+#if WIFI_GATEWAY_ENABLED
+  wifi_gateway_poll();
+#endif
+  prof_loop_end(loop_start);
+  
+  t = prof_now();
+  delay(1);
+  prof_lap(PROF_IDLE, t);
+#endif
+}
+
+#if PIPELINE_ACTIVE
+// ===== PIPELINE HOOKS (core 0) =====
+void display_pipeline_frame(const PipelineDisplay* d) {
+  display_status(d->indices, d->clear, d->health);
+}
+
+void pipeline_net_poll(void) {
+#if ENABLE_LORA_RX
+  uint32_t t = prof_now();
+  check_lora_rx();                          // Drain packets queued by the RX task
+  prof_lap(PROF_LORA_RX, t);
+#endif
+  prof_poll();                              // Periodic stats packet (PROF_REPORT_LORA)
+#if WIFI_GATEWAY_ENABLED
+  wifi_gateway_poll();
+#endif
+}
+#endif
+
+#if WIFI_GATEWAY_ENABLED
+// ===== WIFI GATEWAY (core 0 with the pipeline, else loop()) =====
+void wifi_gateway_poll(void) {
+  wifi_manager_poll();                      // Reconnect, backoff, AP cache
+  if (sysStatus.wifi_connected) web_stream_init();  // No-op once listening
+  web_stream_poll();
+}
+#endif
+
+// ===== SERIAL COMMANDS =====
+// D = dark reference, W = white reference, X = clear stored calibration,
+// B = packet kernel benchmark, N = node table, L = export frame log,
+// F = frame log stats, P = pipeline profile (resets the window) + stage queues + log stats,
+// A = sensor array stats, C = ESP-NOW control status, E = reset latched node faults,
+// V = ADC ripple stats, R = report policy stats, S = reconstructed spectrum + red-edge features,
+// U = MQTT uplink stats
+// With the pipeline running, commands on core-1 state (calibration, frame
+// log, spectrum, profile) are run by the acquisition task between frames;
+// L holds acquisition until the export is done. Node table and report
+// policy commands run on the output task, which updates them.
+#define SERIAL_ACQ_COMMANDS    "DWXLFSP"
+#define SERIAL_OUTPUT_COMMANDS "NR"
+
+void handle_serial_command(void) {
+  while (Serial.available() > 0) {
+    char cmd = (char)Serial.read();
+#if PIPELINE_ACTIVE
+    if (cmd && strchr(SERIAL_ACQ_COMMANDS, toupper(cmd))) {
+      if (!pipeline_post_command(cmd)) Serial.println("[PIPE] Command queue full");
+      continue;
+    }
+    if (cmd && strchr(SERIAL_OUTPUT_COMMANDS, toupper(cmd))) {
+      if (!pipeline_post_output_command(cmd)) Serial.println("[PIPE] Command queue full");
+      continue;
+    }
+#endif
+    run_serial_command(cmd);
+  }
+}
+
+void run_serial_command(char cmd) {
+  switch (cmd) {
+    case 'D': case 'd': spectral_dark_calibration(); break;
+    case 'W': case 'w': spectral_white_balance_calibration(); break;
+    case 'X': case 'x': spectral_calibration_clear(); break;
+    case 'B': case 'b': lora_packet_benchmark(); break;
+    case 'N': case 'n': print_node_table(); break;
+    case 'L': case 'l': framelog_export(Serial); break;
+    case 'F': case 'f': print_framelog_stats(); break;
+    case 'A': case 'a': print_as7343_array_stats(); break;
+    case 'C': case 'c': print_espnow_control_status(); break;
+    case 'E': case 'e': espnow_master_request_reset(ESPNOW_BROADCAST_ID); break;
+    case 'V': case 'v': print_ad7343_acq_stats(); break;
+    case 'R': case 'r': print_report_policy_stats(); break;
+    case 'U': case 'u': print_uplink_stats(); break;
+    case 'S': case 's': print_spectrum(); break;
+    case 'P': case 'p': print_pipeline_profile(); prof_reset_window(); print_pipeline_stats(); print_dlog_stats(); break;
+    default: break;
+  }
+}
+
+// ===== SENSOR ARRAY =====
+// Round-robin acquisition runs in as7343_array_poll(); every frame of one
+// round per SENSOR_PRINT_INTERVAL is printed
+void poll_sensor_array(uint32_t current_time) {
+  static uint32_t print_round = 0;
+  AS7343ArrayFrame frame;
   
-  delay(10);
+  as7343_array_poll();
+  while (as7343_array_frames.pop(&frame)) {
+    if (frame.round != print_round && current_time - last_sensor_print >= SENSOR_PRINT_INTERVAL) {
+      print_round = frame.round;
+      last_sensor_print = current_time;
+    }
+    if (frame.round == print_round) print_as7343_array_frame(&frame);
+  }
 }
 
-// ===== CHECK FOR INCOMING LORA MESSAGES (PAUSED) =====
-// Disabled to focus on spectral analysis
-/*
+// ===== CHECK FOR INCOMING LORA MESSAGES =====
+// Packets arrive already CRC-checked and decrypted in their pool slot
 void check_lora_rx(void) {
-  if (rf95.available()) {
-    uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
-    uint8_t len = sizeof(buf);
+  LoraRxPacket* pkt;
+  
+  while ((pkt = lora_rx_receive()) != NULL) {
+    last_rssi = pkt->rssi;
+    last_rx_time = pkt->timestamp_ms;
+    last_msg_len = pkt->len;
     
-    if (rf95.recv(buf, &len)) {
-      last_rssi = rf95.lastRssi();
-      last_rx_time = millis();
+    DLOG_INFO("[LoRa RX] From: %u | Len: %u | RSSI: %d", pkt->from, pkt->len, pkt->rssi);
+    
+    if (pkt->status != LORA_PKT_CRC_FAIL) {
+      // Reports carry a 16-bit sequence; anything else falls back to the RadioHead id
+      uint8_t node = pkt->from;
+      uint16_t seq = pkt->id;
+      uint8_t space = DEDUP_SPACE_RH_ID;
+      if (pkt->status == LORA_PKT_OK && spectral_report_peek(pkt->data, pkt->len, &node, &seq)) {
+        space = DEDUP_SPACE_REPORT;
+      }
+      if (msg_dedup_seq_check(space, node, seq)) {
+        DLOG_INFO("[DUPLICATE] Dropped");
+        lora_rx_release(pkt);
+        continue;
+      }
       
-      // Check if message has CRC (at least 3 bytes: encrypted data + 2 bytes CRC)
-      if (len >= 3) {
-        // Extract CRC from last 2 bytes
-        uint16_t rxCrc = ((uint16_t)buf[len - 2] << 8) | buf[len - 1];
-        uint8_t encLen = len - 2;  // Encrypted data length (without CRC)
-        
-        // Calculate CRC of encrypted data
-        uint16_t calcCrc = calculateCRC16(buf, encLen);
-        
-        Serial.print("[LoRa RX] Len: ");
-        Serial.print(len);
-        Serial.print(" | RSSI: ");
-        Serial.print(last_rssi);
-        Serial.print(" | CRC RX: 0x");
-        Serial.print(rxCrc, HEX);
-        Serial.print(" CALC: 0x");
-        Serial.println(calcCrc, HEX);
-        
-        if (rxCrc == calcCrc) {
-          // CRC valid - decrypt
-          String decrypted = xor_decrypt_str(buf, encLen);
-          strncpy(last_message, decrypted.c_str(), sizeof(last_message) - 1);
-          last_message[sizeof(last_message) - 1] = '\0';
-          last_msg_len = encLen;
-          
-          Serial.print("[DECRYPTED] ");
-          Serial.println(last_message);
-        } else {
-          // CRC failed - show as hex
-          snprintf(last_message, sizeof(last_message), "CRC ERR");
-          last_msg_len = encLen;
-          Serial.println("[CRC FAILED]");
-        }
-      } else {
-        // Short message - treat as plain text
-        memset(last_message, 0, sizeof(last_message));
-        for (uint8_t i = 0; i < len && i < sizeof(last_message) - 1; i++) {
-          if (buf[i] >= 32 && buf[i] <= 126) {
-            last_message[i] = (char)buf[i];
-          } else {
-            last_message[i] = '.';
-          }
+      // Update the node record in place (relayed if the origin is not the sender).
+      // Only text payloads carry readings; spectral reports and profiler
+      // packets refresh the link fields but add nothing to the history.
+      NodeInfo* info = node_table_upsert(node);
+      if (info) {
+        info->rssi = pkt->rssi;
+        info->path = (node == pkt->from) ? NODE_PATH_DIRECT : NODE_PATH_RELAY;
+        info->via = (node == pkt->from) ? 0 : pkt->from;
+        info->seq = seq;
+        info->ts_recv = pkt->timestamp_ms;
+        info->ts_local = millis();
+        if (node_info_parse_readings(info, pkt->data, pkt->len) > 0) {
+          node_history_push(info - node_table.info);
+#if WIFI_GATEWAY_ENABLED
+          uplink_report_node(node, *info);  // Batched to MQTT by the uplink task
+#endif
         }
-        last_msg_len = len;
-        Serial.print("[Plain text] ");
-        Serial.println(last_message);
       }
-      
-      msg_count++;
-      
+    }
+    
+    if (pkt->status == LORA_PKT_CRC_FAIL) {
+      snprintf(last_message, sizeof(last_message), "CRC ERR");
+      DLOG_WARN("[CRC FAILED] From %u", pkt->from);
+    } else if (pkt->status == LORA_PKT_OK && prof_print_packet(pkt->data, pkt->len)) {
+      snprintf(last_message, sizeof(last_message), "PROF node %u", pkt->data[2]);
     } else {
-      Serial.println("[LoRa] RX Failed");
+      // Printable copy for the display / log
+      uint8_t n = (pkt->len < sizeof(last_message) - 1) ? pkt->len : sizeof(last_message) - 1;
+      for (uint8_t i = 0; i < n; i++) {
+        last_message[i] = (pkt->data[i] >= 32 && pkt->data[i] <= 126) ? (char)pkt->data[i] : '.';
+      }
+      last_message[n] = '\0';
+      Serial.print(pkt->status == LORA_PKT_OK ? "[DECRYPTED] " : "[Plain text] ");
+      Serial.println(last_message);
     }
+    
+    msg_count++;
+    lora_rx_release(pkt);
   }
 }
-*/
 
 // ===== DISPLAY STATUS =====
-void display_status(void) {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
+// Static labels are drawn once per screen switch; each value is an
+// OledField that is only re-rendered when its formatted text changes,
+// and oled_flush() then sends just the touched columns.
+enum StatusField {
+  SF_NDVI, SF_CLEAR, SF_CHLOR, SF_ANTH, SF_WATER, SF_RFR, SF_PHOTO, SF_CAR,
+  SF_VIGOR, SF_CHL_LVL, SF_STRESS, SF_WATER_LVL, SF_STATUS, SF_COUNT
+};
+
+// Positions in 6x8 character cells: x = col * 6
+OledField status_fields[SF_COUNT] = {
+  {  5 * 6, 10, 5, ""},   // NDVI
+  { 16 * 6, 10, 5, ""},   // Clear
+  {  6 * 6, 19, 5, ""},   // Chlor
+  { 16 * 6, 19, 5, ""},   // Anth
+  {  6 * 6, 28, 5, ""},   // Water
+  { 16 * 6, 28, 5, ""},   // R:FR
+  {  6 * 6, 37, 5, ""},   // Photo
+  { 15 * 6, 37, 6, ""},   // Car
+  {  7 * 6, 48, 1, ""},   // Health V
+  { 11 * 6, 48, 1, ""},   // Health C
+  { 15 * 6, 48, 1, ""},   // Health S
+  { 19 * 6, 48, 1, ""},   // Health W
+  {  8 * 6, 56, 9, ""},   // Status
+};
+
+void display_status_layout(void) {
+  oled_begin_screen(OLED_SCREEN_STATUS);
   
   // ===== HEADER =====
   display.setCursor(0, 0);
-  display.println("=== SPECTRAL ANALYSIS ===");
-  
-  // ===== ROW 1: NDVI + Clear =====
-  display.setCursor(0, 10);
-  display.print("NDVI:");
-  display.print(spectral_indices[IDX_NDVI], 2);
-  display.print("  ");
-  display.print("Clear:");
-  display.println((int)spectral_ch[CH_CLEAR]);
-  
-  // ===== ROW 2: Chlorophyll + Anthocyanin =====
-  display.setCursor(0, 19);
-  display.print("Chlor:");
-  display.print(spectral_indices[IDX_CHLOROPHYLL], 2);
-  display.print(" ");
-  display.print("Anth:");
-  display.println(spectral_indices[IDX_ANTHOCYANIN], 2);
-  
-  // ===== ROW 3: Water + Red:FarRed =====
-  display.setCursor(0, 28);
-  display.print("Water:");
-  display.print(spectral_indices[IDX_WATER_STRESS], 2);
-  display.print(" ");
-  display.print("R:FR:");
-  display.println(spectral_indices[IDX_RED_FAR_RED], 2);
-  
-  // ===== ROW 4: Photosyn + Carotenoid =====
-  display.setCursor(0, 37);
-  display.print("Photo:");
-  display.print(spectral_indices[IDX_PHOTOSYN], 2);
-  display.print(" ");
-  display.print("Car:");
-  display.println(spectral_indices[IDX_CAROTENOID], 2);
+  display.print("=SPECTRAL ANALYSIS=");
+  
+  // ===== ROWS 1-4: INDEX LABELS =====
+  display.setCursor(0, 10);  display.print("NDVI:");
+  display.setCursor(60, 10); display.print("Clear:");
+  display.setCursor(0, 19);  display.print("Chlor:");
+  display.setCursor(66, 19); display.print("Anth:");
+  display.setCursor(0, 28);  display.print("Water:");
+  display.setCursor(66, 28); display.print("R:FR:");
+  display.setCursor(0, 37);  display.print("Photo:");
+  display.setCursor(66, 37); display.print("Car:");
   
   // ===== SEPARATOR =====
-  display.drawLine(0, 46, 128, 46, SSD1306_WHITE);
-  
-  // ===== ROW 5: HEALTH LEVELS =====
-  display.setCursor(0, 50);
-  display.print("Health:");
-  display.print("V:");
-  display.print(health_levels.vigor);
-  display.print(" C:");
-  display.print(health_levels.chlorophyll);
-  display.print(" S:");
-  display.print(health_levels.stress);
-  display.print(" W:");
-  display.println(health_levels.water);
-  
-  // ===== ROW 6: STATUS =====
-  display.setCursor(0, 59);
-  display.print("Status: ");
-  if (as7343_ready) {
-    display.println("OK");
+  display.drawLine(0, 46, 127, 46, SSD1306_WHITE);
+  
+  // ===== ROW 5: HEALTH LABELS =====
+  display.setCursor(0, 48);
+  display.print("Hlth V:  C:  S:  W:");
+  
+  // ===== ROW 6: STATUS LABEL =====
+  display.setCursor(0, 56);
+  display.print("Status:");
+  
+  for (int i = 0; i < SF_COUNT; i++) {
+    oled_field_invalidate(&status_fields[i]);
+  }
+}
+
+void display_status(const float* indices, float clear, const HealthLevels& levels) {
+  char buf[12];
+  
+  if (oled_active_screen != OLED_SCREEN_STATUS) {
+    display_status_layout();                // A helper screen replaced the layout
+  }
+  
+  const uint8_t index_fields[] = {SF_NDVI, SF_CHLOR, SF_ANTH, SF_WATER, SF_RFR, SF_PHOTO, SF_CAR};
+  const uint8_t index_slots[] = {IDX_NDVI, IDX_CHLOROPHYLL, IDX_ANTHOCYANIN, IDX_WATER_STRESS,
+                                 IDX_RED_FAR_RED, IDX_PHOTOSYN, IDX_CAROTENOID};
+  for (int i = 0; i < 7; i++) {
+    snprintf(buf, sizeof(buf), "%.2f", indices[index_slots[i]]);
+    oled_field_update(&status_fields[index_fields[i]], buf);
+  }
+  
+  snprintf(buf, sizeof(buf), "%d", (int)clear);
+  oled_field_update(&status_fields[SF_CLEAR], buf);
+  
+  const uint8_t level_values[] = {levels.vigor, levels.chlorophyll, levels.stress, levels.water};
+  for (int i = 0; i < 4; i++) {
+    snprintf(buf, sizeof(buf), "%u", level_values[i]);
+    oled_field_update(&status_fields[SF_VIGOR + i], buf);
+  }
+  
+  if (!as7343_ready) {
+    oled_field_update(&status_fields[SF_STATUS], "NO SENSOR");
+  } else if (as7343_mains_hz) {
+    snprintf(buf, sizeof(buf), "OK %uHz", as7343_mains_hz);
+    oled_field_update(&status_fields[SF_STATUS], buf);
   } else {
-    display.println("NO SENSOR");
+    oled_field_update(&status_fields[SF_STATUS], "OK");
   }
   
-  display.display();
-}
\ No newline at end of file
+  oled_flush();
+}